@@ -7,6 +7,9 @@
 #include <stdbool.h>
 #include <time.h>
 #include <signal.h>
+#include <stdint.h>
+#include <poll.h>
+#include <sys/eventfd.h>
 
 #include "prf_system.h"
 
@@ -18,17 +21,47 @@
 #define PRF_DEF_THREAD_NAME     "prf_thread"
 #define PRF_DEF_INTERVAL_S      3
 #define PRF_DEF_INTERVAL_MS     0
+#define PRF_DEF_INTERVAL_MIN_MS 0
+#define PRF_DEF_INTERVAL_MAX_MS 0
 #define PRF_DEF_CPU_NAME       "cpu"
 #define PRF_DEF_CPU_LOAD_TYPE   5
 #define PRF_DEF_CPU_THRESHOLD   0.70
+#define PRF_DEF_CPU_HYSTERESIS  0.05
+#define PRF_DEF_THRESHOLD_SRC   PRF_THRESHOLD_LOAD_AVG
 #define PRF_DEF_NET_ITF_NAME    "wlp2s0"
+#define PRF_DEF_NET_ITF_INCL    ""
+#define PRF_DEF_NET_ITF_EXCL    "lo"
+#define PRF_DEF_DISK_INCL       ""
+#define PRF_DEF_DISK_EXCL       "loop*,ram*"
+#define PRF_DEF_PID_WATCH       ""
+#define PRF_DEF_PID_DESCENDANTS false
+#define PRF_DEF_DISK_ENABLED    false
+#define PRF_DEF_VMSTAT_ENABLED  false
+#define PRF_DEF_IRQ_ENABLED     false
+#define PRF_DEF_HISTORY_LEN     1024
+#define PRF_DEF_HISTORY_EWMA_S  10.0
+#define PRF_DEF_HISTORY_WIN_S   60.0
+#define PRF_DEF_MEM_THRESHOLD   90.0
+#define PRF_DEF_MEM_HYSTERESIS  5.0
+#define PRF_DEF_LOAD_EWMA_1_S   1.0
+#define PRF_DEF_LOAD_EWMA_2_S   5.0
+#define PRF_DEF_LOAD_EWMA_3_S   30.0
+#define PRF_DEF_SHM_NAME        ""
+#define PRF_DEF_RECORD_FILE     ""
+#define PRF_DEF_RECORD_LEN      0
+#define PRF_DEF_SOURCE_ROOT     ""
+#define PRF_DEF_NET_BACKEND     PRF_NET_BACKEND_PROC
+#define PRF_DEF_SYS_BACKEND     PRF_SYS_BACKEND_PROC
+#define PRF_DEF_IO_BACKEND      PRF_IO_BACKEND_PREAD
+#define PRF_ARG_REPLAY          "replay"
 
 // for signal_handler()
-static pthread_t    prf_thread_ext;
+static prf_ctx_t*   prf_ctx;
 static void         prf_signal_handler(int signal);
-// read-write bi-directional params of the thread
+// cleared by prf_signal_handler(), ends the loop of the detached mode
 static bool         is_running              = true;
-static float        current_cpu_threshold   = 0.0;
+// written by prf_signal_handler(), wakes up the loop of the detached mode
+static int          prf_stop_fd             = -1;
 
 // config
 typedef struct config {
@@ -40,13 +73,80 @@ typedef struct config {
     char*           cpu_name;
     prf_cpu_load_t  cpu_load_type;
     float           cpu_threshold;
+    float           cpu_hysteresis;
+    prf_threshold_src_t threshold_source;
     char*           interface_name;
+    char*           interface_include;
+    char*           interface_exclude;
+    int             history_len;
+    float           history_ewma_s;
+    char*           disk_include;
+    char*           disk_exclude;
+    char*           pid_watch;
+    bool            pid_descendants;
+    int             interval_min_ms;
+    int             interval_max_ms;
+    float           mem_threshold;
+    float           mem_hysteresis;
+    float           load_ewma_s[3];
+    char*           shm_name;
+    char*           record_file;
+    int             record_len;
+    char*           source_root;
+    prf_net_backend_t net_backend;
+    prf_sys_backend_t sys_backend;
+    prf_io_backend_t io_backend;
+    bool            disk_enabled;
+    bool            vmstat_enabled;
+    bool            irq_enabled;
 } config_t;
 
+// a line of the detached mode, the value of the threshold source <threshold>, the CPU load of the last PRF_DEF_HISTORY_WIN_S seconds
+// and the decision of <gate>
+void print_detached(prf_ctx_t* ctx, prf_gate_t* gate, float threshold, bool is_overloaded) {
+    prf_stats_t         stats;
+    prf_gate_verdict_t  verdict;
+    float               p95;
+
+    printf("== detached: %4.2f | is overloaded? %s", threshold, is_overloaded ? PRF_TRUE : PRF_FALSE);
+    if (prf_get_history_stats(ctx, PRF_METRIC_CPU_TOTAL_LOAD, PRF_DEF_HISTORY_WIN_S, &stats) &&
+        prf_get_history_percentile(ctx, PRF_METRIC_CPU_TOTAL_LOAD, PRF_DEF_HISTORY_WIN_S, 95.0, &p95)) {
+        printf(" | CPU %.0fs: mean %5.1f%%, p95 %5.1f%%", PRF_DEF_HISTORY_WIN_S, stats.mean, p95);
+    }
+    if (gate != NULL) {
+        prf_gate_check(gate, &verdict);
+        printf(" | gate: %s", verdict.admit ? "admit" : verdict.reason);
+    }
+    printf("\n");
+}
+
 bool is_line_comment(char* line, char* delim) {
     return (strncmp(delim, line, strlen(delim)) == 0);
 }
 
+// replays the recording <file> through <ctx> as fast as possible, prints the transitions of the threshold
+bool replay(prf_ctx_t* ctx, char* file) {
+    prf_snapshot_t      snapshot;
+    unsigned long       count           = 0;
+    unsigned long       overloaded      = 0;
+    bool                is_overloaded   = false;
+
+    while (is_running && prf_replay_step(ctx)) {
+        prf_get_snapshot(ctx, &snapshot);
+        if (count == 0 || snapshot.is_overloaded != is_overloaded) {
+            printf("== replay %lu: %4.2f | is overloaded? %s\n",
+                   count, snapshot.threshold, snapshot.is_overloaded ? PRF_TRUE : PRF_FALSE);
+        }
+        is_overloaded  = snapshot.is_overloaded;
+        overloaded    += is_overloaded;
+        count++;
+    }
+
+    printf("== replay: %lu snapshots of '%s', %lu overloaded\n", count, file, overloaded);
+
+    return true;
+}
+
 bool is_equal(char* name, char* name_val) {
     return (strcmp(name, name_val) == 0);
 }
@@ -61,7 +161,32 @@ void read_config(char* file_cfg, config_t* cfg, bool debug) {
                                            "cpu_name",
                                            "cpu_load_type",
                                            "cpu_threshold",
-                                           "interface_name"};
+                                           "interface_name",
+                                           "interface_include",
+                                           "interface_exclude",
+                                           "history_len",
+                                           "history_ewma_s",
+                                           "cpu_hysteresis",
+                                           "threshold_source",
+                                           "disk_include",
+                                           "disk_exclude",
+                                           "pid_watch",
+                                           "pid_descendants",
+                                           "interval_min_ms",
+                                           "interval_max_ms",
+                                           "mem_threshold",
+                                           "mem_hysteresis",
+                                           "load_ewma_s",
+                                           "shm_name",
+                                           "record_file",
+                                           "record_len",
+                                           "source_root",
+                                           "net_backend",
+                                           "sys_backend",
+                                           "io_backend",
+                                           "disk_enabled",
+                                           "vmstat_enabled",
+                                           "irq_enabled"};
     char*       cfg_start_comment       = "#";
     char*       cfg_delim_line          = "\n";
     char*       cfg_delim_param         = "=";
@@ -110,6 +235,72 @@ void read_config(char* file_cfg, config_t* cfg, bool debug) {
                     cfg->cpu_threshold = strtof(p_value, NULL);
                 } else if (is_equal(p_name, cfg_names[8]))  {
                     cfg->interface_name = strdup(p_value);
+                } else if (is_equal(p_name, cfg_names[9]))  {
+                    cfg->interface_include = strdup(p_value);
+                } else if (is_equal(p_name, cfg_names[10]))  {
+                    cfg->interface_exclude = strdup(p_value);
+                } else if (is_equal(p_name, cfg_names[11]))  {
+                    cfg->history_len = strtol(p_value, NULL, 10);
+                } else if (is_equal(p_name, cfg_names[12]))  {
+                    cfg->history_ewma_s = strtof(p_value, NULL);
+                } else if (is_equal(p_name, cfg_names[13]))  {
+                    cfg->cpu_hysteresis = strtof(p_value, NULL);
+                } else if (is_equal(p_name, cfg_names[14]))  {
+                    if (!prf_get_threshold_source(p_value, &cfg->threshold_source)) {
+                        printf("** WARNING - invalid threshold source: '%s' - defaulted to '%s'\n",
+                               p_value, prf_get_threshold_source_name(PRF_DEF_THRESHOLD_SRC));
+                        cfg->threshold_source = PRF_DEF_THRESHOLD_SRC;
+                    }
+                } else if (is_equal(p_name, cfg_names[15]))  {
+                    cfg->disk_include = strdup(p_value);
+                } else if (is_equal(p_name, cfg_names[16]))  {
+                    cfg->disk_exclude = strdup(p_value);
+                } else if (is_equal(p_name, cfg_names[17]))  {
+                    cfg->pid_watch = strdup(p_value);
+                } else if (is_equal(p_name, cfg_names[18]))  {
+                    cfg->pid_descendants = is_equal(p_value, "true");
+                } else if (is_equal(p_name, cfg_names[19]))  {
+                    cfg->interval_min_ms = strtol(p_value, NULL, 10);
+                } else if (is_equal(p_name, cfg_names[20]))  {
+                    cfg->interval_max_ms = strtol(p_value, NULL, 10);
+                } else if (is_equal(p_name, cfg_names[21]))  {
+                    cfg->mem_threshold = strtof(p_value, NULL);
+                } else if (is_equal(p_name, cfg_names[22]))  {
+                    cfg->mem_hysteresis = strtof(p_value, NULL);
+                } else if (is_equal(p_name, cfg_names[23]))  {
+                    sscanf(p_value, "%f,%f,%f", &cfg->load_ewma_s[0], &cfg->load_ewma_s[1], &cfg->load_ewma_s[2]);
+                } else if (is_equal(p_name, cfg_names[24]))  {
+                    cfg->shm_name = strdup(p_value);
+                } else if (is_equal(p_name, cfg_names[25]))  {
+                    cfg->record_file = strdup(p_value);
+                } else if (is_equal(p_name, cfg_names[26]))  {
+                    cfg->record_len = strtol(p_value, NULL, 10);
+                } else if (is_equal(p_name, cfg_names[27]))  {
+                    cfg->source_root = strdup(p_value);
+                } else if (is_equal(p_name, cfg_names[28]))  {
+                    if (!prf_get_net_backend(p_value, &cfg->net_backend)) {
+                        printf("** WARNING - invalid network backend: '%s' - defaulted to '%s'\n",
+                               p_value, prf_get_net_backend_name(PRF_DEF_NET_BACKEND));
+                        cfg->net_backend = PRF_DEF_NET_BACKEND;
+                    }
+                } else if (is_equal(p_name, cfg_names[29]))  {
+                    if (!prf_get_sys_backend(p_value, &cfg->sys_backend)) {
+                        printf("** WARNING - invalid system backend: '%s' - defaulted to '%s'\n",
+                               p_value, prf_get_sys_backend_name(PRF_DEF_SYS_BACKEND));
+                        cfg->sys_backend = PRF_DEF_SYS_BACKEND;
+                    }
+                } else if (is_equal(p_name, cfg_names[30]))  {
+                    if (!prf_get_io_backend(p_value, &cfg->io_backend)) {
+                        printf("** WARNING - invalid I/O backend: '%s' - defaulted to '%s'\n",
+                               p_value, prf_get_io_backend_name(PRF_DEF_IO_BACKEND));
+                        cfg->io_backend = PRF_DEF_IO_BACKEND;
+                    }
+                } else if (is_equal(p_name, cfg_names[31]))  {
+                    cfg->disk_enabled = is_equal(p_value, "true");
+                } else if (is_equal(p_name, cfg_names[32]))  {
+                    cfg->vmstat_enabled = is_equal(p_value, "true");
+                } else if (is_equal(p_name, cfg_names[33]))  {
+                    cfg->irq_enabled = is_equal(p_value, "true");
                 } else {
                     printf("** WARNING - unknown config parameter: '%s' = '%s'\n", p_name, p_value);
                 }
@@ -128,7 +319,32 @@ void read_config(char* file_cfg, config_t* cfg, bool debug) {
         printf("cpu_name = %s\n", cfg->cpu_name);
         printf("cpu_load_type = %d\n", cfg->cpu_load_type);
         printf("cpu_threshold = %f4.2\n", cfg->cpu_threshold);
-        printf("interface_name = %s\n\n", cfg->interface_name);
+        printf("cpu_hysteresis = %4.2f\n", cfg->cpu_hysteresis);
+        printf("threshold_source = %s\n", prf_get_threshold_source_name(cfg->threshold_source));
+        printf("interface_name = %s\n", cfg->interface_name);
+        printf("interface_include = %s\n", cfg->interface_include);
+        printf("interface_exclude = %s\n", cfg->interface_exclude);
+        printf("history_len = %d\n", cfg->history_len);
+        printf("history_ewma_s = %4.2f\n", cfg->history_ewma_s);
+        printf("disk_include = %s\n", cfg->disk_include);
+        printf("disk_exclude = %s\n", cfg->disk_exclude);
+        printf("pid_watch = %s\n", cfg->pid_watch);
+        printf("pid_descendants = %s\n", cfg->pid_descendants ? PRF_TRUE : PRF_FALSE);
+        printf("interval_min_ms = %d\n", cfg->interval_min_ms);
+        printf("interval_max_ms = %d\n", cfg->interval_max_ms);
+        printf("mem_threshold = %4.2f\n", cfg->mem_threshold);
+        printf("mem_hysteresis = %4.2f\n", cfg->mem_hysteresis);
+        printf("load_ewma_s = %4.2f,%4.2f,%4.2f\n", cfg->load_ewma_s[0], cfg->load_ewma_s[1], cfg->load_ewma_s[2]);
+        printf("shm_name = %s\n", cfg->shm_name);
+        printf("record_file = %s\n", cfg->record_file);
+        printf("record_len = %d\n", cfg->record_len);
+        printf("source_root = %s\n", cfg->source_root);
+        printf("net_backend = %s\n", prf_get_net_backend_name(cfg->net_backend));
+        printf("sys_backend = %s\n", prf_get_sys_backend_name(cfg->sys_backend));
+        printf("io_backend = %s\n", prf_get_io_backend_name(cfg->io_backend));
+        printf("disk_enabled = %s\n", cfg->disk_enabled ? PRF_TRUE : PRF_FALSE);
+        printf("vmstat_enabled = %s\n", cfg->vmstat_enabled ? PRF_TRUE : PRF_FALSE);
+        printf("irq_enabled = %s\n\n", cfg->irq_enabled ? PRF_TRUE : PRF_FALSE);
     }
 }
 
@@ -143,14 +359,42 @@ int main(int argc, char** argv) {
                                                                    PRF_DEF_CPU_NAME,
                                                                    PRF_DEF_CPU_LOAD_TYPE,
                                                                    PRF_DEF_CPU_THRESHOLD,
-                                                                   PRF_DEF_NET_ITF_NAME};
-    float                       current_threshold               = 0.0;
+                                                                   PRF_DEF_CPU_HYSTERESIS,
+                                                                   PRF_DEF_THRESHOLD_SRC,
+                                                                   PRF_DEF_NET_ITF_NAME,
+                                                                   PRF_DEF_NET_ITF_INCL,
+                                                                   PRF_DEF_NET_ITF_EXCL,
+                                                                   PRF_DEF_HISTORY_LEN,
+                                                                   PRF_DEF_HISTORY_EWMA_S,
+                                                                   PRF_DEF_DISK_INCL,
+                                                                   PRF_DEF_DISK_EXCL,
+                                                                   PRF_DEF_PID_WATCH,
+                                                                   PRF_DEF_PID_DESCENDANTS,
+                                                                   PRF_DEF_INTERVAL_MIN_MS,
+                                                                   PRF_DEF_INTERVAL_MAX_MS,
+                                                                   PRF_DEF_MEM_THRESHOLD,
+                                                                   PRF_DEF_MEM_HYSTERESIS,
+                                                                   {PRF_DEF_LOAD_EWMA_1_S,
+                                                                    PRF_DEF_LOAD_EWMA_2_S,
+                                                                    PRF_DEF_LOAD_EWMA_3_S},
+                                                                   PRF_DEF_SHM_NAME,
+                                                                   PRF_DEF_RECORD_FILE,
+                                                                   PRF_DEF_RECORD_LEN,
+                                                                   PRF_DEF_SOURCE_ROOT,
+                                                                   PRF_DEF_NET_BACKEND,
+                                                                   PRF_DEF_SYS_BACKEND,
+                                                                   PRF_DEF_IO_BACKEND,
+                                                                   PRF_DEF_DISK_ENABLED,
+                                                                   PRF_DEF_VMSTAT_ENABLED,
+                                                                   PRF_DEF_IRQ_ENABLED};
+    prf_snapshot_t              snapshot;
     bool                        create_failed                   = false;
     bool                        join_failed                     = false;
     bool                        setname_failed                  = false;
     bool                        status                          = false;
+    bool                        is_replay                       = false;
     int                         delay_ms                        = 200;
-    int                         detachstate;
+    pthread_t                   prf_thread_ext;
     char*                       tail;
     pthread_attr_t              attr_perf;
     struct timespec             sleep_req;
@@ -173,77 +417,138 @@ int main(int argc, char** argv) {
 
     read_config(PRF_CONFIG_FILE, &cfg, true);
 
+    prf_stop_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+
     printf("%s\n", PRF_APP_HEADER);
 
     sleep_req.tv_sec                = (long)cfg.interval_s;
     sleep_req.tv_nsec               = (long)cfg.interval_ms * 1000000L;
 
-    param_perf.is_running           = &is_running,
     param_perf.is_debug             = cfg.is_debug,
     param_perf.is_joinable          = cfg.is_joinable,
     param_perf.thread_name          = cfg.thread_name,
     param_perf.sleep_req            = &sleep_req,
+    param_perf.interval_min_s       = (float)cfg.interval_min_ms / 1000.0,
+    param_perf.interval_max_s       = (float)cfg.interval_max_ms / 1000.0,
     param_perf.cpu_name             = cfg.cpu_name,
     param_perf.cpu_load_type        = cfg.cpu_load_type,
     param_perf.cpu_threshold        = cfg.cpu_threshold,
-    param_perf.current_threshold    = &current_threshold,
-    param_perf.interface_name       = cfg.interface_name;
-
-    pthread_attr_init(&attr_perf);
-    pthread_attr_setscope(&attr_perf, PTHREAD_SCOPE_SYSTEM);
+    param_perf.threshold_source     = cfg.threshold_source,
+    param_perf.interface_name       = cfg.interface_name,
+    param_perf.interface_include    = cfg.interface_include,
+    param_perf.interface_exclude    = cfg.interface_exclude,
+    param_perf.history_len          = cfg.history_len,
+    param_perf.history_ewma_s       = cfg.history_ewma_s,
+    param_perf.disk_enabled         = cfg.disk_enabled,
+    param_perf.disk_include         = cfg.disk_include,
+    param_perf.disk_exclude         = cfg.disk_exclude,
+    param_perf.disk_partitions      = false,
+    param_perf.pid_watch            = cfg.pid_watch,
+    param_perf.pid_descendants      = cfg.pid_descendants,
+    param_perf.load_ewma_s[0]       = cfg.load_ewma_s[0],
+    param_perf.load_ewma_s[1]       = cfg.load_ewma_s[1],
+    param_perf.load_ewma_s[2]       = cfg.load_ewma_s[2],
+    param_perf.shm_name             = cfg.shm_name,
+    param_perf.record_file          = cfg.record_file,
+    param_perf.record_len           = cfg.record_len,
+    param_perf.source_root          = cfg.source_root,
+    param_perf.net_backend          = cfg.net_backend,
+    param_perf.sys_backend          = cfg.sys_backend,
+    param_perf.io_backend           = cfg.io_backend,
+    param_perf.vmstat_enabled       = cfg.vmstat_enabled,
+    param_perf.irq_enabled          = cfg.irq_enabled,
+    param_perf.source               = NULL;
 
-    if (cfg.is_joinable) {
-        detachstate = PTHREAD_CREATE_JOINABLE;
-    } else {
-        detachstate = PTHREAD_CREATE_DETACHED;
+    // 'prf-system-app replay <file>' re-runs the threshold of the configuration over a recording
+    is_replay = (argc > 2 && is_equal(argv[1], PRF_ARG_REPLAY));
+    prf_ctx   = is_replay ? prf_replay_create(&param_perf, argv[2]) : prf_ctx_create(&param_perf);
+    if (prf_ctx == NULL) {
+        fprintf(stderr, "\n** ERROR - abnormal application termination\n");
+        return EXIT_FAILURE;
     }
 
-    pthread_attr_setdetachstate(&attr_perf, detachstate);
-    create_failed = pthread_create(&prf_thread_ext, &attr_perf, prf_perf_collect, &param_perf);
+    if (is_replay) {
+        status = replay(prf_ctx, argv[2]);
+    } else if (cfg.is_joinable) {
+        // PTHREAD_CREATE_JOINABLE: the calling thread waits for until the thread finishes
+        pthread_attr_init(&attr_perf);
+        pthread_attr_setscope(&attr_perf, PTHREAD_SCOPE_SYSTEM);
+        pthread_attr_setdetachstate(&attr_perf, PTHREAD_CREATE_JOINABLE);
+        create_failed = pthread_create(&prf_thread_ext, &attr_perf, prf_perf_collect, prf_ctx);
+        pthread_attr_destroy(&attr_perf);
 
-    if (create_failed) {
-        fprintf(stderr, "** ERROR - performance thread creation failed\n");
-        pthread_cancel(prf_thread_ext);
-    } else {
-#ifdef _GNU_SOURCE
-        setname_failed = pthread_setname_np(prf_thread_ext, cfg.thread_name);
-#else
-        setname_failed = false;
-#endif
-        if (setname_failed) {
-            pthread_cancel(prf_thread_ext);
-            fprintf(stderr, "** ERROR - performance thread could not be renamed to '%s'\n", cfg.thread_name);
+        if (create_failed) {
+            fprintf(stderr, "** ERROR - performance thread creation failed\n");
         } else {
-            if (cfg.is_joinable) {
-                // PTHREAD_CREATE_JOINABLE: the calling thread waits for until the thread finishes
-                join_failed = pthread_join(prf_thread_ext, NULL);
-                if (join_failed) {
-                    pthread_cancel(prf_thread_ext);
-                    fprintf(stderr, "** ERROR - performance thread could not be started\n");
-                } else {
-                    status = true;
-                }
+            setname_failed = pthread_setname_np(prf_thread_ext, cfg.thread_name);
+            if (setname_failed) {
+                prf_cancel_perf_thread(prf_ctx);
+                fprintf(stderr, "** ERROR - performance thread could not be renamed to '%s'\n", cfg.thread_name);
+            }
+
+            join_failed = pthread_join(prf_thread_ext, NULL);
+            if (join_failed) {
+                fprintf(stderr, "** ERROR - performance thread could not be started\n");
             } else {
-                // PTHREAD_CREATE_DETACHED: the thread runs in parallel with the calling thread
-                struct timespec delay_req = {0, delay_ms * 1000000L};
-                struct timespec wait_act;
+                status = !setname_failed;
+            }
+        }
+    } else if (prf_ctx_start(prf_ctx)) {
+        // the collector thread of the context runs in parallel with the calling thread,
+        // which sleeps until the threshold source crosses <cpu_threshold>, the memory usage crosses <mem_threshold>
+        // or a signal arrives
+        prf_sub_t       sub_overload    = {PRF_METRIC_THRESHOLD, cfg.cpu_threshold, cfg.cpu_hysteresis, NULL, NULL};
+        prf_sub_t       sub_mem         = {PRF_METRIC_MEM_USED, cfg.mem_threshold, cfg.mem_hysteresis, NULL, NULL};
+        int             sub_id          = prf_subscribe(prf_ctx, &sub_overload);
+        int             sub_mem_id      = prf_subscribe(prf_ctx, &sub_mem);
+        struct pollfd   pfds[3]         = {{prf_stop_fd, POLLIN, 0},
+                                           {prf_get_sub_fd(prf_ctx, sub_id), POLLIN, 0},
+                                           {prf_get_sub_fd(prf_ctx, sub_mem_id), POLLIN, 0}};
+        // admission control: defers while the threshold source or the memory usage is over its watermarks
+        prf_gate_cfg_t  gate_cfg        = {.mode        = PRF_GATE_ANY,
+                                           .rule_count  = 2,
+                                           .rules       = {{PRF_METRIC_THRESHOLD, cfg.cpu_threshold,
+                                                            cfg.cpu_threshold - cfg.cpu_hysteresis, 0.0, 0.0},
+                                                           {PRF_METRIC_MEM_USED, cfg.mem_threshold,
+                                                            cfg.mem_threshold - cfg.mem_hysteresis, 0.0, 0.0}}};
+        prf_gate_t*     gate            = prf_gate_create(prf_ctx, &gate_cfg);
+        struct timespec delay_req       = {0, delay_ms * 1000000L};
+        struct timespec deadline;
+        prf_event_t     event;
+        uint64_t        count;
 
-                // delay, so that initial reads are completed
-                nanosleep(&delay_req, &wait_act);
+        // delay, so that initial reads are completed
+        clock_gettime(CLOCK_MONOTONIC, &deadline);
+        prf_sleep_until(&deadline, &delay_req);
 
-                while (is_running) {
-                    nanosleep(&sleep_req, &wait_act);
-                    printf("== detached: %4.2f | is overloaded? %s\n",
-                            current_threshold, (current_threshold >= cfg.cpu_threshold) ? PRF_TRUE : PRF_FALSE);
-                }
+        if (prf_get_snapshot(prf_ctx, &snapshot)) {
+            print_detached(prf_ctx, gate, snapshot.threshold, snapshot.is_overloaded);
+        }
+
+        while (is_running) {
+            if (poll(pfds, 3, -1) <= 0) {
+                continue;
+            }
 
-                status = true;
+            if ((pfds[1].revents & POLLIN) &&
+                read(pfds[1].fd, &count, sizeof(count)) > 0 && prf_get_sub_event(prf_ctx, sub_id, &event)) {
+                print_detached(prf_ctx, gate, event.value, event.is_above);
+            }
+
+            if ((pfds[2].revents & POLLIN) && read(pfds[2].fd, &count, sizeof(count)) > 0) {
+                print_detached(prf_ctx, gate, prf_get_current_threshold(prf_ctx),
+                               prf_get_current_threshold(prf_ctx) >= cfg.cpu_threshold);
             }
         }
+
+        prf_ctx_stop(prf_ctx);
+        prf_gate_destroy(gate);
+        status = true;
     }
 
     // ATTENTION: if execution is reached here, it means that the performance thread is stopped.
-    pthread_attr_destroy(&attr_perf);
+    prf_ctx_destroy(prf_ctx);
+    close(prf_stop_fd);
 
     if (status) {
         printf("\nINFO: application successfully terminated\n");
@@ -264,7 +569,10 @@ static void prf_signal_handler(int signal) {
         case SIGTERM: /*  kill      */
         default:
             is_running = false;
-            pthread_cancel(prf_thread_ext);
+            prf_cancel_perf_thread(prf_ctx);
+            if (write(prf_stop_fd, &(uint64_t){1}, sizeof(uint64_t)) < 0) {
+                // no detached loop to wake up
+            }
             break;
     }
 }
@@ -25,6 +25,8 @@ help () {
     echo "    purge         -- call 'lib purge; app purge'"
     echo "    expunge       -- call 'clean; purge'"
     echo "    run           -- run the test executable"
+    echo "    test          -- run the library tests, 'ctest'"
+    echo "    bench         -- run the library benchmarks, 'make bench'"
     echo "    lib cmake     -- call 'cmake'"
     echo "    lib make      -- call 'make; make install'"
     echo "    lib clean     -- call 'make clean'"
@@ -108,6 +110,18 @@ run() {
     fi
 }
 
+run_tests() {
+    cd $DIR_WORK/library/build
+
+    ctest --output-on-failure
+}
+
+run_bench() {
+    cd $DIR_WORK/library/build
+
+    make bench
+}
+
 # action
 case "$ACTION" in
     "build")        build ; exit 0 ;;
@@ -115,6 +129,8 @@ case "$ACTION" in
     "purge")        purge ; exit 0 ;;
     "expunge")      expunge ; exit 0 ;;
     "run")          run ; exit 0 ;;
+    "test")         run_tests ; exit $? ;;
+    "bench")        run_bench ; exit $? ;;
     "help")         help ; exit 0 ;;
     "lib"|"app")    action "$ACTION" "$COMMAND" ; exit 0 ;;
     "")             build ; exit 0 ;;
@@ -0,0 +1,90 @@
+#ifndef _PRF_BENCH_H
+#define _PRF_BENCH_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "prf_system.h"
+
+#define PRF_BENCH_ROUNDS        5       // timed rounds, the fastest one is reported
+#define PRF_BENCH_ROUND_S       0.2     // minimal duration of a round in seconds
+
+/*
+ * returns the CLOCK_MONOTONIC time in seconds
+ */
+static inline double prf_bench_now(void) {
+    struct timespec     now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (double)now.tv_sec + (double)now.tv_nsec / 1000000000.0;
+}
+
+/*
+ * reads the fixture <path>, f.e. "/proc/stat", of the directory <dir> into a heap buffer, to be freed
+ * returns NULL if the file is missing
+ */
+static inline char* prf_bench_load(const char* dir, const char* path, long* len) {
+    char    name[512];
+    char*   buffer  = NULL;
+    long    size    = 0;
+
+    snprintf(name, sizeof(name), "%s%s", dir, path);
+    if (!prf_read_file(name, &buffer, &size)) {
+        return NULL;
+    }
+
+    *len = size - 1;
+
+    return buffer;
+}
+
+/*
+ * runs <run> with <arg> in rounds of at least PRF_BENCH_ROUND_S seconds, after one warm-up round
+ * returns the nanoseconds per run of the fastest round
+ */
+static inline double prf_bench_ns(void (*run)(void* arg), void* arg) {
+    double  best    = 0.0;
+    double  start;
+    double  elapsed;
+    long    runs    = 1;
+
+    for (int round = -1; round < PRF_BENCH_ROUNDS; round++) {
+        // the warm-up round sizes the following ones
+        do {
+            start = prf_bench_now();
+            for (long i = 0; i < runs; i++) {
+                run(arg);
+            }
+            elapsed = prf_bench_now() - start;
+            if (round < 0 && elapsed < PRF_BENCH_ROUND_S) {
+                runs *= 2;
+            }
+        } while (round < 0 && elapsed < PRF_BENCH_ROUND_S);
+
+        if (round >= 0 && (best == 0.0 || elapsed / runs < best)) {
+            best = elapsed / runs;
+        }
+    }
+
+    return best * 1000000000.0;
+}
+
+/*
+ * creates a context that resolves /proc and /sys in the directory <root>, f.e. "/" for the running system
+ */
+static inline prf_ctx_t* prf_bench_ctx_create(const char* root, prf_perf_t* perf) {
+    static struct timespec  req     = {1, 0};
+    static char             cpu[]   = "cpu";
+
+    perf->sleep_req     = &req;
+    perf->cpu_name      = cpu;
+    perf->cpu_threshold = 1.0;
+    perf->source_root   = root;
+
+    return prf_ctx_create(perf);
+}
+
+#endif
@@ -0,0 +1,127 @@
+/*
+ * ns per parse of /proc/meminfo: the single-pass perfect-hash parser against the former strtok_r()/bsearch() one
+ *
+ * usage: prf-bench-meminfo <fixtures/host512/tick0>
+ */
+#include "prf_bench.h"
+
+#define PRF_BENCH_OLD_FIELDS    24
+
+typedef struct prf_bench_mem {
+    prf_ctx_t*          ctx;
+    const char*         buffer;
+    long                len;
+    char*               copy;
+    unsigned long       values[PRF_BENCH_OLD_FIELDS];
+} prf_bench_mem_t;
+
+typedef struct prf_bench_old_field {
+    const char*         name;
+    unsigned long*      slot;
+} prf_bench_old_field_t;
+
+static int prf_bench_old_compare(const void* a, const void* b) {
+    return strcmp(((const prf_bench_old_field_t*)a)->name, ((const prf_bench_old_field_t*)b)->name);
+}
+
+/*
+ * the former parser: strtok_r() lines, a bsearch() with strcmp() over a table built on every call,
+ * strtoull() values, the buffer is copied first as strtok_r() writes into it
+ */
+static void prf_bench_old_parse(void* arg) {
+    prf_bench_mem_t*        mem     = (prf_bench_mem_t*)arg;
+    unsigned long*          v       = mem->values;
+    prf_bench_old_field_t   find_me;
+    prf_bench_old_field_t*  found;
+    prf_bench_old_field_t   table[] = {
+                                        {"Active",          &v[0]},
+                                        {"AnonPages",       &v[1]},
+                                        {"Bounce",          &v[2]},
+                                        {"Buffers",         &v[3]},
+                                        {"Cached",          &v[4]},
+                                        {"CommitLimit",     &v[5]},
+                                        {"Committed_AS",    &v[6]},
+                                        {"Dirty",           &v[7]},
+                                        {"Inactive",        &v[8]},
+                                        {"Mapped",          &v[9]},
+                                        {"MemFree",         &v[10]},
+                                        {"MemTotal",        &v[11]},
+                                        {"NFS_Unstable",    &v[12]},
+                                        {"PageTables",      &v[13]},
+                                        {"SReclaimable",    &v[14]},
+                                        {"SUnreclaim",      &v[15]},
+                                        {"Slab",            &v[16]},
+                                        {"SwapCached",      &v[17]},
+                                        {"SwapFree",        &v[18]},
+                                        {"SwapTotal",       &v[19]},
+                                        {"VmallocChunk",    &v[20]},
+                                        {"VmallocTotal",    &v[21]},
+                                        {"VmallocUsed",     &v[22]},
+                                        {"Writeback",       &v[23]}
+                                      };
+    char*                   rest    = NULL;
+    char*                   delim;
+
+    memcpy(mem->copy, mem->buffer, mem->len + 1);
+
+    for (char* line = strtok_r(mem->copy, "\n", &rest); line != NULL; line = strtok_r(NULL, "\n", &rest)) {
+        delim = strstr(line, ":");
+        if (delim == NULL) {
+            continue;
+        }
+        *delim          = '\0';
+        find_me.name    = line;
+        found           = (prf_bench_old_field_t*)bsearch(&find_me, table, sizeof(table) / sizeof(table[0]),
+                                                          sizeof(table[0]), prf_bench_old_compare);
+        if (found) {
+            *(found->slot) = strtoull(delim + 1, NULL, 10);
+        }
+    }
+}
+
+static void prf_bench_parse(void* arg) {
+    prf_bench_mem_t*    mem = (prf_bench_mem_t*)arg;
+
+    prf_parse_mem_info(mem->ctx, mem->buffer, mem->len);
+}
+
+int main(int argc, char* argv[]) {
+    prf_perf_t          perf;
+    prf_bench_mem_t     mem;
+    unsigned long       m[PRF_MEM_FIELD_COUNT];
+
+    if (argc != 2) {
+        fprintf(stderr, "usage: %s <fixtures/host512/tick0>\n", argv[0]);
+        return 2;
+    }
+
+    memset(&perf, 0, sizeof(perf));
+    memset(&mem, 0, sizeof(mem));
+    mem.ctx     = prf_bench_ctx_create(argv[1], &perf);
+    mem.buffer  = prf_bench_load(argv[1], "/proc/meminfo", &mem.len);
+    if (mem.ctx == NULL || mem.buffer == NULL || (mem.copy = (char*)malloc(mem.len + 1)) == NULL) {
+        fprintf(stderr, "** ERROR - unable to set up the benchmark\n");
+        return 1;
+    }
+
+    // both parsers agree on the fields they share
+    prf_bench_parse(&mem);
+    prf_bench_old_parse(&mem);
+    prf_get_mem_info_full(mem.ctx, m);
+    if (m[PRF_MEM_TOTAL] != mem.values[11] || m[PRF_MEM_FREE] != mem.values[10]) {
+        fprintf(stderr, "** ERROR - the parsers disagree on MemTotal or MemFree\n");
+        return 1;
+    }
+
+    printf("/proc/meminfo, %ld bytes\n", mem.len);
+    printf("  %-40s %10.1f ns/parse, %d fields\n", "single pass, perfect hash", prf_bench_ns(prf_bench_parse, &mem),
+           PRF_MEM_FIELD_COUNT);
+    printf("  %-40s %10.1f ns/parse, %d fields\n", "strtok_r, bsearch, strtoull (former)", prf_bench_ns(prf_bench_old_parse, &mem),
+           PRF_BENCH_OLD_FIELDS);
+
+    free(mem.copy);
+    free((char*)mem.buffer);
+    prf_ctx_destroy(mem.ctx);
+
+    return 0;
+}
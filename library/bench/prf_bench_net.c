@@ -0,0 +1,103 @@
+/*
+ * ns per read of the interface counters: the text of /proc/net/dev against the rtnetlink dump, on the running
+ * system, and ns per parse of the /proc/net/dev of a host with 200 interfaces
+ * dummy interfaces make the live table longer, f.e. 'ip link add dummy0 type dummy'
+ *
+ * usage: prf-bench-net <fixtures/host512> [<interface,...>]
+ */
+#include "prf_bench.h"
+
+typedef struct prf_bench_net {
+    prf_ctx_t*          ctx;
+    char*               buffers[2];         // tick0 and tick1, parsed in turn so the rates are not 0
+    long                lens[2];
+    int                 tick;
+} prf_bench_net_t;
+
+static void prf_bench_parse(void* arg) {
+    prf_bench_net_t*    net = (prf_bench_net_t*)arg;
+
+    net->tick ^= 1;
+    prf_parse_net_info(net->ctx, net->buffers[net->tick], net->lens[net->tick], NULL);
+}
+
+static void prf_bench_read(void* arg) {
+    prf_read_net_info((prf_ctx_t*)arg);
+}
+
+/*
+ * times the reads of the running system with <backend>, of the interfaces of <include>, NULL for all
+ */
+static void prf_bench_live(prf_net_backend_t backend, const char* include) {
+    prf_perf_t          perf;
+    prf_net_itf_t       itfs[PRF_NET_MAX_ITF];
+    prf_ctx_t*          ctx;
+    char                label[64];
+    double              ns;
+    int                 count;
+
+    memset(&perf, 0, sizeof(perf));
+    perf.net_backend        = backend;
+    perf.interface_name     = "lo";
+    perf.interface_include  = include;
+    ctx = prf_bench_ctx_create(NULL, &perf);
+    if (ctx == NULL || !prf_read_net_info(ctx)) {
+        fprintf(stderr, "** ERROR - unable to read the interfaces with '%s'\n", prf_get_net_backend_name(backend));
+        prf_ctx_destroy(ctx);
+        return;
+    }
+
+    ns    = prf_bench_ns(prf_bench_read, ctx);
+    count = prf_get_net_itf_all(ctx, itfs, PRF_NET_MAX_ITF);
+    snprintf(label, sizeof(label), "%s, %s", prf_get_net_backend_name(backend), (include != NULL) ? include : "all");
+    printf("  %-40s %10.1f ns/read, %d interfaces\n", label, ns, count);
+
+    prf_ctx_destroy(ctx);
+}
+
+int main(int argc, char* argv[]) {
+    prf_perf_t          perf;
+    prf_bench_net_t     net;
+    prf_net_itf_t       itfs[PRF_NET_MAX_ITF];
+    char                path[512];
+    double              ns;
+    int                 count;
+
+    if (argc != 2 && argc != 3) {
+        fprintf(stderr, "usage: %s <fixtures/host512> [<interface,...>]\n", argv[0]);
+        return 2;
+    }
+
+    memset(&perf, 0, sizeof(perf));
+    memset(&net, 0, sizeof(net));
+    snprintf(path, sizeof(path), "%s/tick0", argv[1]);
+    net.ctx        = prf_bench_ctx_create(path, &perf);
+    net.buffers[0] = prf_bench_load(path, "/proc/net/dev", &net.lens[0]);
+    snprintf(path, sizeof(path), "%s/tick1", argv[1]);
+    net.buffers[1] = prf_bench_load(path, "/proc/net/dev", &net.lens[1]);
+    if (net.ctx == NULL || net.buffers[0] == NULL || net.buffers[1] == NULL) {
+        fprintf(stderr, "** ERROR - unable to set up the benchmark\n");
+        return 1;
+    }
+
+    prf_bench_parse(&net);
+    count = prf_get_net_itf_all(net.ctx, itfs, PRF_NET_MAX_ITF);
+
+    printf("/proc/net/dev, %d interfaces, %ld bytes\n", count, net.lens[0]);
+    ns = prf_bench_ns(prf_bench_parse, &net);
+    printf("  %-40s %10.1f ns/parse, %6.1f ns/interface\n", "single pass", ns, ns / count);
+
+    printf("running system\n");
+    prf_bench_live(PRF_NET_BACKEND_PROC, NULL);
+    prf_bench_live(PRF_NET_BACKEND_NETLINK, NULL);
+    if (argc == 3) {
+        prf_bench_live(PRF_NET_BACKEND_PROC, argv[2]);
+        prf_bench_live(PRF_NET_BACKEND_NETLINK, argv[2]);
+    }
+
+    free(net.buffers[0]);
+    free(net.buffers[1]);
+    prf_ctx_destroy(net.ctx);
+
+    return 0;
+}
@@ -0,0 +1,96 @@
+/*
+ * ns per parse of the /proc/stat of a 512-core host: the single-pass parser with its SSE2 digit kernel
+ * against sscanf() per line, and the whole read of prf_read_cpu_info()
+ *
+ * usage: prf-bench-stat <fixtures/host512>
+ */
+#include "prf_bench.h"
+
+typedef struct prf_bench_stat {
+    prf_ctx_t*          ctx;
+    char*               buffers[2];         // tick0 and tick1, parsed in turn so the deltas are not 0
+    long                lens[2];
+    int                 tick;
+    unsigned long       cpu[PRF_CPU_MAX_CORES + 1][8];
+} prf_bench_stat_t;
+
+static void prf_bench_parse(void* arg) {
+    prf_bench_stat_t*   stat = (prf_bench_stat_t*)arg;
+
+    stat->tick ^= 1;
+    prf_parse_cpu_info(stat->ctx, stat->buffers[stat->tick], stat->lens[stat->tick]);
+}
+
+/*
+ * the columns of the "cpu" and every "cpuN" line with sscanf(), the parsing of the former reader
+ */
+static void prf_bench_sscanf(void* arg) {
+    prf_bench_stat_t*   stat    = (prf_bench_stat_t*)arg;
+    const char*         p;
+    int                 core    = 0;
+
+    stat->tick ^= 1;
+    p = stat->buffers[stat->tick];
+
+    while (p != NULL && p[0] == 'c' && p[1] == 'p' && p[2] == 'u' && core <= PRF_CPU_MAX_CORES) {
+        p = strchr(p, ' ');
+        if (p == NULL) {
+            break;
+        }
+        sscanf(p, "%lu %lu %lu %lu %lu %lu %lu %lu",
+               &stat->cpu[core][0], &stat->cpu[core][1], &stat->cpu[core][2], &stat->cpu[core][3],
+               &stat->cpu[core][4], &stat->cpu[core][5], &stat->cpu[core][6], &stat->cpu[core][7]);
+        core++;
+        p = strchr(p, '\n');
+        p = (p != NULL) ? p + 1 : NULL;
+    }
+}
+
+static void prf_bench_read(void* arg) {
+    prf_read_cpu_info((prf_ctx_t*)arg);
+}
+
+int main(int argc, char* argv[]) {
+    prf_perf_t          perf;
+    prf_bench_stat_t    stat;
+    prf_ctx_t*          root_ctx;
+    char                path[512];
+    double              ns;
+    int                 cores;
+
+    if (argc != 2) {
+        fprintf(stderr, "usage: %s <fixtures/host512>\n", argv[0]);
+        return 2;
+    }
+
+    memset(&perf, 0, sizeof(perf));
+    memset(&stat, 0, sizeof(stat));
+    snprintf(path, sizeof(path), "%s/tick0", argv[1]);
+    stat.ctx        = prf_bench_ctx_create(path, &perf);
+    root_ctx        = prf_bench_ctx_create(path, &perf);
+    stat.buffers[0] = prf_bench_load(path, "/proc/stat", &stat.lens[0]);
+    snprintf(path, sizeof(path), "%s/tick1", argv[1]);
+    stat.buffers[1] = prf_bench_load(path, "/proc/stat", &stat.lens[1]);
+    if (stat.ctx == NULL || root_ctx == NULL || stat.buffers[0] == NULL || stat.buffers[1] == NULL) {
+        fprintf(stderr, "** ERROR - unable to set up the benchmark\n");
+        return 1;
+    }
+
+    prf_bench_parse(&stat);
+    cores = prf_get_cpu_count(stat.ctx);
+
+    printf("/proc/stat, %d cores, %ld bytes\n", cores, stat.lens[0]);
+    ns = prf_bench_ns(prf_bench_parse, &stat);
+    printf("  %-40s %10.1f ns/parse, %6.1f ns/core\n", "single pass, SSE2 digit kernel", ns, ns / cores);
+    ns = prf_bench_ns(prf_bench_sscanf, &stat);
+    printf("  %-40s %10.1f ns/parse, %6.1f ns/core\n", "sscanf per line (former)", ns, ns / cores);
+    ns = prf_bench_ns(prf_bench_read, root_ctx);
+    printf("  %-40s %10.1f ns/read,  %6.1f ns/core\n", "prf_read_cpu_info(), pread and parse", ns, ns / cores);
+
+    free(stat.buffers[0]);
+    free(stat.buffers[1]);
+    prf_ctx_destroy(root_ctx);
+    prf_ctx_destroy(stat.ctx);
+
+    return 0;
+}
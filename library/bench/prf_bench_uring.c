@@ -0,0 +1,158 @@
+/*
+ * system calls and latency per tick of the pread and io_uring backends, on the fixtures and on the running system
+ * the calls are counted with the linker's --wrap of pread() and syscall(), io_uring_enter() is a raw system call
+ *
+ * usage: prf-bench-uring <fixtures/host512/tick0> [<processes>]
+ */
+#include <stdarg.h>
+#include <signal.h>
+#include <sys/syscall.h>
+
+#include "prf_bench.h"
+
+#define PRF_BENCH_TICKS         2000
+#define PRF_BENCH_WARM_TICKS    50
+#define PRF_BENCH_MAX_PIDS      255
+
+static long         prf_bench_preads;
+static long         prf_bench_enters;
+
+ssize_t __real_pread(int fd, void* buffer, size_t count, off_t offset);
+long __real_syscall(long number, ...);
+
+ssize_t __wrap_pread(int fd, void* buffer, size_t count, off_t offset) {
+    prf_bench_preads++;
+
+    return __real_pread(fd, buffer, count, offset);
+}
+
+long __wrap_syscall(long number, ...) {
+    long        args[6];
+    va_list     list;
+
+    // the kernel takes up to six register arguments, the extra ones are ignored
+    va_start(list, number);
+    for (int i = 0; i < 6; i++) {
+        args[i] = va_arg(list, long);
+    }
+    va_end(list);
+
+    if (number == __NR_io_uring_enter) {
+        prf_bench_enters++;
+    }
+
+    return __real_syscall(number, args[0], args[1], args[2], args[3], args[4], args[5]);
+}
+
+static int prf_bench_compare(const void* a, const void* b) {
+    double  x = *(const double*)a;
+    double  y = *(const double*)b;
+
+    return (x > y) - (x < y);
+}
+
+/*
+ * one tick of the collector: the batch, then the readers
+ */
+static void prf_bench_tick(prf_ctx_t* ctx, bool is_live) {
+    prf_read_batch(ctx);
+    prf_read_load_avg(ctx);
+    prf_read_psi_info(ctx);
+    prf_read_cpu_info(ctx);
+    prf_read_net_info(ctx);
+    prf_read_disk_info(ctx);
+    prf_read_mem_info(ctx);
+    prf_read_vmstat_info(ctx);
+    prf_read_irq_info(ctx);
+
+    // /proc/[pid] and the cgroup are not part of the fixtures
+    if (is_live) {
+        prf_read_pid_info(ctx);
+        prf_read_cgroup_info(ctx);
+    }
+}
+
+/*
+ * times the ticks of <backend> on the files of <root>, NULL for the running system, which watches <pid_watch>
+ */
+static void prf_bench_ticks(prf_io_backend_t backend, const char* root, const char* pid_watch) {
+    static double       times[PRF_BENCH_TICKS];
+    prf_perf_t          perf;
+    prf_ctx_t*          ctx;
+    double              start;
+    long                preads;
+    long                enters;
+
+    memset(&perf, 0, sizeof(perf));
+    perf.io_backend     = backend;
+    perf.interface_name = "lo";
+    perf.pid_watch      = pid_watch;
+    perf.disk_enabled   = true;
+    perf.vmstat_enabled = true;
+    perf.irq_enabled    = true;
+    ctx = prf_bench_ctx_create(root, &perf);
+    if (ctx == NULL) {
+        fprintf(stderr, "** ERROR - unable to set up the benchmark\n");
+        return;
+    }
+
+    for (int i = 0; i < PRF_BENCH_WARM_TICKS; i++) {
+        prf_bench_tick(ctx, root == NULL);
+    }
+
+    prf_bench_preads = 0;
+    prf_bench_enters = 0;
+    for (int i = 0; i < PRF_BENCH_TICKS; i++) {
+        start = prf_bench_now();
+        prf_bench_tick(ctx, root == NULL);
+        times[i] = prf_bench_now() - start;
+    }
+    preads = prf_bench_preads;
+    enters = prf_bench_enters;
+
+    qsort(times, PRF_BENCH_TICKS, sizeof(times[0]), prf_bench_compare);
+    printf("  %-10s syscalls/tick: pread %6.1f, io_uring_enter %4.1f   latency/tick: p50 %8.1f us, p90 %8.1f us\n",
+           prf_get_io_backend_name(backend), (double)preads / PRF_BENCH_TICKS, (double)enters / PRF_BENCH_TICKS,
+           times[PRF_BENCH_TICKS / 2] * 1000000.0, times[PRF_BENCH_TICKS * 9 / 10] * 1000000.0);
+
+    prf_ctx_destroy(ctx);
+}
+
+int main(int argc, char* argv[]) {
+    static char     pid_watch[8 * (PRF_BENCH_MAX_PIDS + 1)];
+    pid_t           pids[PRF_BENCH_MAX_PIDS];
+    int             count   = 0;
+    int             len;
+
+    if (argc != 2 && argc != 3) {
+        fprintf(stderr, "usage: %s <fixtures/host512/tick0> [<processes>]\n", argv[0]);
+        return 2;
+    }
+
+    // the sleeping children watched besides the benchmark itself
+    count = (argc == 3) ? atoi(argv[2]) : 0;
+    count = (count < 0) ? 0 : (count > PRF_BENCH_MAX_PIDS) ? PRF_BENCH_MAX_PIDS : count;
+    len   = snprintf(pid_watch, sizeof(pid_watch), "self");
+    for (int i = 0; i < count; i++) {
+        pids[i] = fork();
+        if (pids[i] == 0) {
+            pause();
+            _exit(0);
+        }
+        len += snprintf(pid_watch + len, sizeof(pid_watch) - len, ",%d", (int)pids[i]);
+    }
+
+    printf("fixtures, %s\n", argv[1]);
+    prf_bench_ticks(PRF_IO_BACKEND_PREAD, argv[1], NULL);
+    prf_bench_ticks(PRF_IO_BACKEND_URING, argv[1], NULL);
+
+    printf("running system, %d watched processes\n", count + 1);
+    prf_bench_ticks(PRF_IO_BACKEND_PREAD, NULL, pid_watch);
+    prf_bench_ticks(PRF_IO_BACKEND_URING, NULL, pid_watch);
+
+    for (int i = 0; i < count; i++) {
+        kill(pids[i], SIGKILL);
+    }
+
+    return 0;
+}
@@ -26,42 +26,702 @@
     PRF_REP##TENS(PRF_REP10(X)) \
     PRF_REP##ONES(X)
 
+#define PRF_CPU_MAX_CORES   1024
+#define PRF_NET_MAX_ITF     256
+#define PRF_NET_NAME_LEN    16      // IFNAMSIZ
+#define PRF_SUB_MAX         32      // subscriptions per context
+#define PRF_GATE_MAX        8       // gates per context
+#define PRF_GATE_MAX_RULES  8
+#define PRF_GATE_REASON_LEN 96
+#define PRF_DISK_MAX_DEV    256
+#define PRF_DISK_NAME_LEN   32      // DISK_NAME_LEN
+#define PRF_PID_MAX         256     // processes watched per context, 4 descriptors each
+#define PRF_PID_NAME_LEN    16      // TASK_COMM_LEN
+#define PRF_SHM_HISTORY_LEN 256     // samples per metric in a shared-memory segment
+#define PRF_IRQ_MAX_CPU     256     // CPU columns of /proc/softirqs and /proc/interrupts
+
 #define PRF_TRUE        "true"
 #define PRF_FALSE       "false"
 
+/*
+ * load selected by <cpu_load_type>: a kernel load average of 1, 5 or 15 minutes,
+ * or one of the three in-library estimators with the time constants <load_ewma_s>, 1, 5 and 30 seconds by default
+ */
 typedef enum {
+    TYPE_EWMA_3         = -3,
+    TYPE_EWMA_2         = -2,
+    TYPE_EWMA_1         = -1,
     TYPE_MIN_1          = 1,
     TYPE_MIN_5          = 5,
     TYPE_MIN_15         = 15
 } prf_cpu_load_t;
 
+/*
+ * /proc/meminfo fields in the kernel's order, values are in kB
+ * except HugePages_Total, HugePages_Free, HugePages_Rsvd and HugePages_Surp, which are page counts
+ */
+typedef enum {
+    PRF_MEM_TOTAL  = 0,
+    PRF_MEM_FREE,
+    PRF_MEM_AVAILABLE,
+    PRF_MEM_BUFFERS,
+    PRF_MEM_CACHED,
+    PRF_MEM_SWAP_CACHED,
+    PRF_MEM_ACTIVE,
+    PRF_MEM_INACTIVE,
+    PRF_MEM_ACTIVE_ANON,
+    PRF_MEM_INACTIVE_ANON,
+    PRF_MEM_ACTIVE_FILE,
+    PRF_MEM_INACTIVE_FILE,
+    PRF_MEM_UNEVICTABLE,
+    PRF_MEM_MLOCKED,
+    PRF_MEM_HIGH_TOTAL,
+    PRF_MEM_HIGH_FREE,
+    PRF_MEM_LOW_TOTAL,
+    PRF_MEM_LOW_FREE,
+    PRF_MEM_SWAP_TOTAL,
+    PRF_MEM_SWAP_FREE,
+    PRF_MEM_ZSWAP,
+    PRF_MEM_ZSWAPPED,
+    PRF_MEM_DIRTY,
+    PRF_MEM_WRITEBACK,
+    PRF_MEM_ANON_PAGES,
+    PRF_MEM_MAPPED,
+    PRF_MEM_SHMEM,
+    PRF_MEM_KRECLAIMABLE,
+    PRF_MEM_SLAB,
+    PRF_MEM_SRECLAIMABLE,
+    PRF_MEM_SUNRECLAIM,
+    PRF_MEM_KERNEL_STACK,
+    PRF_MEM_SHADOW_CALL_STACK,
+    PRF_MEM_PAGE_TABLES,
+    PRF_MEM_SEC_PAGE_TABLES,
+    PRF_MEM_NFS_UNSTABLE,
+    PRF_MEM_BOUNCE,
+    PRF_MEM_WRITEBACK_TMP,
+    PRF_MEM_COMMIT_LIMIT,
+    PRF_MEM_COMMITTED_AS,
+    PRF_MEM_VMALLOC_TOTAL,
+    PRF_MEM_VMALLOC_USED,
+    PRF_MEM_VMALLOC_CHUNK,
+    PRF_MEM_PERCPU,
+    PRF_MEM_HARDWARE_CORRUPTED,
+    PRF_MEM_ANON_HUGE_PAGES,
+    PRF_MEM_SHMEM_HUGE_PAGES,
+    PRF_MEM_SHMEM_PMD_MAPPED,
+    PRF_MEM_FILE_HUGE_PAGES,
+    PRF_MEM_FILE_PMD_MAPPED,
+    PRF_MEM_CMA_TOTAL,
+    PRF_MEM_CMA_FREE,
+    PRF_MEM_UNACCEPTED,
+    PRF_MEM_BALLOON,
+    PRF_MEM_HUGE_PAGES_TOTAL,
+    PRF_MEM_HUGE_PAGES_FREE,
+    PRF_MEM_HUGE_PAGES_RSVD,
+    PRF_MEM_HUGE_PAGES_SURP,
+    PRF_MEM_HUGE_PAGE_SIZE,
+    PRF_MEM_HUGETLB,
+    PRF_MEM_DIRECT_MAP_4K,
+    PRF_MEM_DIRECT_MAP_2M,
+    PRF_MEM_DIRECT_MAP_4M,
+    PRF_MEM_DIRECT_MAP_1G,
+    PRF_MEM_FIELD_COUNT
+} prf_mem_field_t;
+
+/*
+ * /proc/vmstat counters of paging, swapping and reclaim, summed over the zones on kernels that report them per zone
+ */
+typedef enum {
+    PRF_VM_PGMAJFAULT   = 0,    // major page faults
+    PRF_VM_PSWPIN,              // pages swapped in
+    PRF_VM_PSWPOUT,             // pages swapped out
+    PRF_VM_PGSCAN_KSWAPD,       // pages scanned by kswapd
+    PRF_VM_PGSCAN_DIRECT,       // pages scanned by direct reclaim, in the allocating task
+    PRF_VM_PGSTEAL_KSWAPD,      // pages reclaimed by kswapd
+    PRF_VM_PGSTEAL_DIRECT,      // pages reclaimed by direct reclaim
+    PRF_VM_ALLOCSTALL,          // allocations stalled in direct reclaim
+    PRF_VM_FIELD_COUNT
+} prf_vm_field_t;
+
+/*
+ * /proc/vmstat counters, indexed by prf_vm_field_t, and their rates per second over the time since the previous read
+ */
+typedef struct prf_vmstat {
+    unsigned long       value[PRF_VM_FIELD_COUNT];
+    float               rate[PRF_VM_FIELD_COUNT];
+} prf_vmstat_t;
+
+/*
+ * softirq vectors, the rows of /proc/softirqs
+ */
+typedef enum {
+    PRF_SOFTIRQ_HI      = 0,
+    PRF_SOFTIRQ_TIMER,
+    PRF_SOFTIRQ_NET_TX,
+    PRF_SOFTIRQ_NET_RX,
+    PRF_SOFTIRQ_BLOCK,
+    PRF_SOFTIRQ_IRQ_POLL,
+    PRF_SOFTIRQ_TASKLET,
+    PRF_SOFTIRQ_SCHED,
+    PRF_SOFTIRQ_HRTIMER,
+    PRF_SOFTIRQ_RCU,
+    PRF_SOFTIRQ_COUNT
+} prf_softirq_t;
+
+/*
+ * distribution of a softirq vector or of the device interrupts over the CPUs, rates per second
+ */
+typedef struct prf_irq_dist {
+    float               total_rate;         // all CPUs
+    float               max_rate;           // the busiest CPU
+    int                 max_cpu;            // number of the busiest CPU
+    float               imbalance;          // max / mean: 1 for an even spread, the CPU count for a single CPU, 0 for none
+} prf_irq_dist_t;
+
+/*
+ * network statistics of an interface, raw counters as in prf_get_net_raw_info(), rates per second
+ */
+typedef struct prf_net_itf {
+    char                name[PRF_NET_NAME_LEN];
+    unsigned long       rx[8];
+    unsigned long       tx[8];
+    float               rx_bytes_rate;
+    float               tx_bytes_rate;
+    float               rx_packets_rate;
+    float               tx_packets_rate;
+    float               rx_errs_rate;
+    float               tx_errs_rate;
+    float               rx_drops_rate;
+    float               tx_drops_rate;
+} prf_net_itf_t;
+
+/*
+ * source of the load averages and the basic memory fields
+ */
+typedef enum {
+    PRF_SYS_BACKEND_PROC    = 0,    // text of /proc/loadavg and /proc/meminfo
+    PRF_SYS_BACKEND_SYSINFO,        // a sysinfo() call, the fields it lacks from /proc at most once a second
+    PRF_SYS_BACKEND_COUNT
+} prf_sys_backend_t;
+
+/*
+ * source of the per-interface counters
+ */
+typedef enum {
+    PRF_NET_BACKEND_PROC    = 0,    // text of /proc/net/dev
+    PRF_NET_BACKEND_NETLINK,        // rtnl_link_stats64 of RTM_GETLINK requests on a persistent rtnetlink socket
+    PRF_NET_BACKEND_COUNT
+} prf_net_backend_t;
+
+/*
+ * reader of the files of a tick
+ */
+typedef enum {
+    PRF_IO_BACKEND_PREAD    = 0,    // pread() calls on the persistent descriptors, one file after the other
+    PRF_IO_BACKEND_URING,           // the reads of a tick submitted to an io_uring as one batch, pread() without io_uring
+    PRF_IO_BACKEND_COUNT
+} prf_io_backend_t;
+
+/*
+ * I/O statistics of a block device, rates over the time since the previous read
+ * stats[0]  = reads completed
+ * stats[1]  = reads merged
+ * stats[2]  = sectors read, 512 bytes each
+ * stats[3]  = ms spent reading
+ * stats[4]  = writes completed
+ * stats[5]  = writes merged
+ * stats[6]  = sectors written
+ * stats[7]  = ms spent writing
+ * stats[8]  = I/Os currently in progress
+ * stats[9]  = ms spent doing I/Os
+ * stats[10] = weighted ms spent doing I/Os
+ */
+typedef struct prf_disk {
+    char                name[PRF_DISK_NAME_LEN];
+    unsigned long       stats[11];
+    float               read_iops;
+    float               write_iops;
+    float               read_mbps;          // MB/s, 1 MB = 1000000 bytes
+    float               write_mbps;
+    float               await_ms;           // average time of the completed I/Os, queueing included
+    float               util;               // percentage of time with I/Os in flight
+    float               queue_size;         // average number of I/Os in flight
+} prf_disk_t;
+
+/*
+ * resource usage of a watched process from /proc/[pid]/stat, statm and io, rates over the time since the previous read
+ */
+typedef struct prf_pid {
+    pid_t               pid;
+    pid_t               ppid;
+    char                name[PRF_PID_NAME_LEN];
+    char                state;              // R, S, D, Z, ...
+    int                 threads;
+    unsigned long       utime;              // clock ticks
+    unsigned long       stime;
+    unsigned long       maj_flt;
+    unsigned long       vm_kb;
+    unsigned long       rss_kb;
+    bool                has_io;             // /proc/[pid]/io needs ptrace access, the I/O fields are 0 without it
+    unsigned long       read_bytes;         // storage I/O, page cache hits excluded
+    unsigned long       write_bytes;
+    float               cpu_pt;             // percentage of one CPU, above 100 for a process busy on several CPUs
+    float               maj_flt_rate;       // major faults/s
+    float               read_rate;          // bytes/s
+    float               write_rate;
+} prf_pid_t;
+
+/*
+ * resources of /proc/pressure
+ */
+typedef enum {
+    PRF_PSI_CPU         = 0,
+    PRF_PSI_MEMORY,
+    PRF_PSI_IO,
+    PRF_PSI_COUNT
+} prf_psi_resource_t;
+
+/*
+ * pressure stall information of a resource, percentages of the wall time with tasks stalled on it
+ * some: at least one task stalled, full: all non-idle tasks stalled at once, 0 for the CPU on older kernels
+ */
+typedef struct prf_psi {
+    float               some_avg[3];        // avg10, avg60, avg300, as computed by the kernel
+    float               full_avg[3];
+    unsigned long       some_total;         // total stall time, us
+    unsigned long       full_total;
+    float               some_rate;          // over the time since the previous read, from the deltas of the totals
+    float               full_rate;          //   avg10 on the first read
+} prf_psi_t;
+
+/*
+ * usage and limits of the cgroup v2 of the process, found in /proc/self/cgroup
+ * rates are over the time since the previous read
+ */
+typedef struct prf_cgroup {
+    bool                has_cpu_max;        // cpu controller enabled, cpu.max exists
+    bool                has_memory;         // memory controller enabled, memory.* exist
+    unsigned long       cpu_quota_us;       // cpu.max, 0 for "max"
+    unsigned long       cpu_period_us;
+    float               cpu_limit;          // CPUs: quota / period, the online CPUs without a quota
+    unsigned long       usage_us;           // cpu.stat
+    unsigned long       nr_periods;
+    unsigned long       nr_throttled;
+    unsigned long       throttled_us;
+    float               cpu_usage;          // CPUs used
+    float               cpu_pt;             // <cpu_usage> against <cpu_limit>, percent
+    float               throttled_pt;       // percentage of the enforcement periods throttled since the previous read
+    unsigned long       mem_current;        // bytes, memory.current
+    unsigned long       mem_max;            // bytes, memory.max, MemTotal for "max"
+    unsigned long       mem_headroom;       // <mem_max> - <mem_current>
+    float               mem_pt;             // <mem_current> against <mem_max>, percent
+    unsigned long       mem_high_events;    // memory.events: times over memory.high
+    unsigned long       mem_max_events;     //   times at memory.max
+    unsigned long       mem_oom_events;
+    unsigned long       mem_oom_kill_events;
+} prf_cgroup_t;
+
+/*
+ * source of the threshold value compared to <cpu_threshold>, which is in the unit of the source
+ */
+typedef enum {
+    PRF_THRESHOLD_LOAD_AVG  = 0,    // load average of <cpu_load_type>
+    PRF_THRESHOLD_PSI_CPU,          // some_rate of /proc/pressure/cpu, percent
+    PRF_THRESHOLD_PSI_MEMORY,       // some_rate of /proc/pressure/memory, percent
+    PRF_THRESHOLD_PSI_IO,           // some_rate of /proc/pressure/io, percent
+    PRF_THRESHOLD_CGROUP_CPU,       // CPU usage of the cgroup against its quota, percent
+    PRF_THRESHOLD_CGROUP_MEMORY,    // memory usage of the cgroup against its limit, percent
+    PRF_THRESHOLD_SOURCE_COUNT
+} prf_threshold_src_t;
+
+/*
+ * consistent copy of the latest metrics, published by the collector thread after every tick
+ */
+typedef struct prf_snapshot {
+    unsigned long       seq;                // 1 for the first snapshot, incremented per tick
+    struct timespec     stamp;              // CLOCK_MONOTONIC time of publication
+    float               load_avg[3];        // as prf_get_load_avg()
+    float               load_ewma[3];       // as prf_get_load_ewma()
+    float               threshold;          // as prf_get_current_threshold()
+    bool                is_overloaded;      // threshold >= cpu_threshold
+    float               cpu_pt[8];          // CPU selected by <cpu_name>, as prf_get_cpu_pt_info()
+    float               cpu_total_pt[8];    // as prf_get_cpu_pt_total()
+    int                 cpu_count;
+    int                 cpu_busiest;        // as prf_get_cpu_busiest()
+    float               cpu_busiest_load;
+    unsigned long       mem[8];             // as prf_get_current_mem_info()
+    unsigned long       mem_available;      // MemAvailable, kB
+    float               net_rate[2];        // interface <interface_name>, as prf_get_net_rate_info()
+    prf_net_itf_t       net_total;          // as prf_get_net_total()
+    prf_psi_t           psi[PRF_PSI_COUNT]; // as prf_get_psi_info()
+    prf_disk_t          disk_total;         // as prf_get_disk_total()
+    prf_cgroup_t        cgroup;             // as prf_get_cgroup_info()
+    prf_vmstat_t        vmstat;             // as prf_get_vmstat_info()
+    prf_irq_dist_t      softirq[PRF_SOFTIRQ_COUNT]; // as prf_get_softirq_dist()
+    prf_irq_dist_t      irq;                // as prf_get_irq_dist()
+    float               interval;           // seconds until the next snapshot, as prf_get_current_interval()
+} prf_snapshot_t;
+
+/*
+ * metrics recorded into the history of a collector after every tick, taken from its snapshot
+ */
+typedef enum {
+    PRF_METRIC_THRESHOLD    = 0,    // value of the threshold source, as prf_get_current_threshold()
+    PRF_METRIC_LOAD_AVG,            // load average of <cpu_load_type>, as prf_get_current_load_avg()
+    PRF_METRIC_LOAD_EWMA,           // in-library load estimator of the shortest time constant
+    PRF_METRIC_CPU_LOAD,            // load percentage of the CPU selected by <cpu_name>
+    PRF_METRIC_CPU_TOTAL_LOAD,      // load percentage of the aggregate "cpu" line
+    PRF_METRIC_CPU_IOWAIT,          // iowait percentage of the aggregate "cpu" line
+    PRF_METRIC_CPU_BUSIEST_LOAD,    // load percentage of the busiest core
+    PRF_METRIC_MEM_USED,            // percentage of MemTotal not available: 100 * (MemTotal - MemAvailable) / MemTotal
+    PRF_METRIC_MEM_AVAILABLE,       // MemAvailable, kB
+    PRF_METRIC_NET_RX_RATE,         // Rx rate of <interface_name>, kb/s
+    PRF_METRIC_NET_TX_RATE,         // Tx rate of <interface_name>, kb/s
+    PRF_METRIC_NET_TOTAL_RX,        // Rx bytes/s of all included interfaces
+    PRF_METRIC_NET_TOTAL_TX,        // Tx bytes/s of all included interfaces
+    PRF_METRIC_PSI_CPU,             // some_rate of /proc/pressure/cpu, percent
+    PRF_METRIC_PSI_MEMORY,          // some_rate of /proc/pressure/memory, percent
+    PRF_METRIC_PSI_IO,              // some_rate of /proc/pressure/io, percent
+    PRF_METRIC_DISK_IOPS,           // read and write IOPS of all included block devices
+    PRF_METRIC_DISK_MBPS,           // read and write MB/s of all included block devices
+    PRF_METRIC_DISK_UTIL,           // utilization of the busiest included block device, percent
+    PRF_METRIC_CGROUP_CPU,          // CPU usage of the cgroup against its quota, percent
+    PRF_METRIC_CGROUP_THROTTLED,    // percentage of the cgroup's enforcement periods throttled
+    PRF_METRIC_CGROUP_MEMORY,       // memory usage of the cgroup against its limit, percent
+    PRF_METRIC_VM_MAJFAULT,         // major page faults/s
+    PRF_METRIC_VM_SWAP,             // pages swapped in and out/s
+    PRF_METRIC_VM_SCAN,             // pages scanned for reclaim by kswapd and direct reclaim/s
+    PRF_METRIC_VM_SCAN_DIRECT,      // pages scanned by direct reclaim/s, allocations paying for reclaim
+    PRF_METRIC_VM_ALLOCSTALL,       // allocation stalls/s
+    PRF_METRIC_SOFTIRQ_NET_RX,      // NET_RX softirqs/s of the busiest CPU
+    PRF_METRIC_SOFTIRQ_IMBALANCE,   // imbalance of the NET_RX softirqs, max / mean over the CPUs
+    PRF_METRIC_IRQ_IMBALANCE,       // imbalance of the device interrupts, max / mean over the CPUs
+    PRF_METRIC_COUNT
+} prf_metric_t;
+
+/*
+ * aggregates of a metric over a window of its history
+ */
+typedef struct prf_stats {
+    int                 count;              // samples in the window
+    float               min;
+    float               max;
+    float               mean;
+    float               ewma;               // time-weighted, time constant <history_ewma_s>, regardless of the window
+    float               last;               // latest sample
+} prf_stats_t;
+
+/*
+ * edge of a subscription, the value of its metric crossed the threshold
+ */
+typedef struct prf_event {
+    int                 sub_id;             // as returned by prf_subscribe()
+    prf_metric_t        metric;
+    float               value;              // value that crossed the threshold
+    bool                is_above;           // true: rose to or above the threshold, false: fell below threshold - hysteresis
+    struct timespec     stamp;              // CLOCK_MONOTONIC time of the snapshot
+} prf_event_t;
+
+/*
+ * subscription to the crossings of a threshold by a metric
+ * a rising edge fires when the value reaches <threshold>, the falling edge when it drops below <threshold> - <hysteresis>
+ * the state starts below the threshold, a first sample at or above it fires a rising edge
+ */
+typedef struct prf_sub {
+    prf_metric_t        metric;
+    float               threshold;
+    float               hysteresis;         // >= 0, in the unit of the metric
+    void                (*callback)(const prf_event_t* event, void* arg);   // NULL for the eventfd only
+    void*               arg;
+} prf_sub_t;
+
+/*
+ * how the rules of a gate are combined
+ */
+typedef enum {
+    PRF_GATE_ANY        = 0,    // defers while any rule is over its watermarks
+    PRF_GATE_ALL,               // defers while all rules are over their watermarks
+    PRF_GATE_WEIGHTED           // defers from a weighted mean of value / high of 1, until it drops below the one of low / high
+} prf_gate_mode_t;
+
+/*
+ * rule of a gate: a metric is over from <high> on until it drops below <low>
+ */
+typedef struct prf_gate_rule {
+    prf_metric_t        metric;
+    float               high;
+    float               low;                // <= high, the hysteresis of the rule
+    float               weight;             // PRF_GATE_WEIGHTED only, 0 for 1
+    float               smooth_s;           // mean over the last <smooth_s> seconds of the history, 0 for the latest sample
+} prf_gate_rule_t;
+
+/*
+ * admission-control gate configuration, copied by prf_gate_create()
+ */
+typedef struct prf_gate_cfg {
+    prf_gate_mode_t     mode;
+    int                 rule_count;
+    prf_gate_rule_t     rules[PRF_GATE_MAX_RULES];
+    float               release_rate;       // waiters admitted per second by prf_gate_wait(), 0 for no limit
+    int                 release_burst;      // waiters admitted at once after a quiet period, 0 for 1
+} prf_gate_cfg_t;
+
+/*
+ * decision of a gate and its reason
+ */
+typedef struct prf_gate_verdict {
+    bool                admit;
+    int                 rule;               // rule that defers, -1 if admitted or deferred by the weighted score
+    prf_metric_t        metric;             // metric of <rule>
+    float               value;              // value of <rule>
+    float               score;              // PRF_GATE_WEIGHTED: weighted mean of value / high
+    char                reason[PRF_GATE_REASON_LEN];    // f.e. "cpu_total_load 93.10 over high 90.00, low 80.00"
+} prf_gate_verdict_t;
+
+/*
+ * admission-control gate of a context, opaque, evaluated by the collector thread after every snapshot
+ */
+typedef struct prf_gate prf_gate_t;
+
+/*
+ * source of the system-wide pseudo-files, replacing their reads, f.e. to feed a sequence of captured fixtures
+ * <read> fills up to <size> - 1 bytes of <path>, f.e. "/proc/stat", into <buffer> and returns their number, -1 on error
+ * it is called on the collector thread for every read of /proc/loadavg, /proc/stat, /proc/meminfo, /proc/net/dev,
+ * /proc/pressure/<resource>, /proc/diskstats, /proc/vmstat, /proc/softirqs and /proc/interrupts
+ */
+typedef struct prf_source {
+    long                (*read)(void* arg, const char* path, char* buffer, long size);
+    void*               arg;
+} prf_source_t;
+
+/*
+ * collector configuration, copied by prf_ctx_create()
+ */
 typedef struct prf_perf {
-    bool*               is_running;
     bool                is_debug;
     bool                is_joinable;
     const char*         thread_name;
-    struct timespec*    sleep_req;
+    struct timespec*    sleep_req;          // interval, the first one in the adaptive mode
+    float               interval_min_s;     // adaptive mode: shortest interval in seconds, 0 for the fixed <sleep_req>
+    float               interval_max_s;     //   longest interval in seconds, 0 for <sleep_req>
     char*               cpu_name;
     prf_cpu_load_t      cpu_load_type;
     float               cpu_threshold;
-    float*              current_threshold;
+    prf_threshold_src_t threshold_source;   // value compared to <cpu_threshold>
     const char*         interface_name;
+    const char*         interface_include;  // comma separated globs, NULL or "" for all interfaces
+    const char*         interface_exclude;  // comma separated globs, NULL or "" for none
+    prf_net_backend_t   net_backend;        // source of the interface counters, /proc/net/dev by default
+    prf_sys_backend_t   sys_backend;        // source of the load averages and the basic memory fields, /proc by default
+    prf_io_backend_t    io_backend;         // reader of the files of a tick, pread() by default
+    bool                disk_enabled;       // collect the I/O rates of /proc/diskstats, off by default
+    const char*         disk_include;       // comma separated globs, NULL or "" for all block devices
+    const char*         disk_exclude;       // comma separated globs, NULL for "loop*,ram*", "" for none
+    bool                disk_partitions;    // include partitions, by default only whole disks
+    const char*         pid_watch;          // comma separated PIDs, "self" for the calling process, NULL or "" for none
+    bool                pid_descendants;    // watch the descendants of the watched PIDs too
+    bool                vmstat_enabled;     // collect the paging, swap and reclaim rates of /proc/vmstat, off by default
+    bool                irq_enabled;        // collect the per-CPU interrupt and softirq rates, off by default
+    int                 history_len;        // samples kept per metric, rounded up to a power of 2, 0 for 1024
+    float               history_ewma_s;     // time constant of the history's EWMA in seconds, 0 for 10
+    float               load_ewma_s[3];     // time constants of the load estimators in seconds, 0 for 1, 5 and 30
+    const char*         shm_name;           // POSIX shared-memory segment the snapshots are published to, f.e. "/prf_system",
+                                            //   NULL or "" for none
+    const char*         record_file;        // ring file the snapshots are recorded to, NULL or "" for none
+    int                 record_len;         // snapshots kept in the ring file, 0 for 3600
+    const char*         source_root;        // directory /proc and /sys are resolved in, f.e. captured fixtures,
+                                            //   NULL or "" for "/"
+    const prf_source_t* source;             // reads the system-wide pseudo-files instead, NULL for the files
 } prf_perf_t;
 
 /*
- * periodically collects CPU and network statistics
+ * collector context, opaque: all configuration, parsing state, buffers and descriptors of one collector
+ * contexts are independent, a process may run several collectors with different intervals or interfaces
+ */
+typedef struct prf_ctx prf_ctx_t;
+
+/*
+ * creates a collector context configured by <prf_perf>, the strings are copied
+ * returns NULL on error
+ */
+prf_ctx_t* prf_ctx_create(const prf_perf_t* prf_perf);
+
+/*
+ * starts the collector thread of <ctx>, running prf_perf_collect(), named <thread_name>
+ * the thread is joined by prf_ctx_stop()
+ */
+bool prf_ctx_start(prf_ctx_t* ctx);
+
+/*
+ * stops the collector thread of <ctx> without waiting for the end of the interval and joins it
+ * the latest data stays readable until prf_ctx_destroy()
+ */
+void prf_ctx_stop(prf_ctx_t* ctx);
+
+/*
+ * stops the collector thread of <ctx>, if any, and releases the context
+ */
+void prf_ctx_destroy(prf_ctx_t* ctx);
+
+/*
+ * creates a context configured by <prf_perf>, without a collector thread, fed from the recording <record_file>
+ * written by a collector with <record_file>, the <record_file> of <prf_perf> is ignored
+ * the threshold source, <cpu_threshold>, the history, subscriptions and gates of <prf_perf> apply to the replay,
+ * the history windows end at the replayed sample instead of now
+ * returns NULL if the file is missing or was recorded by an incompatible version of the library
+ */
+prf_ctx_t* prf_replay_create(const prf_perf_t* prf_perf, const char* record_file);
+
+/*
+ * publishes the next snapshot of the recording as the snapshot of <ctx>, oldest first, as fast as it is called
+ * returns false at the end of the recording
+ */
+bool prf_replay_step(prf_ctx_t* ctx);
+
+/*
+ * periodically collects CPU and network statistics into the context <arg>, a prf_ctx_t*
+ * runs until prf_cancel_perf_thread(), on a thread of prf_ctx_start() or of the caller's own
  */
 void* prf_perf_collect(void* arg);
 
 /*
- * read the system load averages for the past 1, 5, and 15 minutes
+ * publishes the current metrics as a snapshot, called by prf_perf_collect() after every tick
+ * there must be a single publishing thread
+ */
+void prf_publish_snapshot(prf_ctx_t* ctx);
+
+/*
+ * fills a consistent copy of the latest snapshot of <ctx> into <snap>, lock-free, from any thread
+ * the other prf_get_* getters read the collector's working state and belong to the collector thread
+ * of <ctx>, or to the caller when it drives the prf_read_* functions itself
+ * returns false if no snapshot has been published yet
+ */
+bool prf_get_snapshot(prf_ctx_t* ctx, prf_snapshot_t* snap);
+
+/*
+ * fills the aggregates of <metric> over the samples of the last <window> seconds into <stats>, lock-free, from any thread
+ * <window> <= 0 covers the whole history
+ * the history is a preallocated ring per metric with prefix sums and min/max segment trees:
+ * mean is O(1), min and max are O(log n), finding the window is O(log n)
+ * returns false if the window holds no sample
+ */
+bool prf_get_history_stats(prf_ctx_t* ctx, prf_metric_t metric, float window, prf_stats_t* stats);
+
+/*
+ * fills the <percentile> (0 - 100), nearest rank, of <metric> over the samples of the last <window> seconds into <value>
+ * the window is copied to the stack and selected in O(n)
+ * returns false if the window holds no sample
+ */
+bool prf_get_history_percentile(prf_ctx_t* ctx, prf_metric_t metric, float window, float percentile, float* value);
+
+/*
+ * subscribes to the crossings of <sub>, evaluated after every snapshot of <ctx>, on the collector thread
+ * each edge increments the counter of the subscription's eventfd, see prf_get_sub_fd(),
+ * then <callback> is called, if any, without holding a lock: it may not block the collector
+ * returns the subscription id, -1 if all PRF_SUB_MAX subscriptions are taken
+ */
+int prf_subscribe(prf_ctx_t* ctx, const prf_sub_t* sub);
+
+/*
+ * removes subscription <sub_id> and closes its eventfd
+ */
+void prf_unsubscribe(prf_ctx_t* ctx, int sub_id);
+
+/*
+ * returns the eventfd of subscription <sub_id>, for poll(), select() or epoll
+ * it is readable after an edge, a read() of 8 bytes returns the number of edges since the last read
+ * returns -1 for an unknown subscription
+ */
+int prf_get_sub_fd(prf_ctx_t* ctx, int sub_id);
+
+/*
+ * fills the latest edge of subscription <sub_id> into <event>
+ * returns false if it has not fired yet
+ */
+bool prf_get_sub_event(prf_ctx_t* ctx, int sub_id, prf_event_t* event);
+
+/*
+ * creates an admission-control gate on the metrics of <ctx>, evaluated after every snapshot
+ * returns NULL on an invalid configuration or if all PRF_GATE_MAX gates are taken
+ */
+prf_gate_t* prf_gate_create(prf_ctx_t* ctx, const prf_gate_cfg_t* cfg);
+
+/*
+ * releases <gate>, no thread may wait on it, prf_ctx_destroy() releases the gates left
+ */
+void prf_gate_destroy(prf_gate_t* gate);
+
+/*
+ * fills the latest decision of <gate> into <verdict>, without queueing
+ * returns true to admit
+ */
+bool prf_gate_check(prf_gate_t* gate, prf_gate_verdict_t* verdict);
+
+/*
+ * waits up to <timeout_s> seconds, < 0 for no timeout, until <gate> admits the caller
+ * waiters are admitted in their order of arrival, at most <release_rate> per second after a burst of <release_burst>,
+ * so that a queue of heavy jobs does not start at once when the load drops
+ * returns true when admitted, false on timeout, <verdict> may be NULL
  */
-bool prf_read_load_avg();
+bool prf_gate_wait(prf_gate_t* gate, float timeout_s, prf_gate_verdict_t* verdict);
+
+/*
+ * reader of a shared-memory segment published by a collector with <shm_name>, opaque
+ */
+typedef struct prf_shm prf_shm_t;
+
+/*
+ * maps the shared-memory segment <name> read-only, f.e. "/prf_system"
+ * returns NULL if it does not exist or was published by an incompatible version of the library
+ */
+prf_shm_t* prf_shm_open(const char* name);
+
+/*
+ * unmaps the segment of <shm> and releases the reader
+ */
+void prf_shm_close(prf_shm_t* shm);
+
+/*
+ * fills a consistent copy of the latest snapshot of the segment into <snap>, lock-free and without a system call
+ * the stamp of the snapshot tells its age, CLOCK_MONOTONIC is host-wide
+ * returns false if no snapshot has been published yet, or no consistent copy was made after a bounded number
+ * of tries, f.e. the publisher died in the middle of a write
+ */
+bool prf_shm_get_snapshot(prf_shm_t* shm, prf_snapshot_t* snap);
+
+/*
+ * fills the latest samples of <metric>, at most <max> and PRF_SHM_HISTORY_LEN, oldest first, into <v>
+ * and their CLOCK_MONOTONIC times in seconds into <stamps>, which may be NULL
+ * returns the number of samples, -1 if no consistent copy was made, like prf_shm_get_snapshot()
+ */
+int prf_shm_get_history(prf_shm_t* shm, prf_metric_t metric, float* v, double* stamps, int max);
+
+/*
+ * returns the PID of the publishing process
+ */
+pid_t prf_shm_get_publisher(prf_shm_t* shm);
+
+/*
+ * returns the name of <metric>, f.e. "cpu_load"
+ */
+const char* prf_get_metric_name(prf_metric_t metric);
+
+/*
+ * prints the aggregates and the 95th percentile of all metrics over the last <window> seconds, for debug purposes
+ */
+void prf_print_history(prf_ctx_t* ctx, float window);
+
+/*
+ * read the system load averages for the past 1, 5, and 15 minutes and the number of runnable tasks
+ * with the PRF_SYS_BACKEND_SYSINFO <sys_backend> the load averages and the number of tasks come from a sysinfo() call,
+ * the runnable tasks, which it lacks, from /proc/loadavg at most once a second
+ */
+bool prf_read_load_avg(prf_ctx_t* ctx);
 
 /*
  * prints load averages, for debug purposes
  */
-void prf_print_load_avg();
+void prf_print_load_avg(prf_ctx_t* ctx);
 
 /*
  * fills load averages into array <v>, similar to top
@@ -69,12 +729,19 @@ void prf_print_load_avg();
  * v[1] = load averages for the past 5 minutes
  * v[2] = load averages for the past 15 minutes
  */
-void prf_get_load_avg(float v[3]);
+void prf_get_load_avg(prf_ctx_t* ctx, float v[3]);
+
+/*
+ * fills the in-library load estimators into array <v>, in the units of the load average
+ * every tick samples the busy CPUs of the "cpu" line of /proc/stat plus the runnable tasks of /proc/loadavg
+ * queued beyond the online CPUs, and folds the sample into EWMAs with the time constants <load_ewma_s>
+ */
+void prf_get_load_ewma(prf_ctx_t* ctx, float v[3]);
 
 /*
- * reports current load average threshold value;
+ * reports current load average threshold value, a kernel load average or an estimator by <cpu_load_type>
  */
-float prf_get_current_load_avg();
+float prf_get_current_load_avg(prf_ctx_t* ctx);
 
 /*
  * reports whether the given load average type is valid or not
@@ -82,6 +749,82 @@ float prf_get_current_load_avg();
 bool prf_is_valid_load_avg_val(int val);
 
 /*
+ * reports the current sampling interval in seconds
+ * in the adaptive mode it halves while the threshold source is within 20% of <cpu_threshold> or moved by 10% of it
+ * since the previous tick, drops to <interval_min_s> at the threshold and grows by half when the value is steady
+ */
+float prf_get_current_interval(prf_ctx_t* ctx);
+
+/*
+ * reports the current value of the threshold source, compared to <cpu_threshold>
+ */
+float prf_get_current_threshold(prf_ctx_t* ctx);
+
+/*
+ * fills the threshold source named <name> into <src>:
+ * "load_avg", "psi_cpu", "psi_memory", "psi_io", "cgroup_cpu" or "cgroup_memory"
+ * returns false for an unknown name
+ */
+bool prf_get_threshold_source(const char* name, prf_threshold_src_t* src);
+
+/*
+ * returns the name of threshold source <src>, f.e. "psi_cpu"
+ */
+const char* prf_get_threshold_source_name(prf_threshold_src_t src);
+
+/*
+ * reads and parses /proc/pressure/cpu, /proc/pressure/memory and /proc/pressure/io
+ * kernels without PSI, before 4.20 or booted with psi=0, report an error once and leave the values 0
+ */
+bool prf_read_psi_info(prf_ctx_t* ctx);
+
+/*
+ * parses the contents of /proc/pressure/<resource> in <buffer> of <size> bytes
+ * <stamp> is the CLOCK_MONOTONIC time of the read, NULL for now
+ * the rates are computed over the time elapsed since the previous parse of <resource>
+ */
+bool prf_parse_psi_info(prf_ctx_t* ctx, prf_psi_resource_t resource, const char* buffer, long size,
+                        const struct timespec* stamp);
+
+/*
+ * prints pressure stall information, for debug purposes
+ */
+void prf_print_psi_info(prf_ctx_t* ctx);
+
+/*
+ * fills the pressure stall information of <resource> into <psi>
+ * returns false if it has not been read
+ */
+bool prf_get_psi_info(prf_ctx_t* ctx, prf_psi_resource_t resource, prf_psi_t* psi);
+
+/*
+ * reads cpu.max, cpu.stat, memory.current, memory.max and memory.events of the cgroup v2 of the process
+ * the first read finds the cgroup in /proc/self/cgroup and the cgroup2 mount in /proc/self/mountinfo,
+ * the files are opened once with openat() on the cgroup's directory descriptor
+ * returns false without a cgroup v2, f.e. on a cgroup v1 only host
+ */
+bool prf_read_cgroup_info(prf_ctx_t* ctx);
+
+/*
+ * prints the CPU and memory usage of the cgroup against its limits, for debug purposes
+ */
+void prf_print_cgroup_info(prf_ctx_t* ctx);
+
+/*
+ * fills the usage and limits of the cgroup into <cgroup>
+ * returns false if no cgroup v2 was found
+ */
+bool prf_get_cgroup_info(prf_ctx_t* ctx, prf_cgroup_t* cgroup);
+
+/*
+ * returns the path of the cgroup directory, f.e. "/sys/fs/cgroup/system.slice/app.service", NULL if not found
+ */
+const char* prf_get_cgroup_path(prf_ctx_t* ctx);
+
+/*
+ * reads /proc/stat into a growable buffer, sized once on the first read to hold all "cpuN" lines;
+ * the lines after them (intr, softirq, ...) are not copied
+ *
  * The canonical source of this information is linux src documentation, f.e.:
  * /usr/src/linux/Documentation/filesystems/proc.txt
  * On http://git.kernel.org:
@@ -90,30 +833,41 @@ bool prf_is_valid_load_avg_val(int val);
  * reads cpu line of /proc/stat
  * http://procps.sourceforge.net/index.html
  */
-bool prf_read_cpu_info();
+bool prf_read_cpu_info(prf_ctx_t* ctx);
 
 /*
  * prints CPU values, for debug purposes
  */
-void prf_print_cpu_load();
+void prf_print_cpu_load(prf_ctx_t* ctx);
 
 /*
  * prints CPU percentages, for debug purposes
  */
-void prf_print_cpu_pt_load();
+void prf_print_cpu_pt_load(prf_ctx_t* ctx);
+
+/*
+ * parses the "cpu" and all "cpuN" lines of /proc/stat in <buffer> of <size> bytes in a single pass
+ * the numeric columns are parsed with an SSE2 digit kernel where available
+ */
+bool prf_parse_cpu_info(prf_ctx_t* ctx, const char* buffer, long size);
+
+/*
+ * prints per-core CPU percentages, for debug purposes
+ */
+void prf_print_cpu_pt_all(prf_ctx_t* ctx);
 
 /*
- * fills raw CPU data into array <c>, similar to /proc/stat's first line
+ * fills raw CPU data of the CPU selected by <cpu_name> into array <c>, in /proc/stat's order
  * c[0] = user: normal processes executing in user mode
- * c[1] = system: processes executing in kernel mode
- * c[2] = nice: niced processes executing in user mode
+ * c[1] = nice: niced processes executing in user mode
+ * c[2] = system: processes executing in kernel mode
  * c[3] = idle: twiddling thumbs
  * c[4] = iowait: waiting for I/O to complete
  * c[5] = irq: servicing interrupts (hardware interrupts)
  * c[6] = softirq: servicing softirqs (software interrupts)
  * c[7] = steal: involuntary wait
  */
-void prf_get_cpu_raw_info(unsigned long c[8]);
+void prf_get_cpu_raw_info(prf_ctx_t* ctx, unsigned long c[8]);
 
 /*
  * fills percentage of CPU time spent in each eight cats into array <p>, similar to top
@@ -126,38 +880,89 @@ void prf_get_cpu_raw_info(unsigned long c[8]);
  * p[6] = %si, softirq: servicing softirqs (software interrupts)
  * p[7] = %st, steal: involuntary wait
  */
-void prf_get_cpu_pt_info(float p[8]);
+void prf_get_cpu_pt_info(prf_ctx_t* ctx, float p[8]);
+
+/*
+ * fills the percentages of the aggregate "cpu" line into array <p>, ordered as prf_get_cpu_pt_info()
+ */
+void prf_get_cpu_pt_total(prf_ctx_t* ctx, float p[8]);
+
+/*
+ * returns the number of cores read from the "cpuN" lines, highest N + 1
+ * offline cores have no "cpuN" line, the cores below the highest one are not all online then
+ */
+int prf_get_cpu_count(prf_ctx_t* ctx);
+
+/*
+ * returns the number of "cpuN" lines of the last read, the online cores
+ */
+int prf_get_cpu_online(prf_ctx_t* ctx);
+
+/*
+ * returns true if the last read had a "cpuN" line for <core>
+ */
+bool prf_is_cpu_online(prf_ctx_t* ctx, int core);
+
+/*
+ * fills raw per-core CPU data, structure of arrays: c[state][core], states ordered as prf_get_cpu_raw_info()
+ * each non-NULL c[state] holds up to <len> cores, the offline ones are 0
+ * returns the number of cores filled
+ */
+int prf_get_cpu_raw_all(prf_ctx_t* ctx, unsigned long* c[8], int len);
+
+/*
+ * fills per-core CPU percentages, structure of arrays: p[state][core], states ordered as prf_get_cpu_pt_info()
+ * f.e. p[3][12] is the idle percentage of cpu12, p[4][12] its iowait, p[7][12] its steal
+ * each non-NULL p[state] holds up to <len> cores, the offline ones are 0
+ * returns the number of cores filled
+ */
+int prf_get_cpu_pt_all(prf_ctx_t* ctx, float* p[8], int len);
+
+/*
+ * returns the online core with the lowest idle percentage and fills its load percentage into <load>
+ * returns -1 if no "cpuN" line was read
+ */
+int prf_get_cpu_busiest(prf_ctx_t* ctx, float* load);
+
+/*
+ * returns the core number of <cpu_name>: "cpu" is -1, the aggregate line, "cpuN" is N
+ */
+int prf_get_cpu_index(const char* cpu_name);
 
 /*
  *  returns CPU idle percentage
  */
-float prf_get_cpu_idle();
+float prf_get_cpu_idle(prf_ctx_t* ctx);
 
 /*
  *  returns CPU load percentage
  */
-float prf_get_cpu_load();
+float prf_get_cpu_load(prf_ctx_t* ctx);
 
 /*
- * parses /proc/meminfo
+ * reads and parses /proc/meminfo
+ * with the PRF_SYS_BACKEND_SYSINFO <sys_backend> MemTotal, MemFree, Buffers, Shmem, SwapTotal and SwapFree come from
+ * a sysinfo() call, the other fields from /proc/meminfo at most once a second,
+ * MemAvailable follows the changes of MemFree in between
  * http://procps.sourceforge.net/index.html
  */
-bool  prf_read_mem_info();
+bool  prf_read_mem_info(prf_ctx_t* ctx);
 
 /*
- * prints a summary for mem info, for debug purposes
+ * parses the contents of /proc/meminfo in <buffer> of <size> bytes in a single pass
+ * keys are looked up in a precomputed perfect hash table, unknown keys are skipped
  */
-void prf_print_mem_info();
+bool  prf_parse_mem_info(prf_ctx_t* ctx, const char* buffer, long size);
 
 /*
- * prints all mem info, for debug purposes
+ * prints a summary for mem info, for debug purposes
  */
-void prf_print_mem_info_full();
+void prf_print_mem_info(prf_ctx_t* ctx);
 
 /*
- * required for bsearch() call in prf_read_mem_info()
+ * prints all mem info, for debug purposes
  */
-int prf_compare_mem_table_structs(const void* a, const void* b);
+void prf_print_mem_info_full(prf_ctx_t* ctx);
 
 /*
  * reads momory data and fills it into array <m>, similar to top
@@ -170,25 +975,183 @@ int prf_compare_mem_table_structs(const void* a, const void* b);
  * m[6] = swap free
  * m[7] = swap cached
  */
-void prf_get_current_mem_info(unsigned long m[8]);
+void prf_get_current_mem_info(prf_ctx_t* ctx, unsigned long m[8]);
+
+/*
+ * fills all /proc/meminfo fields into array <m>, indexed by prf_mem_field_t
+ * fields not reported by the running kernel are 0
+ */
+void prf_get_mem_info_full(prf_ctx_t* ctx, unsigned long m[PRF_MEM_FIELD_COUNT]);
+
+/*
+ * returns the /proc/meminfo key of <field>, f.e. "MemAvailable"
+ */
+const char* prf_get_mem_field_name(prf_mem_field_t field);
+
+/*
+ * reads and parses /proc/vmstat
+ * the collector thread calls it only with <vmstat_enabled>
+ */
+bool prf_read_vmstat_info(prf_ctx_t* ctx);
+
+/*
+ * parses the contents of /proc/vmstat in <buffer> of <size> bytes in a single pass
+ * <stamp> is the CLOCK_MONOTONIC time of the read, NULL for now
+ * rates are computed over the time elapsed since the previous parse, they are 0 on the first parse
+ */
+bool prf_parse_vmstat_info(prf_ctx_t* ctx, const char* buffer, long size, const struct timespec* stamp);
+
+/*
+ * prints the paging, swapping and reclaim counters and rates, for debug purposes
+ */
+void prf_print_vmstat_info(prf_ctx_t* ctx);
+
+/*
+ * fills the /proc/vmstat counters and rates into <vmstat>
+ */
+void prf_get_vmstat_info(prf_ctx_t* ctx, prf_vmstat_t* vmstat);
+
+/*
+ * returns the /proc/vmstat key of <field>, f.e. "pgscan_direct"
+ */
+const char* prf_get_vm_field_name(prf_vm_field_t field);
+
+/*
+ * reads and parses /proc/softirqs and /proc/interrupts
+ * the collector thread calls it only with <irq_enabled>
+ */
+bool prf_read_irq_info(prf_ctx_t* ctx);
+
+/*
+ * parses the contents of /proc/softirqs in <buffer> of <size> bytes in a single pass, without allocations
+ * <stamp> is the CLOCK_MONOTONIC time of the read, NULL for now
+ * rates are computed over the time elapsed since the previous parse, they are 0 on the first parse
+ */
+bool prf_parse_softirq_info(prf_ctx_t* ctx, const char* buffer, long size, const struct timespec* stamp);
+
+/*
+ * parses the contents of /proc/interrupts in <buffer> of <size> bytes in a single pass, without allocations
+ * the counters of the device interrupts, the numbered lines, are summed per CPU,
+ * the per-CPU architecture interrupts like LOC or NMI are left out
+ * <stamp> is the CLOCK_MONOTONIC time of the read, NULL for now
+ */
+bool prf_parse_irq_info(prf_ctx_t* ctx, const char* buffer, long size, const struct timespec* stamp);
+
+/*
+ * prints the distribution of the softirq vectors and the device interrupts over the CPUs, for debug purposes
+ */
+void prf_print_irq_info(prf_ctx_t* ctx);
+
+/*
+ * fills the distribution of softirq <vector> over the CPUs into <dist>
+ */
+void prf_get_softirq_dist(prf_ctx_t* ctx, prf_softirq_t vector, prf_irq_dist_t* dist);
+
+/*
+ * fills the distribution of the device interrupts over the CPUs into <dist>
+ */
+void prf_get_irq_dist(prf_ctx_t* ctx, prf_irq_dist_t* dist);
+
+/*
+ * fills up to <len> per-CPU rates of softirq <vector> into <rates>, and the CPU numbers into <cpus>, which may be NULL
+ * returns the number of CPUs filled, the columns of /proc/softirqs
+ */
+int prf_get_softirq_rates(prf_ctx_t* ctx, prf_softirq_t vector, float* rates, int* cpus, int len);
+
+/*
+ * fills up to <len> per-CPU rates of the device interrupts into <rates>, and the CPU numbers into <cpus>,
+ * which may be NULL
+ * returns the number of CPUs filled, the columns of /proc/interrupts
+ */
+int prf_get_irq_rates(prf_ctx_t* ctx, float* rates, int* cpus, int len);
+
+/*
+ * returns the name of softirq <vector>, f.e. "NET_RX"
+ */
+const char* prf_get_softirq_name(prf_softirq_t vector);
 
 /*
- * parses /proc/net/dev
+ * reads and parses /proc/net/dev, or queries the kernel over rtnetlink with the PRF_NET_BACKEND_NETLINK <net_backend>
+ * all interfaces go into a per-interface table, <interface_name> is matched exactly for the single-interface getters
+ * over rtnetlink, when the include filter names the interfaces without glob characters, only they and
+ * <interface_name> are requested, the other interfaces are not in the table
+ * a <source_root> or a <source> reads /proc/net/dev, as does a failure to open the rtnetlink socket
  */
-bool prf_read_net_info();
+bool prf_read_net_info(prf_ctx_t* ctx);
+
+/*
+ * parses the contents of /proc/net/dev in <buffer> of <size> bytes in a single pass
+ * <stamp> is the CLOCK_MONOTONIC time of the read, NULL for now
+ * rates are computed over the time elapsed since the previous parse, they are 0 on the first parse
+ */
+bool prf_parse_net_info(prf_ctx_t* ctx, const char* buffer, long size, const struct timespec* stamp);
+
+/*
+ * parses the rtnetlink messages in <buffer> of <size> bytes into the per-interface table, like prf_parse_net_info():
+ * the counters of RTM_NEWLINK messages, IFLA_STATS64, and RTM_NEWSTATS messages, IFLA_STATS_LINK_64, summed as in
+ * /proc/net/dev, the names of RTM_NEWSTATS messages are those of earlier RTM_NEWLINK messages with the same index
+ * other messages, like NLMSG_DONE or NLMSG_ERROR, are skipped
+ * <stamp> is the CLOCK_MONOTONIC time of the read, NULL for now
+ */
+bool prf_parse_net_link(prf_ctx_t* ctx, const char* buffer, long size, const struct timespec* stamp);
+
+/*
+ * fills the source of the load averages and the basic memory fields named <name> into <backend>: "proc" or "sysinfo"
+ * returns false for an unknown name
+ */
+bool prf_get_sys_backend(const char* name, prf_sys_backend_t* backend);
+
+/*
+ * returns the name of the source of the load averages and the basic memory fields <backend>, f.e. "sysinfo"
+ */
+const char* prf_get_sys_backend_name(prf_sys_backend_t backend);
+
+/*
+ * fills the source of the interface counters named <name> into <backend>: "proc" or "netlink"
+ * returns false for an unknown name
+ */
+bool prf_get_net_backend(const char* name, prf_net_backend_t* backend);
+
+/*
+ * returns the name of the source of the interface counters <backend>, f.e. "netlink"
+ */
+const char* prf_get_net_backend_name(prf_net_backend_t backend);
+
+/*
+ * fills the reader of the files named <name> into <backend>: "pread" or "io_uring"
+ * returns false for an unknown name
+ */
+bool prf_get_io_backend(const char* name, prf_io_backend_t* backend);
+
+/*
+ * returns the name of the reader of the files <backend>, f.e. "io_uring"
+ */
+const char* prf_get_io_backend_name(prf_io_backend_t backend);
+
+/*
+ * sets the interfaces reported by the per-interface getters and counted in the totals
+ * <include> and <exclude> are comma separated glob patterns, f.e. "eth*,bond*" and "veth*,lo"
+ * an interface is included if it matches any <include> pattern, or <include> is NULL or "", and no <exclude> pattern
+ */
+void prf_set_net_filters(prf_ctx_t* ctx, const char* include, const char* exclude);
 
 /*
  * prints network info, similar to /proc/net/dev
  */
-void prf_print_net_info();
+void prf_print_net_info(prf_ctx_t* ctx);
 
 /*
  * prints network interface's Rx and Tx rates (kbps), for debug purposes
  */
-void prf_print_net_rates();
+void prf_print_net_rates(prf_ctx_t* ctx);
+
+/*
+ * prints per-interface rates of the included interfaces and their totals, for debug purposes
+ */
+void prf_print_net_itf_rates(prf_ctx_t* ctx);
 
 /*
- * fills raw network Rx info into array <r>
+ * fills raw network Rx info of <interface_name> into array <r>
  * r[0] = Rx bytes
  * r[1] = Rx packets
  * r[2] = Rx errs
@@ -207,14 +1170,111 @@ void prf_print_net_rates();
  * t[6] = Tx carrier
  * t[7] = Tx compressed
  */
-void prf_get_net_raw_info(unsigned long r[8], unsigned long t[8]);
+void prf_get_net_raw_info(prf_ctx_t* ctx, unsigned long r[8], unsigned long t[8]);
 
 /*
  * fills Rx and Tx rates into array <n>
  * n[0] = Rx rate (kb/s)
  * n[1] = Tx rate (kb/s)
  */
-void prf_get_net_rate_info(float n[2]);
+void prf_get_net_rate_info(prf_ctx_t* ctx, float n[2]);
+
+/*
+ * fills up to <len> included interfaces into array <itf>, in the order of /proc/net/dev
+ * returns the number of interfaces filled
+ */
+int prf_get_net_itf_all(prf_ctx_t* ctx, prf_net_itf_t* itf, int len);
+
+/*
+ * fills the interface named exactly <name> into <itf>, regardless of the filters
+ * returns false if there is no such interface
+ */
+bool prf_get_net_itf(prf_ctx_t* ctx, const char* name, prf_net_itf_t* itf);
+
+/*
+ * fills the sums of the counters and rates of all included interfaces into <total>, named "total"
+ */
+void prf_get_net_total(prf_ctx_t* ctx, prf_net_itf_t* total);
+
+/*
+ * reads and parses /proc/diskstats
+ * all block devices go into a per-device table, see prf_set_disk_filters() for the devices reported
+ * the collector thread calls it only with <disk_enabled>
+ */
+bool prf_read_disk_info(prf_ctx_t* ctx);
+
+/*
+ * parses the contents of /proc/diskstats in <buffer> of <size> bytes in a single pass
+ * <stamp> is the CLOCK_MONOTONIC time of the read, NULL for now
+ * rates are computed over the time elapsed since the previous parse, they are 0 on the first parse
+ */
+bool prf_parse_disk_info(prf_ctx_t* ctx, const char* buffer, long size, const struct timespec* stamp);
+
+/*
+ * sets the block devices reported by the per-device getters and counted in the totals
+ * <include> and <exclude> are comma separated glob patterns, like in prf_set_net_filters()
+ * partitions, the devices missing from /sys/block, are left out unless <partitions> is true
+ */
+void prf_set_disk_filters(prf_ctx_t* ctx, const char* include, const char* exclude, bool partitions);
+
+/*
+ * prints per-device rates of the included block devices and their totals, for debug purposes
+ */
+void prf_print_disk_rates(prf_ctx_t* ctx);
+
+/*
+ * fills up to <len> included block devices into array <disk>, in the order of /proc/diskstats
+ * returns the number of devices filled
+ */
+int prf_get_disk_all(prf_ctx_t* ctx, prf_disk_t* disk, int len);
+
+/*
+ * fills the block device named exactly <name> into <disk>, regardless of the filters
+ * returns false if there is no such device
+ */
+bool prf_get_disk(prf_ctx_t* ctx, const char* name, prf_disk_t* disk);
+
+/*
+ * fills the totals of all included block devices into <total>, named "total"
+ * counters, IOPS, MB/s and queue sizes are summed, await is averaged over the I/Os of all devices
+ * and util is the one of the busiest device
+ */
+void prf_get_disk_total(prf_ctx_t* ctx, prf_disk_t* total);
+
+/*
+ * reads /proc/[pid]/stat, statm and io of the watched processes and, if enabled, of their descendants
+ * the files are opened once with openat() on a per-process directory descriptor and re-read with pread(),
+ * a process that exited is dropped from the table
+ */
+bool prf_read_pid_info(prf_ctx_t* ctx);
+
+/*
+ * adds <pid> to the watched processes, 0 for the calling process
+ * returns false if <PRF_PID_MAX> processes are watched
+ */
+bool prf_watch_pid(prf_ctx_t* ctx, pid_t pid);
+
+/*
+ * removes <pid> from the watched processes, it leaves the table on the next read
+ */
+bool prf_unwatch_pid(prf_ctx_t* ctx, pid_t pid);
+
+/*
+ * prints the resource usage of the processes in the table, for debug purposes
+ */
+void prf_print_pid_info(prf_ctx_t* ctx);
+
+/*
+ * fills up to <len> processes of the table into array <pids>, in the order they were found
+ * returns the number of processes filled
+ */
+int prf_get_pid_all(prf_ctx_t* ctx, prf_pid_t* pids, int len);
+
+/*
+ * fills the process <pid> of the table into <info>
+ * returns false if the process is not in the table
+ */
+bool prf_get_pid_info(prf_ctx_t* ctx, pid_t pid, prf_pid_t* info);
 
 /*
  * reads file <file_name> into <buffer>
@@ -224,19 +1284,69 @@ void prf_get_net_rate_info(float n[2]);
  */
 bool prf_read_file(const char* file_name, char** buffer, long* file_size);
 
+/*
+ * reads file descriptor <fd> from offset 0 into caller-owned <buffer> with a single pread() call, up to a full <buffer>:
+ * a pseudo-file of one record like /proc/loadavg or /proc/stat comes whole in one call, a seq_file of one record per
+ * line like /proc/net/dev stops short of a page, the collector reads those to the end
+ * <size> should be sized for the extra '\0' char
+ * returns the number of bytes read, -1 on error
+ */
+long prf_pread_file(int fd, char* buffer, long size);
+
+/*
+ * with the PRF_IO_BACKEND_URING <io_backend>, reads the files of the coming tick as one io_uring batch: the /proc
+ * pseudo-files, the cgroup files and the files of the watched processes are read with registered buffers, the
+ * /proc pseudo-files through registered descriptors, by a single io_uring_enter() call per round, and the readers
+ * parse the batch instead of calling pread(), a file the batch did not read is read with pread() as before
+ * a round continues the seq_files that filled a page, like /proc/net/dev, the other files take one round
+ * called by prf_perf_collect() before the readers, the ring is set up by the first call and probed for
+ * IORING_OP_READ_FIXED, Linux 5.6, without it the error is reported once and the files are read with pread()
+ * returns false if no batch is read
+ */
+bool prf_read_batch(prf_ctx_t* ctx);
+
+/*
+ * opens the /proc pseudo-files once, so that every tick re-reads them with prf_pread_file()
+ * called by prf_perf_collect(), the readers open a missing file on first use
+ */
+bool prf_open_files(prf_ctx_t* ctx);
+
+/*
+ * closes the /proc pseudo-files opened by prf_open_files(), the io_uring of prf_read_batch() and releases the growable
+ * read buffers
+ */
+void prf_close_files(prf_ctx_t* ctx);
+
+/*
+ * advances the absolute CLOCK_MONOTONIC <deadline> by <interval> and sleeps until it
+ * initialize <deadline> with clock_gettime(CLOCK_MONOTONIC, ...) before the first call
+ * if the deadline is missed by more than an <interval>, the schedule restarts from now
+ */
+void prf_sleep_until(struct timespec* deadline, const struct timespec* interval);
+
+/*
+ * fills the CLOCK_MONOTONIC times of the last reads into array <t>
+ * t[0] = /proc/loadavg
+ * t[1] = /proc/stat
+ * t[2] = /proc/meminfo
+ * t[3] = /proc/net/dev
+ */
+void prf_get_read_times(prf_ctx_t* ctx, struct timespec t[4]);
+
 /*
  * frees heap memory
  */
 void prf_free_mem(void* mem);
 
 /*
- * reports whether thread for periodic performance measurements is running or not
+ * reports whether thread for periodic performance measurements of <ctx> is running or not
  */
-bool prf_is_perf_thread_running();
+bool prf_is_perf_thread_running(prf_ctx_t* ctx);
 
 /*
- * cancels thread for periodic performance measurements
+ * cancels thread for periodic performance measurements of <ctx>, it wakes up from its sleep and returns
+ * async-signal-safe, may be called from a signal handler
  */
-void prf_cancel_perf_thread();
+void prf_cancel_perf_thread(prf_ctx_t* ctx);
 
 #endif /* _CPU_H */
@@ -1,7 +1,34 @@
+// _GNU_SOURCE is required for 'ppoll' and 'pthread_setname_np'
+#define _GNU_SOURCE
+
 #include <stdlib.h>
 #include <stdio.h>
+#include <stdint.h>
+#include <float.h>
+#include <stdatomic.h>
 #include <errno.h>
+#include <fcntl.h>
+#include <fnmatch.h>
 #include <pthread.h>
+#include <sched.h>
+#include <poll.h>
+#include <dirent.h>
+#include <sys/eventfd.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/sysinfo.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
+#include <linux/if_link.h>
+#include <linux/io_uring.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 
 #include "prf_system.h"
 
@@ -11,621 +38,6101 @@
 #define PRF_CPU_INFO_FILE       "/proc/stat"
 #define PRF_MEM_INFO_FILE       "/proc/meminfo"
 #define PRF_NET_INFO_FILE       "/proc/net/dev"
+#define PRF_DISK_INFO_FILE      "/proc/diskstats"
+#define PRF_VMSTAT_FILE         "/proc/vmstat"
+#define PRF_SOFTIRQ_FILE        "/proc/softirqs"
+#define PRF_IRQ_FILE            "/proc/interrupts"
+#define PRF_SYSINFO_CALL        "sysinfo()"
+#define PRF_PSI_DIR             "/proc/pressure"
+#define PRF_PSI_CPU_FILE        PRF_PSI_DIR "/cpu"
+#define PRF_PSI_MEMORY_FILE     PRF_PSI_DIR "/memory"
+#define PRF_PSI_IO_FILE         PRF_PSI_DIR "/io"
 #define PRF_READ_FILE           "READ: %s\n"
-#define PRF_MEM_INFO_LINE       "%-16s%12ld kB\n"
+#define PRF_MEM_INFO_LINE       "%-16s%12lu kB\n"
+#define PRF_MEM_INFO_LINE_CNT   "%-16s%12lu\n"
 #define PRF_AVG_BUFF_SIZE       256
-#define PRF_CPU_BUFF_SIZE       4096
+#define PRF_CPU_BUFF_SIZE       4096    // initial size, grown until all "cpuN" lines fit
+#define PRF_CPU_LINE_SIZE       128     // room for one "cpuN" line when sizing the buffer
 #define PRF_MEM_BUFF_SIZE       4096
-#define PRF_NET_BUFF_SIZE       4096
+#define PRF_PSI_BUFF_SIZE       256
+#define PRF_NET_BUFF_SIZE       4096    // initial size, grown until the whole file fits
+#define PRF_NL_RECV_SIZE        32768   // the largest part of an rtnetlink dump, kept free in the buffer for every recv()
+#define PRF_NL_REQ_SIZE         64      // an RTM_GETLINK request with an IFLA_IFNAME attribute
+#define PRF_MAX_PATTERNS        16
+#define PRF_DISK_BUFF_SIZE      4096    // initial size, grown until the whole file fits
+#define PRF_VMSTAT_BUFF_SIZE    8192    // initial size, grown until the whole file fits
+#define PRF_IRQ_BUFF_SIZE       16384   // initial size of both files, grown until the whole file fits
+#define PRF_URING_ENTRIES       1024    // submission queue entries, room for all slots of a batch
+#define PRF_URING_SLOT_SIZE     4096    // initial room of a file in the registered buffer, doubled when the file outgrows it
+#define PRF_URING_MISS          (-2)    // the batch did not read the descriptor
+#define PRF_DISK_SECTOR_SIZE    512     // unit of the sector counters, whatever the device's sector size
+#define PRF_DISK_ARRAY_LEN      11      // fields up to the weighted time, discard and flush stats are skipped
+#define PRF_DISK_DEF_EXCLUDE    "loop*,ram*"
+#define PRF_SYS_BLOCK_DIR       "/sys/block/"
+#define PRF_PID_DIR             "/proc/"
+#define PRF_PID_SELF            "self"
+#define PRF_CGROUP_SELF_FILE    "/proc/self/cgroup"
+#define PRF_MOUNT_INFO_FILE     "/proc/self/mountinfo"
+#define PRF_CGROUP_BUFF_SIZE    1024
+#define PRF_PID_BUFF_SIZE       1024    // a stat line
+#define PRF_PID_CHILD_BUFF_SIZE (PRF_PID_MAX * 8)   // the children of a task, up to 7 digits each
 #define PRF_NET_UNIT_CONV       0.008   // 1 byte = 8 bit, 1 kilo = 1000 : a kilobit = b * 8 / 1000  bytes
-#define PRF_MEM_ARRAY_LEN       48
+#define PRF_MEM_HASH_SIZE       256
 #define PRF_CPU_ARRAY_LEN       8
 #define PRF_NET_ARRAY_LEN       8
+#define PRF_HISTORY_DEF_LEN     1024
+#define PRF_HISTORY_MAX_LEN     16384   // bounds the stack copy of a percentile query
+#define PRF_HISTORY_DEF_EWMA_S  10.0
+#define PRF_HISTORY_PRINT_S     60.0    // window of the debug output
+#define PRF_LOAD_DEF_EWMA_1_S   1.0     // default time constants of the load estimators
+#define PRF_LOAD_DEF_EWMA_2_S   5.0
+#define PRF_LOAD_DEF_EWMA_3_S   30.0
+#define PRF_SYSINFO_REFRESH_S   1.0     // sysinfo backend: period of the /proc reads of the fields sysinfo() lacks
+#define PRF_ADAPT_NEAR          0.8     // share of the threshold that counts as near it
+#define PRF_ADAPT_CHANGE        0.1     // change per tick, as a share of the threshold, that counts as fast
+#define PRF_ADAPT_TIGHTEN       0.5     // interval factors of the adaptive mode
+#define PRF_ADAPT_BACKOFF       1.5
+#define PRF_SHM_MAGIC           0x53465250u     // "PRFS"
+#define PRF_SHM_VERSION         3               // incremented on every change of prf_shm_layout_t or prf_snapshot_t
+#define PRF_SHM_READ_TRIES      1000            // tries of a reader before it gives up, the publisher may have died mid-write
+#define PRF_REC_MAGIC           0x52465250u     // "PRFR"
+#define PRF_REC_VERSION         3               // incremented on every change of prf_rec_t or prf_snapshot_t
+#define PRF_REC_DEF_LEN         3600            // an hour of 1 second samples
+
+// comma separated include and exclude glob patterns, split in place in one allocation
+typedef struct prf_filter {
+    char*                       patterns;
+    char*                       include[PRF_MAX_PATTERNS];
+    int                         include_count;
+    char*                       exclude[PRF_MAX_PATTERNS];
+    int                         exclude_count;
+} prf_filter_t;
+
+// files of a watched process, opened with openat() on its /proc/[pid] directory
+typedef enum {
+    PRF_PID_FILE_STAT           = 0,
+    PRF_PID_FILE_STATM,
+    PRF_PID_FILE_IO,
+    PRF_PID_FILE_COUNT
+} prf_pid_file_t;
+
+// a thread in prf_gate_wait(), queued on its stack
+typedef struct prf_gate_waiter {
+    struct prf_gate_waiter*     next;
+} prf_gate_waiter_t;
+
+// admission-control gate, <lock> protects all but <ctx> and <cfg>
+struct prf_gate {
+    prf_ctx_t*                  ctx;
+    prf_gate_cfg_t              cfg;
+    pthread_mutex_t             lock;
+    pthread_cond_t              cond;               // signalled after every evaluation and admission
+    bool                        is_over[PRF_GATE_MAX_RULES];
+    bool                        is_deferring;
+    prf_gate_verdict_t          verdict;            // latest evaluation
+    float                       tokens;             // token bucket of the release rate
+    struct timespec             token_stamp;
+    prf_gate_waiter_t*          head;               // FIFO of the waiters
+    prf_gate_waiter_t*          tail;
+    int                         waiting;
+};
+
+// files of the cgroup v2, opened with openat() on its directory
+typedef enum {
+    PRF_CGROUP_FILE_CPU_MAX     = 0,
+    PRF_CGROUP_FILE_CPU_STAT,
+    PRF_CGROUP_FILE_MEM_CURRENT,
+    PRF_CGROUP_FILE_MEM_MAX,
+    PRF_CGROUP_FILE_MEM_EVENTS,
+    PRF_CGROUP_FILE_COUNT
+} prf_cgroup_file_t;
+
+// shared-memory segment of a publishing collector, versioned: a reader checks magic, version, size and metric count
+// the collector writes the snapshot and a history slot under a seqlock, odd while a write is in progress
+typedef struct prf_shm_layout {
+    _Atomic uint32_t            magic;              // stored last by the publisher, after the rest of the header
+    uint32_t                    version;
+    uint32_t                    size;
+    uint32_t                    metric_count;
+    pid_t                       pid;                // of the publisher
+    atomic_ulong                seq;
+    unsigned long               hist_count;         // samples written, the latest is at (hist_count - 1) % PRF_SHM_HISTORY_LEN
+    prf_snapshot_t              snapshot;
+    double                      hist_stamp[PRF_SHM_HISTORY_LEN];
+    float                       hist_val[PRF_METRIC_COUNT][PRF_SHM_HISTORY_LEN];
+} prf_shm_layout_t;
 
-typedef struct mem_name_value {
-    const char*                 name;   // memory type name
-    unsigned long*              slot;   // slot in return struct
-} mem_name_value_t;
-
-// running?
-static bool*                    prf_perf_is_running;
-// CFG: debug
-static bool                     prf_cfg_is_debug;
-// CFG: joinable
-static bool                     prf_cfg_is_joinable;
-// CFG: thread name
-static char*                    prf_thread_name;
-// CFG: interval
-static float                    prf_interval_seconds;
-// CFG: CPU index: cpu, cpu1, cpu2, ...
-static char*                    prf_cfg_cpu_name;
-// CFG: CPU load type: 1 | 5 | 15 indicating N min load averages
-static prf_cpu_load_t           prf_cfg_cpu_load_type;
-// CFG: CPU load average theshold
-static float                    prf_cfg_cpu_threshold;
-// current threshold
-static float*                   prf_perf_current_threshold;
-// CFG: network interface name
-static char*                    prf_cfg_interface_name;
-// load averages
-static float                    prf_load_avg[3];
-// CPU
-static unsigned long            prf_cpu[PRF_CPU_ARRAY_LEN];
-static float                    prf_cpu_pt[PRF_CPU_ARRAY_LEN];
-
-// memory
-static unsigned long            prf_kb_active;
-static unsigned long            prf_kb_anon_pages;
-static unsigned long            prf_kb_bounce;
-static unsigned long            prf_kb_main_buffers;
-static unsigned long            prf_kb_main_cached;
-static unsigned long            prf_kb_commit_limit;
-static unsigned long            prf_kb_committed_as;
-static unsigned long            prf_kb_dirty;
-static unsigned long            prf_kb_inactive;
-static unsigned long            prf_kb_mapped;
-static unsigned long            prf_kb_main_free;
-static unsigned long            prf_kb_main_total;
-static unsigned long            prf_kb_nfs_unstable;
-static unsigned long            prf_kb_pagetables;
-static unsigned long            prf_kb_swap_reclaimable;
-static unsigned long            prf_kb_swap_unreclaimable;
-static unsigned long            prf_kb_slab;
-static unsigned long            prf_kb_swap_cached;
-static unsigned long            prf_kb_swap_free;
-static unsigned long            prf_kb_swap_total;
-static unsigned long            prf_kb_vmalloc_chunk;
-static unsigned long            prf_kb_vmalloc_total;
-static unsigned long            prf_kb_vmalloc_used;
-static unsigned long            prf_kb_writeback;
-static unsigned long            prf_kb_swap_used; // derived value
-static unsigned long            prf_kb_main_used; // derived value
-
-// network
-static unsigned long            prf_net_rx[PRF_NET_ARRAY_LEN];
-static unsigned long            prf_net_tx[PRF_NET_ARRAY_LEN];
-static float                    prf_net_rx_rate;
-static float                    prf_net_tx_rate;
-static bool                     prf_cpu_warned = false;
-static bool                     prf_net_warned = false;
+// reader of a shared-memory segment
+struct prf_shm {
+    const prf_shm_layout_t*     map;
+};
+
+// header of a recording, a ring file of fixed-size records, which follow the header
+typedef struct prf_rec_header {
+    uint32_t                    magic;
+    uint32_t                    version;
+    uint32_t                    header_size;
+    uint32_t                    record_size;
+    uint32_t                    capacity;           // records
+    uint32_t                    metric_count;
+    _Atomic uint64_t            count;              // records written, the next one goes to count % capacity
+} prf_rec_header_t;
+
+// a record, a snapshot with its wall-clock time
+typedef struct prf_rec {
+    struct timespec             wall;               // CLOCK_REALTIME
+    prf_snapshot_t              snap;
+} prf_rec_t;
+
+// a process of the table with its descriptors, which stay bound to the process, not to the PID
+typedef struct prf_pid_entry {
+    prf_pid_t                   info;
+    int                         dir_fd;
+    int                         fds[PRF_PID_FILE_COUNT];
+    struct timespec             stamp;              // read time of <info>
+    bool                        is_seen;            // found by the current read
+} prf_pid_entry_t;
+
+// /proc pseudo-files kept open for the lifetime of the collector
+typedef enum {
+    PRF_FILE_LOAD_AVG           = 0,
+    PRF_FILE_CPU_INFO,
+    PRF_FILE_MEM_INFO,
+    PRF_FILE_NET_INFO,
+    PRF_FILE_PSI_CPU,                   // in the order of prf_psi_resource_t
+    PRF_FILE_PSI_MEMORY,
+    PRF_FILE_PSI_IO,
+    PRF_FILE_DISK_INFO,
+    PRF_FILE_VMSTAT,
+    PRF_FILE_SOFTIRQ,
+    PRF_FILE_IRQ,
+    PRF_FILE_COUNT
+} prf_file_t;
+
+// slots of an io_uring batch: the /proc pseudo-files, the cgroup files, then the files of the watched processes
+#define PRF_URING_CGROUP_SLOT(FILE)     (PRF_FILE_COUNT + (FILE))
+#define PRF_URING_PID_SLOT(INDEX, FILE) (PRF_FILE_COUNT + PRF_CGROUP_FILE_COUNT + (INDEX) * PRF_PID_FILE_COUNT + (FILE))
+#define PRF_URING_SLOT_COUNT            PRF_URING_PID_SLOT(PRF_PID_MAX, 0)
+
+// io_uring of the batched reads, set up with the raw system calls, its rings mapped into the process
+typedef struct prf_uring {
+    int                         fd;
+    void*                       sq_map;
+    size_t                      sq_map_size;
+    void*                       cq_map;
+    size_t                      cq_map_size;
+    struct io_uring_sqe*        sqes;
+    size_t                      sqes_size;
+    unsigned int*               sq_tail;
+    unsigned int*               sq_mask;
+    unsigned int*               sq_array;
+    unsigned int*               cq_head;
+    unsigned int*               cq_tail;
+    unsigned int*               cq_mask;
+    struct io_uring_cqe*        cqes;
+    char*                       arena;                  // the registered buffer, the slots of a batch one after the other
+    size_t                      arena_size;
+    int                         files[PRF_FILE_COUNT];  // registered descriptors of the /proc pseudo-files, -1 for none
+} prf_uring_t;
+
+// perfect hash of a /proc/meminfo key, collision-free for all keys in prf_mem_names[]
+#define PRF_MEM_HASH(KEY, LEN)  ((unsigned)((LEN) * 2 + (unsigned char)(KEY)[0] * 27 + \
+                                 (unsigned char)(KEY)[(LEN) - 1] * 15 + (unsigned char)(KEY)[(LEN) - 2]) & (PRF_MEM_HASH_SIZE - 1))
 
 /*
- * thread for collecting CPU and network statistics
+ * collector context, all state of one collector: configuration, parsing state, buffers and descriptors
+ * contexts share nothing, several collectors may run side by side in one process
  */
-void* prf_perf_collect(void* arg) {
-    prf_perf_t*                 prf_perf = (prf_perf_t*)arg;
-    struct timespec             wait_act;
-
-    // read args
-    prf_perf_is_running         = prf_perf->is_running;
-    prf_cfg_is_debug            = prf_perf->is_debug;
-    prf_cfg_is_joinable         = prf_perf->is_joinable;
-    prf_thread_name             = strdup(prf_perf->thread_name);
-    prf_interval_seconds        = (float)prf_perf->sleep_req->tv_sec +
-                                  ((float)(prf_perf->sleep_req->tv_nsec) / 1000000000.0);
-    prf_cfg_cpu_name            = prf_perf->cpu_name;
-    prf_cfg_cpu_load_type       = prf_perf->cpu_load_type;
-    prf_cfg_cpu_threshold       = prf_perf->cpu_threshold;
-    prf_perf_current_threshold  = prf_perf->current_threshold;
-    prf_cfg_interface_name      = strdup(prf_perf->interface_name);
+struct prf_ctx {
+    // collector thread, started by prf_ctx_start()
+    pthread_t                   thread;
+    bool                        is_started;
+    // running?
+    atomic_bool                 is_running;
+    // eventfd written by prf_cancel_perf_thread() to cut the sleep short
+    int                         wake_fd;
+    // CFG: debug
+    bool                        cfg_is_debug;
+    // CFG: joinable
+    bool                        cfg_is_joinable;
+    // CFG: thread name
+    char*                       thread_name;
+    // CFG: interval, adapted between <cfg_interval_min> and <cfg_interval_max> in the adaptive mode
+    struct timespec             sleep_req;
+    float                       interval_seconds;
+    float                       cfg_interval_min;   // 0 for a fixed interval
+    float                       cfg_interval_max;
+    float                       adapt_last;         // threshold source at the previous tick
+    bool                        adapt_has_last;
+    // CFG: CPU index: cpu, cpu1, cpu2, ...
+    char*                       cfg_cpu_name;
+    // CFG: CPU index as a number, -1 for the aggregate "cpu" line
+    int                         cfg_cpu_index;
+    // CFG: CPU load type: 1 | 5 | 15 indicating N min load averages
+    prf_cpu_load_t              cfg_cpu_load_type;
+    // CFG: CPU load average theshold
+    float                       cfg_cpu_threshold;
+    // CFG: value compared to the threshold
+    prf_threshold_src_t         cfg_threshold_source;
+    // CFG: network interface name
+    char*                       cfg_interface_name;
+    // CFG: glob patterns of the interfaces in the per-interface table
+    prf_filter_t                cfg_net_filter;
+    // CFG: glob patterns of the block devices in the per-device table, partitions
+    prf_filter_t                cfg_disk_filter;
+    bool                        cfg_disk_partitions;
+    // CFG: directory /proc and /sys are resolved in, -1 for "/", and the source replacing the reads, if any
+    int                         root_fd;
+    prf_source_t                cfg_source;
+    // persistent file descriptors, re-read with pread() at offset 0
+    int                         file_fds[PRF_FILE_COUNT];
+    bool                        file_warned[PRF_FILE_COUNT];    // an open error is reported once
+    // CLOCK_MONOTONIC time of the last read of each file
+    struct timespec             file_stamps[PRF_FILE_COUNT];
+    // CFG: reader of the files, with io_uring the files of a tick are read by one batch, see prf_read_batch()
+    prf_io_backend_t            cfg_io_backend;
+    prf_uring_t                 uring;
+    bool                        uring_failed;       // reported once, the files are read with pread()
+    struct timespec             uring_stamp;        // read time of the batch
+    // io_uring: the slots of the batch, <uring_fds> is -1 for a slot the batch did not read or a reader consumed
+    int                         uring_fds[PRF_URING_SLOT_COUNT];
+    long                        uring_len[PRF_URING_SLOT_COUNT];    // bytes read, -1 on error
+    long                        uring_size[PRF_URING_SLOT_COUNT];   // room of the slot, 0 before its first read
+    size_t                      uring_off[PRF_URING_SLOT_COUNT];    // position of the slot in the registered buffer
+    bool                        uring_more[PRF_URING_SLOT_COUNT];   // the slot is full, pread() reads the rest
+    // CFG: source of the load averages and the basic memory fields
+    prf_sys_backend_t           cfg_sys_backend;
+    // sysinfo backend: last reads of /proc/loadavg and /proc/meminfo for the fields sysinfo() lacks,
+    // MemFree and MemAvailable of that read, MemAvailable follows the changes of MemFree
+    struct timespec             sys_load_stamp;
+    struct timespec             sys_mem_stamp;
+    unsigned long               sys_mem_free;
+    unsigned long               sys_mem_available;
+    // load averages
+    float                       load_avg[3];
+    // runnable and total tasks, the fourth field of /proc/loadavg
+    int                         load_running;
+    int                         load_tasks;
+    // CFG: in-library load estimators, time constants in seconds
+    float                       cfg_load_ewma_s[3];
+    float                       load_ewma[3];
+    struct timespec             load_ewma_stamp;
+    bool                        load_has_ewma;
+    // CPU: the CPU selected by <cpu_name>
+    unsigned long               cpu[PRF_CPU_ARRAY_LEN];
+    float                       cpu_pt[PRF_CPU_ARRAY_LEN];
+    // CPU: aggregate "cpu" line
+    unsigned long               cpu_total[PRF_CPU_ARRAY_LEN];
+    float                       cpu_total_pt[PRF_CPU_ARRAY_LEN];
+    // CPU: "cpuN" lines, structure of arrays, one array per state indexed by core
+    unsigned long               cpu_core[PRF_CPU_ARRAY_LEN][PRF_CPU_MAX_CORES];
+    float                       cpu_core_pt[PRF_CPU_ARRAY_LEN][PRF_CPU_MAX_CORES];
+    bool                        cpu_core_seen[PRF_CPU_MAX_CORES];   // the "cpuN" line is in the last pass
+    int                         cpu_count;                          // highest N + 1
+    int                         cpu_online;                         // cores seen in the last pass
+    // CPU: growable /proc/stat buffer, sized once and reused
+    char*                       cpu_buff;
+    long                        cpu_buff_size;
+    bool                        cpu_warned;
+    // PSI: /proc/pressure/{cpu,memory,io}
+    prf_psi_t                   psi[PRF_PSI_COUNT];
+    bool                        psi_found[PRF_PSI_COUNT];
+    struct timespec             psi_stamp[PRF_PSI_COUNT];   // read time of <psi>
+    // memory
+    unsigned long               mem[PRF_MEM_FIELD_COUNT];
+    bool                        mem_found[PRF_MEM_FIELD_COUNT];
+    unsigned long               kb_swap_used; // derived value
+    unsigned long               kb_main_used; // derived value
+    // network
+    unsigned long               net_rx[PRF_NET_ARRAY_LEN];
+    unsigned long               net_tx[PRF_NET_ARRAY_LEN];
+    float                       net_rx_rate;
+    float                       net_tx_rate;
+    // network: per-interface tables of the current and the previous read
+    prf_net_itf_t               net_itfs[2][PRF_NET_MAX_ITF];
+    bool                        net_itf_included[2][PRF_NET_MAX_ITF];
+    int                         net_itf_count[2];
+    int                         net_cur;
+    int                         net_itf_index;      // position of <interface_name> in the current table
+    prf_net_itf_t               net_total;
+    struct timespec             net_stamp;          // read time of the current table
+    // network: growable /proc/net/dev buffer, sized once and reused
+    char*                       net_buff;
+    long                        net_buff_size;
+    bool                        net_warned;
+    // network: CFG: source of the counters, the persistent rtnetlink socket and its growable reply buffer
+    prf_net_backend_t           cfg_net_backend;
+    int                         nl_fd;
+    unsigned int                nl_seq;
+    char*                       nl_buff;
+    long                        nl_buff_size;
+    // network: rtnetlink names of the interface indexes, RTM_NEWSTATS messages carry only the index
+    int                         nl_index[PRF_NET_MAX_ITF];
+    char                        nl_names[PRF_NET_MAX_ITF][PRF_NET_NAME_LEN];
+    int                         nl_name_count;
+    bool                        nl_is_stale;        // re-read by the next dump, with RTM_GETLINK
+    bool                        nl_is_names_dump;   // the read in progress is an RTM_GETLINK dump
+    bool                        nl_no_stats;        // RTM_GETSTATS is refused, before Linux 4.7
+    // CFG: /proc/diskstats is read by the collector thread
+    bool                        cfg_disk_enabled;
+    // block devices: per-device tables of the current and the previous read
+    prf_disk_t                  disk_devs[2][PRF_DISK_MAX_DEV];
+    bool                        disk_included[2][PRF_DISK_MAX_DEV];
+    int                         disk_count[2];
+    int                         disk_cur;
+    prf_disk_t                  disk_total;
+    struct timespec             disk_stamp;         // read time of the current table
+    // block devices: growable /proc/diskstats buffer, sized once and reused
+    char*                       disk_buff;
+    long                        disk_buff_size;
+    // CFG: /proc/vmstat is read by the collector thread
+    bool                        cfg_vmstat_enabled;
+    // /proc/vmstat: paging, swapping and reclaim
+    char*                       vm_buff;
+    long                        vm_buff_size;
+    prf_vmstat_t                vmstat;
+    struct timespec             vm_stamp;
+    // CFG: /proc/softirqs and /proc/interrupts are read by the collector thread
+    bool                        cfg_irq_enabled;
+    // /proc/softirqs and /proc/interrupts: per-CPU columns, structure of arrays like the per-core CPU table
+    char*                       softirq_buff;
+    long                        softirq_buff_size;
+    int                         softirq_cols;
+    int                         softirq_cpus[PRF_IRQ_MAX_CPU];
+    unsigned long               softirq[PRF_SOFTIRQ_COUNT][PRF_IRQ_MAX_CPU];
+    float                       softirq_rate[PRF_SOFTIRQ_COUNT][PRF_IRQ_MAX_CPU];
+    prf_irq_dist_t              softirq_dist[PRF_SOFTIRQ_COUNT];
+    struct timespec             softirq_stamp;
+    char*                       irq_buff;
+    long                        irq_buff_size;
+    int                         irq_cols;
+    int                         irq_cpus[PRF_IRQ_MAX_CPU];
+    unsigned long               irq[PRF_IRQ_MAX_CPU];
+    float                       irq_rate[PRF_IRQ_MAX_CPU];
+    prf_irq_dist_t              irq_dist;
+    struct timespec             irq_stamp;
+    // watched processes, changed by prf_watch_pid() under <pid_lock>
+    pthread_mutex_t             pid_lock;
+    pid_t                       pid_watch[PRF_PID_MAX];
+    int                         pid_watch_count;
+    bool                        cfg_pid_descendants;
+    // processes: table of the watched processes and their descendants, in the order they were found
+    prf_pid_entry_t             pid_entries[PRF_PID_MAX];
+    int                         pid_count;
+    long                        pid_page_kb;
+    long                        pid_clk_tck;
+    bool                        pid_warned;
+    // cgroup v2: found by the first read, <cgroup_fds> are -1 for the files of disabled controllers
+    char*                       cgroup_path;
+    int                         cgroup_dir_fd;
+    int                         cgroup_fds[PRF_CGROUP_FILE_COUNT];
+    bool                        cgroup_is_probed;
+    bool                        cgroup_found;
+    prf_cgroup_t                cgroup;
+    struct timespec             cgroup_stamp;       // read time of <cgroup>
+    // snapshot published by the collector thread, protected by a seqlock: <snapshot_seq> is odd while writing
+    prf_snapshot_t              snapshot;
+    atomic_ulong                snapshot_seq;
+    // history: a ring of <hist_len> samples per metric, structure of arrays, allocated by prf_ctx_create()
+    int                         hist_len;           // power of 2
+    int                         hist_count;         // samples stored, up to <hist_len>
+    int                         hist_head;          // slot of the next sample
+    float                       hist_ewma_s;
+    double*                     hist_stamp;         // [slot]: CLOCK_MONOTONIC seconds
+    float*                      hist_val;           // [metric][slot]
+    double*                     hist_sum;           // [metric][slot]: running total before the sample
+    float*                      hist_min;           // [metric][node]: segment trees of 2 * <hist_len> nodes,
+    float*                      hist_max;           //   node 1 is the root, the leaves start at <hist_len>
+    double                      hist_total[PRF_METRIC_COUNT];   // running total after the latest sample
+    float                       hist_ewma[PRF_METRIC_COUNT];
+    // the history is written by the collector thread, protected by a seqlock like the snapshot
+    atomic_ulong                hist_seq;
+    // subscriptions, evaluated after every snapshot, <sub_fds> is -1 for a free entry
+    pthread_mutex_t             sub_lock;
+    prf_sub_t                   subs[PRF_SUB_MAX];
+    int                         sub_fds[PRF_SUB_MAX];
+    bool                        sub_is_above[PRF_SUB_MAX];
+    bool                        sub_has_fired[PRF_SUB_MAX];
+    prf_event_t                 sub_events[PRF_SUB_MAX];    // latest edge
+    // gates, evaluated after every snapshot, <gate_lock> is taken before the lock of a gate
+    pthread_mutex_t             gate_lock;
+    prf_gate_t*                 gates[PRF_GATE_MAX];
+    // CFG: shared-memory segment, mapped read-write by the publisher, NULL for none
+    char*                       cfg_shm_name;
+    prf_shm_layout_t*           shm;
+    int                         shm_fd;             // flock()-ed for the lifetime of the publisher, -1 for none
+    // recording, a mapped ring file, written by the collector or read by prf_replay_step(), NULL for none
+    prf_rec_header_t*           rec;
+    size_t                      rec_size;
+    bool                        is_replay;
+    uint64_t                    replay_next;        // index of the next record
+    uint64_t                    replay_end;         // records written when the replay started
+    double                      replay_now;         // CLOCK_MONOTONIC seconds of the replayed snapshot
+    double                      replay_offset;      // added to the stamps of the records after a reboot
+};
 
-    // init
-    prf_read_load_avg();
-    prf_read_cpu_info();
-    prf_read_mem_info();
-    prf_read_net_info();
+// /proc/meminfo keys
+static const char*              prf_mem_names[PRF_MEM_FIELD_COUNT] = {
+    [PRF_MEM_TOTAL]               = "MemTotal",
+    [PRF_MEM_FREE]                = "MemFree",
+    [PRF_MEM_AVAILABLE]           = "MemAvailable",
+    [PRF_MEM_BUFFERS]             = "Buffers",
+    [PRF_MEM_CACHED]              = "Cached",
+    [PRF_MEM_SWAP_CACHED]         = "SwapCached",
+    [PRF_MEM_ACTIVE]              = "Active",
+    [PRF_MEM_INACTIVE]            = "Inactive",
+    [PRF_MEM_ACTIVE_ANON]         = "Active(anon)",
+    [PRF_MEM_INACTIVE_ANON]       = "Inactive(anon)",
+    [PRF_MEM_ACTIVE_FILE]         = "Active(file)",
+    [PRF_MEM_INACTIVE_FILE]       = "Inactive(file)",
+    [PRF_MEM_UNEVICTABLE]         = "Unevictable",
+    [PRF_MEM_MLOCKED]             = "Mlocked",
+    [PRF_MEM_HIGH_TOTAL]          = "HighTotal",
+    [PRF_MEM_HIGH_FREE]           = "HighFree",
+    [PRF_MEM_LOW_TOTAL]           = "LowTotal",
+    [PRF_MEM_LOW_FREE]            = "LowFree",
+    [PRF_MEM_SWAP_TOTAL]          = "SwapTotal",
+    [PRF_MEM_SWAP_FREE]           = "SwapFree",
+    [PRF_MEM_ZSWAP]               = "Zswap",
+    [PRF_MEM_ZSWAPPED]            = "Zswapped",
+    [PRF_MEM_DIRTY]               = "Dirty",
+    [PRF_MEM_WRITEBACK]           = "Writeback",
+    [PRF_MEM_ANON_PAGES]          = "AnonPages",
+    [PRF_MEM_MAPPED]              = "Mapped",
+    [PRF_MEM_SHMEM]               = "Shmem",
+    [PRF_MEM_KRECLAIMABLE]        = "KReclaimable",
+    [PRF_MEM_SLAB]                = "Slab",
+    [PRF_MEM_SRECLAIMABLE]        = "SReclaimable",
+    [PRF_MEM_SUNRECLAIM]          = "SUnreclaim",
+    [PRF_MEM_KERNEL_STACK]        = "KernelStack",
+    [PRF_MEM_SHADOW_CALL_STACK]   = "ShadowCallStack",
+    [PRF_MEM_PAGE_TABLES]         = "PageTables",
+    [PRF_MEM_SEC_PAGE_TABLES]     = "SecPageTables",
+    [PRF_MEM_NFS_UNSTABLE]        = "NFS_Unstable",
+    [PRF_MEM_BOUNCE]              = "Bounce",
+    [PRF_MEM_WRITEBACK_TMP]       = "WritebackTmp",
+    [PRF_MEM_COMMIT_LIMIT]        = "CommitLimit",
+    [PRF_MEM_COMMITTED_AS]        = "Committed_AS",
+    [PRF_MEM_VMALLOC_TOTAL]       = "VmallocTotal",
+    [PRF_MEM_VMALLOC_USED]        = "VmallocUsed",
+    [PRF_MEM_VMALLOC_CHUNK]       = "VmallocChunk",
+    [PRF_MEM_PERCPU]              = "Percpu",
+    [PRF_MEM_HARDWARE_CORRUPTED]  = "HardwareCorrupted",
+    [PRF_MEM_ANON_HUGE_PAGES]     = "AnonHugePages",
+    [PRF_MEM_SHMEM_HUGE_PAGES]    = "ShmemHugePages",
+    [PRF_MEM_SHMEM_PMD_MAPPED]    = "ShmemPmdMapped",
+    [PRF_MEM_FILE_HUGE_PAGES]     = "FileHugePages",
+    [PRF_MEM_FILE_PMD_MAPPED]     = "FilePmdMapped",
+    [PRF_MEM_CMA_TOTAL]           = "CmaTotal",
+    [PRF_MEM_CMA_FREE]            = "CmaFree",
+    [PRF_MEM_UNACCEPTED]          = "Unaccepted",
+    [PRF_MEM_BALLOON]             = "Balloon",
+    [PRF_MEM_HUGE_PAGES_TOTAL]    = "HugePages_Total",
+    [PRF_MEM_HUGE_PAGES_FREE]     = "HugePages_Free",
+    [PRF_MEM_HUGE_PAGES_RSVD]     = "HugePages_Rsvd",
+    [PRF_MEM_HUGE_PAGES_SURP]     = "HugePages_Surp",
+    [PRF_MEM_HUGE_PAGE_SIZE]      = "Hugepagesize",
+    [PRF_MEM_HUGETLB]             = "Hugetlb",
+    [PRF_MEM_DIRECT_MAP_4K]       = "DirectMap4k",
+    [PRF_MEM_DIRECT_MAP_2M]       = "DirectMap2M",
+    [PRF_MEM_DIRECT_MAP_4M]       = "DirectMap4M",
+    [PRF_MEM_DIRECT_MAP_1G]       = "DirectMap1G",
+};
 
-    if (prf_cfg_is_debug) {
-        printf("INTERVAL: %6.4fs\n", prf_interval_seconds);
-        printf("%s\n", PRF_LIB_HEADER);
+// generated from prf_mem_names[] with PRF_MEM_HASH(), empty slots are 0 and fail the key comparison
+static const unsigned char      prf_mem_hash[PRF_MEM_HASH_SIZE] = {
+    [  4] = PRF_MEM_HUGE_PAGES_FREE,   // HugePages_Free
+    [  6] = PRF_MEM_HUGE_PAGES_RSVD,   // HugePages_Rsvd
+    [ 15] = PRF_MEM_ANON_PAGES,        // AnonPages
+    [ 21] = PRF_MEM_HUGE_PAGE_SIZE,    // Hugepagesize
+    [ 22] = PRF_MEM_SWAP_CACHED,       // SwapCached
+    [ 23] = PRF_MEM_ANON_HUGE_PAGES,   // AnonHugePages
+    [ 30] = PRF_MEM_SHMEM_PMD_MAPPED,  // ShmemPmdMapped
+    [ 33] = PRF_MEM_SWAP_FREE,         // SwapFree
+    [ 36] = PRF_MEM_INACTIVE,          // Inactive
+    [ 48] = PRF_MEM_SRECLAIMABLE,      // SReclaimable
+    [ 51] = PRF_MEM_BUFFERS,           // Buffers
+    [ 66] = PRF_MEM_WRITEBACK_TMP,     // WritebackTmp
+    [ 71] = PRF_MEM_COMMITTED_AS,      // Committed_AS
+    [ 72] = PRF_MEM_ACTIVE,            // Active
+    [ 76] = PRF_MEM_UNACCEPTED,        // Unaccepted
+    [ 80] = PRF_MEM_BOUNCE,            // Bounce
+    [ 88] = PRF_MEM_KRECLAIMABLE,      // KReclaimable
+    [ 92] = PRF_MEM_COMMIT_LIMIT,      // CommitLimit
+    [ 94] = PRF_MEM_CACHED,            // Cached
+    [ 95] = PRF_MEM_HIGH_TOTAL,        // HighTotal
+    [ 98] = PRF_MEM_LOW_FREE,          // LowFree
+    [100] = PRF_MEM_UNEVICTABLE,       // Unevictable
+    [105] = PRF_MEM_VMALLOC_USED,      // VmallocUsed
+    [107] = PRF_MEM_HUGE_PAGES_TOTAL,  // HugePages_Total
+    [108] = PRF_MEM_MAPPED,            // Mapped
+    [110] = PRF_MEM_MLOCKED,           // Mlocked
+    [111] = PRF_MEM_CMA_FREE,          // CmaFree
+    [121] = PRF_MEM_ZSWAP,             // Zswap
+    [125] = PRF_MEM_FREE,              // MemFree
+    [135] = PRF_MEM_SHADOW_CALL_STACK, // ShadowCallStack
+    [136] = PRF_MEM_SWAP_TOTAL,        // SwapTotal
+    [142] = PRF_MEM_AVAILABLE,         // MemAvailable
+    [147] = PRF_MEM_SHMEM,             // Shmem
+    [155] = PRF_MEM_INACTIVE_FILE,     // Inactive(file)
+    [156] = PRF_MEM_DIRECT_MAP_1G,     // DirectMap1G
+    [158] = PRF_MEM_FILE_HUGE_PAGES,   // FileHugePages
+    [161] = PRF_MEM_SUNRECLAIM,        // SUnreclaim
+    [164] = PRF_MEM_INACTIVE_ANON,     // Inactive(anon)
+    [166] = PRF_MEM_PAGE_TABLES,       // PageTables
+    [167] = PRF_MEM_KERNEL_STACK,      // KernelStack
+    [169] = PRF_MEM_NFS_UNSTABLE,      // NFS_Unstable
+    [182] = PRF_MEM_HUGE_PAGES_SURP,   // HugePages_Surp
+    [187] = PRF_MEM_DIRECT_MAP_4K,     // DirectMap4k
+    [189] = PRF_MEM_FILE_PMD_MAPPED,   // FilePmdMapped
+    [191] = PRF_MEM_ACTIVE_FILE,       // Active(file)
+    [193] = PRF_MEM_DIRTY,             // Dirty
+    [199] = PRF_MEM_PERCPU,            // Percpu
+    [200] = PRF_MEM_ACTIVE_ANON,       // Active(anon)
+    [201] = PRF_MEM_LOW_TOTAL,         // LowTotal
+    [207] = PRF_MEM_ZSWAPPED,          // Zswapped
+    [208] = PRF_MEM_HUGETLB,           // Hugetlb
+    [214] = PRF_MEM_CMA_TOTAL,         // CmaTotal
+    [221] = PRF_MEM_VMALLOC_CHUNK,     // VmallocChunk
+    [223] = PRF_MEM_VMALLOC_TOTAL,     // VmallocTotal
+    [228] = PRF_MEM_TOTAL,             // MemTotal
+    [229] = PRF_MEM_BALLOON,           // Balloon
+    [231] = PRF_MEM_WRITEBACK,         // Writeback
+    [232] = PRF_MEM_SLAB,              // Slab
+    [247] = PRF_MEM_DIRECT_MAP_2M,     // DirectMap2M
+    [248] = PRF_MEM_HIGH_FREE,         // HighFree
+    [249] = PRF_MEM_DIRECT_MAP_4M,     // DirectMap4M
+    [251] = PRF_MEM_HARDWARE_CORRUPTED, // HardwareCorrupted
+    [253] = PRF_MEM_SEC_PAGE_TABLES,   // SecPageTables
+    [255] = PRF_MEM_SHMEM_HUGE_PAGES,  // ShmemHugePages
+};
 
-        prf_print_load_avg();
-        prf_print_cpu_load();
-        prf_print_mem_info_full();
-        prf_print_net_info();
-        printf("-- %-74s --\n%s\n", PRF_PER_READS, PRF_LIB_HEADER);
-    }
+// names of the history metrics
+static const char*              prf_metric_names[PRF_METRIC_COUNT] = {
+    [PRF_METRIC_THRESHOLD]        = "threshold",
+    [PRF_METRIC_LOAD_AVG]         = "load_avg",
+    [PRF_METRIC_LOAD_EWMA]        = "load_ewma",
+    [PRF_METRIC_CPU_LOAD]         = "cpu_load",
+    [PRF_METRIC_CPU_TOTAL_LOAD]   = "cpu_total_load",
+    [PRF_METRIC_CPU_IOWAIT]       = "cpu_iowait",
+    [PRF_METRIC_CPU_BUSIEST_LOAD] = "cpu_busiest_load",
+    [PRF_METRIC_MEM_USED]         = "mem_used",
+    [PRF_METRIC_MEM_AVAILABLE]    = "mem_available",
+    [PRF_METRIC_NET_RX_RATE]      = "net_rx_rate",
+    [PRF_METRIC_NET_TX_RATE]      = "net_tx_rate",
+    [PRF_METRIC_NET_TOTAL_RX]     = "net_total_rx",
+    [PRF_METRIC_NET_TOTAL_TX]     = "net_total_tx",
+    [PRF_METRIC_PSI_CPU]          = "psi_cpu",
+    [PRF_METRIC_PSI_MEMORY]       = "psi_memory",
+    [PRF_METRIC_PSI_IO]           = "psi_io",
+    [PRF_METRIC_DISK_IOPS]        = "disk_iops",
+    [PRF_METRIC_DISK_MBPS]        = "disk_mbps",
+    [PRF_METRIC_DISK_UTIL]        = "disk_util",
+    [PRF_METRIC_CGROUP_CPU]       = "cgroup_cpu",
+    [PRF_METRIC_CGROUP_THROTTLED] = "cgroup_throttled",
+    [PRF_METRIC_CGROUP_MEMORY]    = "cgroup_memory",
+    [PRF_METRIC_VM_MAJFAULT]      = "vm_majfault",
+    [PRF_METRIC_VM_SWAP]          = "vm_swap",
+    [PRF_METRIC_VM_SCAN]          = "vm_scan",
+    [PRF_METRIC_VM_SCAN_DIRECT]   = "vm_scan_direct",
+    [PRF_METRIC_VM_ALLOCSTALL]    = "vm_allocstall",
+    [PRF_METRIC_SOFTIRQ_NET_RX]   = "softirq_net_rx",
+    [PRF_METRIC_SOFTIRQ_IMBALANCE] = "softirq_imbalance",
+    [PRF_METRIC_IRQ_IMBALANCE]    = "irq_imbalance",
+};
 
-    while (*prf_perf_is_running) {
-        nanosleep(prf_perf->sleep_req, &wait_act);
+// keys of the /proc/vmstat counters
+static const char*              prf_vm_names[PRF_VM_FIELD_COUNT] = {
+    [PRF_VM_PGMAJFAULT]           = "pgmajfault",
+    [PRF_VM_PSWPIN]               = "pswpin",
+    [PRF_VM_PSWPOUT]              = "pswpout",
+    [PRF_VM_PGSCAN_KSWAPD]        = "pgscan_kswapd",
+    [PRF_VM_PGSCAN_DIRECT]        = "pgscan_direct",
+    [PRF_VM_PGSTEAL_KSWAPD]       = "pgsteal_kswapd",
+    [PRF_VM_PGSTEAL_DIRECT]       = "pgsteal_direct",
+    [PRF_VM_ALLOCSTALL]           = "allocstall",
+};
 
-        prf_read_load_avg();
+// names of the softirq vectors, the row labels of /proc/softirqs
+static const char*              prf_softirq_names[PRF_SOFTIRQ_COUNT] = {
+    [PRF_SOFTIRQ_HI]              = "HI",
+    [PRF_SOFTIRQ_TIMER]           = "TIMER",
+    [PRF_SOFTIRQ_NET_TX]          = "NET_TX",
+    [PRF_SOFTIRQ_NET_RX]          = "NET_RX",
+    [PRF_SOFTIRQ_BLOCK]           = "BLOCK",
+    [PRF_SOFTIRQ_IRQ_POLL]        = "IRQ_POLL",
+    [PRF_SOFTIRQ_TASKLET]         = "TASKLET",
+    [PRF_SOFTIRQ_SCHED]           = "SCHED",
+    [PRF_SOFTIRQ_HRTIMER]         = "HRTIMER",
+    [PRF_SOFTIRQ_RCU]             = "RCU",
+};
 
-        if (prf_cfg_is_debug) {
-            prf_read_cpu_info();
-            prf_read_net_info();
-            prf_read_mem_info();
+// zones of the per-zone /proc/vmstat counters of older kernels, f.e. "allocstall_normal"
+static const char*              prf_vm_zones[] = {"dma", "dma32", "normal", "high", "movable", "device"};
 
-            prf_print_load_avg();
-            prf_print_cpu_pt_load();
-            prf_print_mem_info();
-            prf_print_net_rates();
-        }
+// paths of the /proc pseudo-files, indexed by prf_file_t
+static const char*              prf_file_names[PRF_FILE_COUNT] = {
+                                                PRF_LOAD_AVG_FILE,
+                                                PRF_CPU_INFO_FILE,
+                                                PRF_MEM_INFO_FILE,
+                                                PRF_NET_INFO_FILE,
+                                                PRF_PSI_CPU_FILE,
+                                                PRF_PSI_MEMORY_FILE,
+                                                PRF_PSI_IO_FILE,
+                                                PRF_DISK_INFO_FILE,
+                                                PRF_VMSTAT_FILE,
+                                                PRF_SOFTIRQ_FILE,
+                                                PRF_IRQ_FILE
+                                };
 
-        if (prf_cfg_is_joinable) {
-            float current_threshold = prf_get_current_load_avg();
-            printf("-- joined: %4.2f | is overloaded? %s\n",
-                   current_threshold, (current_threshold >= prf_cfg_cpu_threshold) ? PRF_TRUE : PRF_FALSE);
-        } else {
-            *prf_perf_current_threshold = prf_get_current_load_avg();
-        }
+// /proc pseudo-files of one record per line, a read stops at a page and the next offset continues with the following
+// records, the other files come whole in one read
+static const bool               prf_file_is_seq[PRF_FILE_COUNT] = {
+    [PRF_FILE_NET_INFO]           = true,
+    [PRF_FILE_DISK_INFO]          = true,
+    [PRF_FILE_VMSTAT]             = true,
+    [PRF_FILE_IRQ]                = true,
+};
 
-        if (prf_cfg_is_debug) {
-            printf("%s\n", PRF_LIB_HEADER);
-        }
-    }
+// files of a watched process, relative to /proc/[pid], indexed by prf_pid_file_t
+static const char*              prf_pid_file_names[PRF_PID_FILE_COUNT] = {
+    [PRF_PID_FILE_STAT]           = "stat",
+    [PRF_PID_FILE_STATM]          = "statm",
+    [PRF_PID_FILE_IO]             = "io",
+};
 
-    return NULL;
-}
+// files of the cgroup v2, relative to its directory, indexed by prf_cgroup_file_t
+static const char*              prf_cgroup_file_names[PRF_CGROUP_FILE_COUNT] = {
+    [PRF_CGROUP_FILE_CPU_MAX]     = "cpu.max",
+    [PRF_CGROUP_FILE_CPU_STAT]    = "cpu.stat",
+    [PRF_CGROUP_FILE_MEM_CURRENT] = "memory.current",
+    [PRF_CGROUP_FILE_MEM_MAX]     = "memory.max",
+    [PRF_CGROUP_FILE_MEM_EVENTS]  = "memory.events",
+};
 
-bool prf_read_load_avg() {
-    bool    status = false;
-    long    size   = PRF_AVG_BUFF_SIZE;
-    char    buff[size];
-    char*   p_buff = buff;
+// names of the threshold sources
+static const char*              prf_threshold_names[PRF_THRESHOLD_SOURCE_COUNT] = {
+    [PRF_THRESHOLD_LOAD_AVG]      = "load_avg",
+    [PRF_THRESHOLD_PSI_CPU]       = "psi_cpu",
+    [PRF_THRESHOLD_PSI_MEMORY]    = "psi_memory",
+    [PRF_THRESHOLD_PSI_IO]        = "psi_io",
+    [PRF_THRESHOLD_CGROUP_CPU]    = "cgroup_cpu",
+    [PRF_THRESHOLD_CGROUP_MEMORY] = "cgroup_memory",
+};
 
-    prf_load_avg[0] = prf_load_avg[1] = prf_load_avg[2] = 0.0;
+// names of the sources of the load averages and the basic memory fields
+static const char*              prf_sys_backend_names[PRF_SYS_BACKEND_COUNT] = {
+    [PRF_SYS_BACKEND_PROC]        = "proc",
+    [PRF_SYS_BACKEND_SYSINFO]     = "sysinfo",
+};
 
-    if (prf_read_file(PRF_LOAD_AVG_FILE, &p_buff, &size)) {
-        sscanf(buff, "%f %f %f",
-                      &prf_load_avg[0], &prf_load_avg[1], &prf_load_avg[2]);
-        status = true;
-    }
+// names of the sources of the interface counters
+static const char*              prf_net_backend_names[PRF_NET_BACKEND_COUNT] = {
+    [PRF_NET_BACKEND_PROC]        = "proc",
+    [PRF_NET_BACKEND_NETLINK]     = "netlink",
+};
 
-    return status;
-}
+// names of the readers of the files
+static const char*              prf_io_backend_names[PRF_IO_BACKEND_COUNT] = {
+    [PRF_IO_BACKEND_PREAD]        = "pread",
+    [PRF_IO_BACKEND_URING]        = "io_uring",
+};
 
-void prf_print_load_avg() {
-    printf("READ: %s\n\
-Load average: %4.2f, %4.2f, %4.2f\n%s\n",
-           PRF_LOAD_AVG_FILE,
-           prf_load_avg[0], prf_load_avg[1], prf_load_avg[2],
-           PRF_LIB_HEADER);
+/*
+ * opens the absolute <path> with <flags>, resolved in the directory <source_root> if there is one
+ */
+static int prf_open_root(prf_ctx_t* ctx, const char* path, int flags) {
+    return (ctx->root_fd < 0) ? open(path, flags) : openat(ctx->root_fd, path + (path[0] == '/'), flags);
 }
 
-void prf_get_load_avg(float v[3]) {
-    memcpy(v, prf_load_avg, sizeof(prf_load_avg));
+/*
+ * opens the absolute <path> as a stream, resolved in the directory <source_root> if there is one
+ */
+static FILE* prf_fopen_root(prf_ctx_t* ctx, const char* path) {
+    int     fd = prf_open_root(ctx, path, O_RDONLY | O_CLOEXEC);
+    FILE*   fl = (fd >= 0) ? fdopen(fd, "r") : NULL;
+
+    if (fd >= 0 && fl == NULL) {
+        close(fd);
+    }
+
+    return fl;
 }
 
-float prf_get_current_load_avg() {
-    float   threshold;
-    float   v[3];
+/*
+ * opens the /proc pseudo-file <file> unless it is already open, or a source replaces the files
+ */
+static bool prf_open_proc_file(prf_ctx_t* ctx, prf_file_t file) {
+    if (ctx->cfg_source.read != NULL) {
+        return true;
+    }
 
-    prf_get_load_avg(v);
+    if (ctx->file_fds[file] < 0) {
+        ctx->file_fds[file] = prf_open_root(ctx, prf_file_names[file], O_RDONLY | O_CLOEXEC);
+        if (ctx->file_fds[file] < 0) {
+            if (!ctx->file_warned[file]) {
+                ctx->file_warned[file] = true;
+                fprintf(stderr, "** ERROR - unable to open file '%s'\n", prf_file_names[file]);
+            }
+            return false;
+        }
+    }
 
-    switch (prf_cfg_cpu_load_type) {
-        case TYPE_MIN_1:
-            threshold = v[0];
-            break;
+    return true;
+}
 
-        case TYPE_MIN_5:
-            threshold = v[1];
-            break;
+/*
+ * continues the read of descriptor <fd> into <buffer>, which holds <total> bytes from offset 0, until a full
+ * <buffer>: a seq_file of one record per line <is_seq> with pread() calls until the end of the file, another file
+ * with a single call, see prf_pread_file()
+ * returns the number of bytes read, -1 on error
+ */
+static long prf_pread_from(int fd, char* buffer, long size, long total, bool is_seq) {
+    ssize_t     len;
 
-        case TYPE_MIN_15:
-            threshold = v[2];
-            break;
+    // pseudo-files are generated on read, a read at offset 0 returns a fresh copy
+    // a seq_file stops at a page, the next offset continues with the following records,
+    // a file of one record comes whole in one read, as much of it as fits
+    do {
+        len = pread(fd, buffer + total, size - 1 - total, total);
+        if (len > 0) {
+            total += len;
+        }
+    } while ((len > 0 && total < size - 1 && is_seq) || (len < 0 && errno == EINTR));
 
-        default:
-            threshold = v[1];
-            break;
+    if (len < 0 && total == 0) {
+        buffer[0] = '\0';
+        return -1;
     }
 
-    return threshold;
+    buffer[total] = '\0';
+
+    return total;
 }
 
-bool prf_is_valid_load_avg_val(int val) {
-    switch (val) {
-        case TYPE_MIN_1:
-        case TYPE_MIN_5:
-        case TYPE_MIN_15:
-            return true;
-            break;
+/*
+ * unmaps the rings of the io_uring of the batched reads and closes it, the slots are forgotten
+ */
+static void prf_uring_close(prf_ctx_t* ctx) {
+    prf_uring_t*    ring = &ctx->uring;
 
-        default:
-            return false;
-            break;
+    if (ring->arena != NULL) {
+        munmap(ring->arena, ring->arena_size);
+    }
+    if (ring->sqes != NULL) {
+        munmap(ring->sqes, ring->sqes_size);
+    }
+    if (ring->cq_map != NULL) {
+        munmap(ring->cq_map, ring->cq_map_size);
+    }
+    if (ring->sq_map != NULL) {
+        munmap(ring->sq_map, ring->sq_map_size);
+    }
+    if (ring->fd >= 0) {
+        close(ring->fd);
     }
-}
 
-bool prf_read_cpu_info() {
-#define TRIMz(x)  ((tz = (long)(x)) < 0 ? 0 : tz)
+    memset(ring, 0, sizeof(*ring));
+    ring->fd = -1;
+    for (int i = 0; i < PRF_FILE_COUNT; i++) {
+        ring->files[i] = -1;
+    }
 
-    bool            status      = false;
-    long            size        = PRF_CPU_BUFF_SIZE;
-    char            buff[size];
-    char*           p_buff      = buff;
-    unsigned long   u_frme      = 0;
-    unsigned long   s_frme      = 0;
-    unsigned long   n_frme      = 0;
-    unsigned long   i_frme      = 0;
-    unsigned long   w_frme      = 0;
-    unsigned long   x_frme      = 0;
-    unsigned long   y_frme      = 0;
-    unsigned long   z_frme      = 0;
-    unsigned long   tot_frme    = 0;
-    unsigned long   tz          = 0;
-    float           scale       = 0.0;
-    unsigned long   cpu_new[PRF_CPU_ARRAY_LEN];
-    char*           cpu;
+    for (int i = 0; i < PRF_URING_SLOT_COUNT; i++) {
+        ctx->uring_fds[i] = -1;
+    }
+}
 
-    if (prf_read_file(PRF_CPU_INFO_FILE, &p_buff, &size)) {
-        cpu = strstr(buff, prf_cfg_cpu_name);
-        if (cpu) {
-            // advance the size of the CPU
-            cpu += strlen(prf_cfg_cpu_name);
+/*
+ * reports the io_uring error of <action> once and reads the files with pread() from now on
+ * returns false
+ */
+static bool prf_uring_fail(prf_ctx_t* ctx, const char* action) {
+    fprintf(stderr, "** ERROR - unable to %s io_uring: %s, the files are read with pread()\n", action, strerror(errno));
 
-            sscanf(cpu, "%lu %lu %lu %lu %lu %lu %lu %lu",
-                         &cpu_new[0], &cpu_new[1], &cpu_new[2], &cpu_new[3],
-                         &cpu_new[4], &cpu_new[5], &cpu_new[6], &cpu_new[7]);
+    ctx->uring_failed = true;
+    prf_uring_close(ctx);
 
-            // calculate CPU load
-            u_frme = cpu_new[0] - prf_cpu[0];
-            s_frme = cpu_new[1] - prf_cpu[1];
-            n_frme = cpu_new[2] - prf_cpu[2];
-            i_frme = TRIMz(cpu_new[3] - prf_cpu[3]);
-            w_frme = cpu_new[4] - prf_cpu[4];
-            x_frme = cpu_new[5] - prf_cpu[5];
-            y_frme = cpu_new[6] - prf_cpu[6];
-            z_frme = cpu_new[7] - prf_cpu[7];
+    return false;
+}
 
-            tot_frme = u_frme + s_frme + n_frme + i_frme + w_frme + x_frme + y_frme + z_frme;
+/*
+ * sets up the io_uring of the batched reads: maps its rings, probes IORING_OP_READ_FIXED and registers an empty table
+ * of the descriptors of the /proc pseudo-files
+ * returns false if io_uring is unavailable, f.e. before Linux 5.6, disabled by kernel.io_uring_disabled or seccomp
+ */
+static bool prf_uring_open(prf_ctx_t* ctx) {
+    prf_uring_t*            ring    = &ctx->uring;
+    struct io_uring_params  params;
+    struct io_uring_probe*  probe;
+    size_t                  probe_size  = sizeof(struct io_uring_probe) + IORING_OP_LAST * sizeof(struct io_uring_probe_op);
+    bool                    is_read_fixed;
+    long                    ret;
 
-            if (tot_frme < 1) {
-                tot_frme = 1;
-            }
+    memset(&params, 0, sizeof(params));
+    ring->fd = (int)syscall(__NR_io_uring_setup, PRF_URING_ENTRIES, &params);
+    if (ring->fd < 0) {
+        return false;
+    }
 
-            scale = 100.0 / (float)tot_frme;
+    ring->sq_map_size   = params.sq_off.array + params.sq_entries * sizeof(unsigned int);
+    ring->cq_map_size   = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    ring->sqes_size     = params.sq_entries * sizeof(struct io_uring_sqe);
 
-            prf_cpu_pt[0] = (float)u_frme * scale;
-            prf_cpu_pt[1] = (float)n_frme * scale;
-            prf_cpu_pt[2] = (float)s_frme * scale;
-            prf_cpu_pt[3] = (float)i_frme * scale;
-            prf_cpu_pt[4] = (float)w_frme * scale;
-            prf_cpu_pt[5] = (float)x_frme * scale;
-            prf_cpu_pt[6] = (float)y_frme * scale;
-            prf_cpu_pt[7] = (float)z_frme * scale;
+    ring->sq_map = mmap(NULL, ring->sq_map_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                        ring->fd, IORING_OFF_SQ_RING);
+    ring->cq_map = mmap(NULL, ring->cq_map_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                        ring->fd, IORING_OFF_CQ_RING);
+    ring->sqes   = mmap(NULL, ring->sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                        ring->fd, IORING_OFF_SQES);
+    ring->sq_map = (ring->sq_map != MAP_FAILED) ? ring->sq_map : NULL;
+    ring->cq_map = (ring->cq_map != MAP_FAILED) ? ring->cq_map : NULL;
+    ring->sqes   = (ring->sqes != MAP_FAILED) ? ring->sqes : NULL;
+    if (ring->sq_map == NULL || ring->cq_map == NULL || ring->sqes == NULL) {
+        return false;
+    }
 
-            // store last read values
-            memcpy(prf_cpu, cpu_new, sizeof(cpu_new));
+    ring->sq_tail   = (unsigned int*)((char*)ring->sq_map + params.sq_off.tail);
+    ring->sq_mask   = (unsigned int*)((char*)ring->sq_map + params.sq_off.ring_mask);
+    ring->sq_array  = (unsigned int*)((char*)ring->sq_map + params.sq_off.array);
+    ring->cq_head   = (unsigned int*)((char*)ring->cq_map + params.cq_off.head);
+    ring->cq_tail   = (unsigned int*)((char*)ring->cq_map + params.cq_off.tail);
+    ring->cq_mask   = (unsigned int*)((char*)ring->cq_map + params.cq_off.ring_mask);
+    ring->cqes      = (struct io_uring_cqe*)((char*)ring->cq_map + params.cq_off.cqes);
 
-            status = true;
-        } else {
-            if (!prf_cpu_warned) {
-                prf_cpu_warned = true;
-                fprintf(stderr, "** ERROR - unable to find the CPU '%s'\n", prf_cfg_cpu_name);
-            }
-        }
+    // IORING_REGISTER_PROBE arrived with Linux 5.6, after IORING_OP_READ_FIXED and the sparse descriptor tables
+    probe = (struct io_uring_probe*)calloc(1, probe_size);
+    if (probe == NULL) {
+        errno = ENOMEM;
+        return false;
     }
 
-    return status;
-}
+    ret           = syscall(__NR_io_uring_register, ring->fd, IORING_REGISTER_PROBE, probe, IORING_OP_LAST);
+    is_read_fixed = (ret >= 0 && probe->last_op >= IORING_OP_READ_FIXED &&
+                     (probe->ops[IORING_OP_READ_FIXED].flags & IO_URING_OP_SUPPORTED) != 0);
+    free(probe);
+    if (!is_read_fixed) {
+        errno = (ret < 0) ? errno : EOPNOTSUPP;
+        return false;
+    }
 
-void prf_print_cpu_load() {
-    printf("READ: %s\n%s: %ld, %ld, %ld, %ld, %ld, %ld, %ld, %ld\n%s\n",
-            PRF_CPU_INFO_FILE,
-            prf_cfg_cpu_name,
-            prf_cpu[0], prf_cpu[1], prf_cpu[2], prf_cpu[3],
-            prf_cpu[4], prf_cpu[5], prf_cpu[6], prf_cpu[7],
-            PRF_LIB_HEADER);
+    return syscall(__NR_io_uring_register, ring->fd, IORING_REGISTER_FILES, ring->files, PRF_FILE_COUNT) >= 0;
 }
 
-// modelled after top's CPU line, example:
-// Cpu(s):  1.3%us, 28.0%sy,  0.0%ni, 70.3%id,  0.0%wa,  0.3%hi,  0.0%si,  0.0%st
-void prf_print_cpu_pt_load() {
-    printf("READ: %s\nCpu: %6.1f%%us, %6.1f%%sy, %6.1f%%ni, %6.1f%%id, %6.1f%%wa, %6.1f%%hi, %6.1f%%si, %6.1f%%st\n%s\n",
-            PRF_CPU_INFO_FILE,
-            prf_cpu_pt[0], prf_cpu_pt[1], prf_cpu_pt[2], prf_cpu_pt[3],
-            prf_cpu_pt[4], prf_cpu_pt[5], prf_cpu_pt[6], prf_cpu_pt[7],
-            PRF_LIB_HEADER);
-}
+/*
+ * registers a buffer of at least <size> bytes for the slots of a batch, replacing the smaller one
+ * returns false on error
+ */
+static bool prf_uring_set_arena(prf_ctx_t* ctx, size_t size) {
+    prf_uring_t*    ring    = &ctx->uring;
+    size_t          page    = (size_t)sysconf(_SC_PAGESIZE);
+    struct iovec    iov;
 
-void prf_get_cpu_raw_info(unsigned long c[PRF_CPU_ARRAY_LEN]) {
-    memcpy(c, prf_cpu, sizeof(prf_cpu));
-}
+    if (ring->arena != NULL) {
+        size = (size > ring->arena_size * 2) ? size : ring->arena_size * 2;
+        syscall(__NR_io_uring_register, ring->fd, IORING_UNREGISTER_BUFFERS, NULL, 0);
+        munmap(ring->arena, ring->arena_size);
+        ring->arena         = NULL;
+        ring->arena_size    = 0;
+    }
 
-void prf_get_cpu_pt_info(float p[PRF_CPU_ARRAY_LEN]) {
-    memcpy(p, prf_cpu_pt, sizeof(prf_cpu_pt));
-}
+    size = (size + page - 1) / page * page;
+    iov.iov_base = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_POPULATE, -1, 0);
+    if (iov.iov_base == MAP_FAILED) {
+        return false;
+    }
+    iov.iov_len = size;
 
-float prf_get_cpu_idle() {
-   return prf_cpu_pt[3];
-}
+    ring->arena         = iov.iov_base;
+    ring->arena_size    = size;
 
-float prf_get_cpu_load() {
-   return (100.0 - prf_cpu_pt[3]);
+    // pinned pages, charged to RLIMIT_MEMLOCK before Linux 5.12
+    return syscall(__NR_io_uring_register, ring->fd, IORING_REGISTER_BUFFERS, &iov, 1) >= 0;
 }
 
-bool prf_read_mem_info() {
-    bool                    status          = false;
-    char*                   namebuf;
-    mem_name_value_t        find_me;
-    mem_name_value_t*       found;
-    long                    size            = PRF_MEM_BUFF_SIZE;
-    char                    buff[size];
-    char*                   p_buff          = buff;
-    char*                   head;
-    char*                   delim;
-    int                     check           = false;
-    char*                   delim_line      = "\n";
-    char*                   delim_param     = ":";
-    // https://www.gnu.org/software/libc/manual/html_node/Array-Search-Function.html
-    // The bsearch function searches the sorted array <array> for an object that is equivalent to <key>.
-    mem_name_value_t        mem_data[]      = {
-                                                {"Active",          &prf_kb_active},
-                                                {"AnonPages",       &prf_kb_anon_pages},
-                                                {"Bounce",          &prf_kb_bounce},
-                                                {"Buffers",         &prf_kb_main_buffers},
-                                                {"Cached",          &prf_kb_main_cached},
-                                                {"CommitLimit",     &prf_kb_commit_limit},
-                                                {"Committed_AS",    &prf_kb_committed_as},
-                                                {"Dirty",           &prf_kb_dirty},
-                                                {"Inactive",        &prf_kb_inactive},
-                                                {"Mapped",          &prf_kb_mapped},
-                                                {"MemFree",         &prf_kb_main_free},
-                                                {"MemTotal",        &prf_kb_main_total},
-                                                {"NFS_Unstable",    &prf_kb_nfs_unstable},
-                                                {"PageTables",      &prf_kb_pagetables},
-                                                {"SReclaimable",    &prf_kb_swap_reclaimable},
-                                                {"SUnreclaim",      &prf_kb_swap_unreclaimable},
-                                                {"Slab",            &prf_kb_slab},
-                                                {"SwapCached",      &prf_kb_swap_cached},
-                                                {"SwapFree",        &prf_kb_swap_free},
-                                                {"SwapTotal",       &prf_kb_swap_total},
-                                                {"VmallocChunk",    &prf_kb_vmalloc_chunk},
-                                                {"VmallocTotal",    &prf_kb_vmalloc_total},
-                                                {"VmallocUsed",     &prf_kb_vmalloc_used},
-                                                {"Writeback",       &prf_kb_writeback}
-                                           };
-
-    if (prf_read_file(PRF_MEM_INFO_FILE, &p_buff, &size)) {
-        char* rest_line = NULL;
-        for (char* line = strtok_r(buff, delim_line, &rest_line);
-            line != NULL;
-            line = strtok_r(NULL, delim_line, &rest_line)) {
-            char* p_delim   = strstr(line, delim_param);
-            // turn string <line> into <name> and <value> strings
-            *p_delim        = '\0';
-            char* p_name    = line;
-            char* p_value   = p_delim + 1;
-
-            find_me.name    = p_name;
-            found           = (mem_name_value_t*)bsearch(&find_me, mem_data, sizeof(mem_data) / sizeof(mem_name_value_t),
-                                                         sizeof(mem_data[0]), prf_compare_mem_table_structs);
-
-            if (found) {
-                *(found->slot) = strtoull(p_value, NULL, 10);
-            }
-        }
-
-        // derived
-        prf_kb_swap_used = prf_kb_swap_total - prf_kb_swap_free;
-        prf_kb_main_used = prf_kb_main_total - prf_kb_main_free;
-
-        p_buff = NULL;
+/*
+ * brings the registered table of the descriptors of the /proc pseudo-files up to date, in a single call
+ * returns false on error
+ */
+static bool prf_uring_set_files(prf_ctx_t* ctx) {
+    prf_uring_t*                    ring    = &ctx->uring;
+    struct io_uring_files_update    update;
+    int                             first   = -1;
+    int                             last    = -1;
 
-        status = true;
+    for (int i = 0; i < PRF_FILE_COUNT; i++) {
+        if (ring->files[i] != ctx->file_fds[i]) {
+            first = (first < 0) ? i : first;
+            last  = i;
+        }
     }
 
-    return status;
-}
+    if (first < 0) {
+        return true;
+    }
 
-// modelled after top's memory lines, example:
-// Mem:    767684k total,   748792k used,    18892k free,   108260k buffers
-// Swap:   831480k total,        0k used,   831480k free,   294848k cached
-void prf_print_mem_info() {
-    printf("READ: %s\n\
-Mem: %9ldk total, %8ldk used, %8ldk free, %8ldk buffers\n\
-Swap: %8ldk total, %8ldk used, %8ldk free, %8ldk cached\n%s\n",
-        PRF_MEM_INFO_FILE,
-        prf_kb_main_total, prf_kb_main_used, prf_kb_main_free, prf_kb_main_buffers,
-        prf_kb_swap_total, prf_kb_swap_used, prf_kb_swap_free, prf_kb_main_cached,
-        PRF_LIB_HEADER);
-}
+    memset(&update, 0, sizeof(update));
+    update.offset   = first;
+    update.fds      = (uint64_t)(uintptr_t)&ctx->file_fds[first];
+    if (syscall(__NR_io_uring_register, ring->fd, IORING_REGISTER_FILES_UPDATE, &update, last - first + 1) < 0) {
+        return false;
+    }
 
-void prf_print_mem_info_full() {
-    printf("READ: %s\n", PRF_MEM_INFO_FILE);
-    printf(PRF_MEM_INFO_LINE \
-           PRF_MEM_INFO_LINE \
-           PRF_MEM_INFO_LINE \
-           PRF_MEM_INFO_LINE \
-           PRF_MEM_INFO_LINE \
-           PRF_MEM_INFO_LINE \
-           PRF_MEM_INFO_LINE \
-           PRF_MEM_INFO_LINE \
-           PRF_MEM_INFO_LINE \
-           PRF_MEM_INFO_LINE \
-           PRF_MEM_INFO_LINE \
-           PRF_MEM_INFO_LINE \
-           PRF_MEM_INFO_LINE \
-           PRF_MEM_INFO_LINE \
-           PRF_MEM_INFO_LINE \
-           PRF_MEM_INFO_LINE \
-           PRF_MEM_INFO_LINE \
-           PRF_MEM_INFO_LINE \
-           PRF_MEM_INFO_LINE \
-           PRF_MEM_INFO_LINE \
-           PRF_MEM_INFO_LINE \
-           PRF_MEM_INFO_LINE \
-           PRF_MEM_INFO_LINE \
-           PRF_MEM_INFO_LINE,
-           "Active:",           prf_kb_active,
-           "AnonPages:",        prf_kb_anon_pages,
-           "Bounce:",           prf_kb_bounce,
-           "Buffers:",          prf_kb_main_buffers,
-           "Cached:",           prf_kb_main_cached,
-           "CommitLimit:",      prf_kb_commit_limit,
-           "Committed_AS:",     prf_kb_committed_as,
-           "Dirty:",            prf_kb_dirty,
-           "Inactive:",         prf_kb_inactive,
-           "Mapped:",           prf_kb_mapped,
-           "MemFree:",          prf_kb_main_free,
-           "MemTotal:",         prf_kb_main_total,
-           "NFS_Unstable:",     prf_kb_nfs_unstable,
-           "PageTables:",       prf_kb_pagetables,
-           "SReclaimable:",     prf_kb_swap_reclaimable,
-           "SUnreclaim:",       prf_kb_swap_unreclaimable,
-           "Slab:",             prf_kb_slab,
-           "SwapCached:",       prf_kb_swap_cached,
-           "SwapFree:",         prf_kb_swap_free,
-           "SwapTotal:",        prf_kb_swap_total,
-           "VmallocChunk:",     prf_kb_vmalloc_chunk,
-           "VmallocTotal:",     prf_kb_vmalloc_total,
-           "VmallocUsed:",      prf_kb_vmalloc_used,
-           "Writeback:",        prf_kb_writeback);
-    printf("%s\n", PRF_LIB_HEADER);
-}
+    memcpy(&ring->files[first], &ctx->file_fds[first], (last - first + 1) * sizeof(int));
 
-int prf_compare_mem_table_structs(const void* a, const void* b) {
-    return strcmp(((const mem_name_value_t*)a)->name, ((const mem_name_value_t*)b)->name);
+    return true;
 }
 
-void prf_get_current_mem_info(unsigned long m[8]) {
-    m[0] = prf_kb_main_total;
-    m[1] = prf_kb_main_used;
-    m[2] = prf_kb_main_free;
-    m[3] = prf_kb_main_buffers;
-    m[4] = prf_kb_swap_total;
-    m[5] = prf_kb_swap_used;
-    m[6] = prf_kb_swap_free;
-    m[7] = prf_kb_main_cached;
+/*
+ * reports whether the readers of a tick read the /proc pseudo-file <file>, the sysinfo and rtnetlink backends
+ * replace theirs and read them at most once a second, the files of a disabled collector are not read
+ */
+static bool prf_uring_is_batched(prf_ctx_t* ctx, prf_file_t file) {
+    switch (file) {
+    case PRF_FILE_DISK_INFO:
+        return ctx->cfg_disk_enabled;
+    case PRF_FILE_VMSTAT:
+        return ctx->cfg_vmstat_enabled;
+    case PRF_FILE_SOFTIRQ:
+    case PRF_FILE_IRQ:
+        return ctx->cfg_irq_enabled;
+    case PRF_FILE_LOAD_AVG:
+    case PRF_FILE_MEM_INFO:
+        return ctx->cfg_sys_backend != PRF_SYS_BACKEND_SYSINFO;
+    case PRF_FILE_NET_INFO:
+        return ctx->cfg_net_backend != PRF_NET_BACKEND_NETLINK;
+    default:
+        return true;
+    }
 }
 
-bool prf_read_net_info() {
-    bool                    status          = false;
-    long                    size            = PRF_NET_BUFF_SIZE;
-    char                    buff[size];
-    char*                   p_buff          = buff;
-    char*                   eth;
-    unsigned long           net_new_rx[PRF_NET_ARRAY_LEN];
-    unsigned long           net_new_tx[PRF_NET_ARRAY_LEN];
-
-    if (prf_read_file(PRF_NET_INFO_FILE, &p_buff, &size)) {
-        eth = strstr(buff, prf_cfg_interface_name);
-        if (eth) {
-            // advance the size of the interface
-            eth += strlen(prf_cfg_interface_name);
-
-            sscanf(eth, ": %lu %lu %lu %lu %lu %lu %lu %lu %lu %lu %lu %lu %lu %lu %lu %lu",
-                         &net_new_rx[0], &net_new_rx[1], &net_new_rx[2], &net_new_rx[3],
-                         &net_new_rx[4], &net_new_rx[5], &net_new_rx[6], &net_new_rx[7],
-                         &net_new_tx[0], &net_new_tx[1], &net_new_tx[2], &net_new_tx[3],
-                         &net_new_tx[4], &net_new_tx[5], &net_new_tx[6], &net_new_tx[7]);
-
-            if (prf_interval_seconds > 0.0) {
-                prf_net_rx_rate = (float)(((net_new_rx[0] - prf_net_rx[0]) / prf_interval_seconds) * PRF_NET_UNIT_CONV);
-                prf_net_tx_rate = (float)(((net_new_tx[0] - prf_net_tx[0]) / prf_interval_seconds) * PRF_NET_UNIT_CONV);
-            } else {
-                prf_net_rx_rate = 0.0;
-                prf_net_tx_rate = 0.0;
-            }
+/*
+ * adds slot <slot> reading descriptor <fd> to the batch <slots> of <*count>
+ */
+static void prf_uring_add(prf_ctx_t* ctx, int* slots, int* count, int slot, int fd) {
+    if (ctx->uring_size[slot] == 0) {
+        ctx->uring_size[slot] = (slot >= PRF_URING_PID_SLOT(0, 0)) ? PRF_PID_BUFF_SIZE : PRF_URING_SLOT_SIZE;
+    }
 
-            // store last read values
-            memcpy(prf_net_rx, net_new_rx, sizeof(net_new_rx));
-            memcpy(prf_net_tx, net_new_tx, sizeof(net_new_tx));
+    ctx->uring_fds[slot]    = fd;
+    ctx->uring_len[slot]    = 0;
+    ctx->uring_more[slot]   = false;
+    slots[(*count)++]       = slot;
+}
+
+/*
+ * submits a round of the batch: a read of each slot of <slots> after the bytes read by the previous rounds,
+ * and waits for all of them with the same io_uring_enter() call
+ * returns false on error
+ */
+static bool prf_uring_submit(prf_ctx_t* ctx, const int* slots, int count) {
+    prf_uring_t*            ring    = &ctx->uring;
+    unsigned int            tail    = *ring->sq_tail;
+    unsigned int            mask    = *ring->sq_mask;
+    unsigned int            index;
+    struct io_uring_sqe*    sqe;
+    int                     slot;
+    long                    ret;
 
-            p_buff  = NULL;
-            eth     = NULL;
+    for (int i = 0; i < count; i++, tail++) {
+        slot    = slots[i];
+        index   = tail & mask;
+        sqe     = &ring->sqes[index];
 
-            status = true;
+        memset(sqe, 0, sizeof(*sqe));
+        sqe->opcode     = IORING_OP_READ_FIXED;
+        sqe->addr       = (uint64_t)(uintptr_t)(ring->arena + ctx->uring_off[slot] + ctx->uring_len[slot]);
+        sqe->len        = (unsigned int)(ctx->uring_size[slot] - ctx->uring_len[slot]);
+        sqe->off        = (uint64_t)ctx->uring_len[slot];
+        sqe->buf_index  = 0;
+        sqe->user_data  = (uint64_t)slot;
+        if (slot < PRF_FILE_COUNT) {
+            // index into the registered table, no file lookup per read
+            sqe->fd     = slot;
+            sqe->flags  = IOSQE_FIXED_FILE;
         } else {
-            if (!prf_net_warned) {
-                prf_net_warned = true;
-                fprintf(stderr, "** ERROR - unable to find the interface '%s'\n", prf_cfg_interface_name);
-            }
+            sqe->fd     = ctx->uring_fds[slot];
         }
+
+        ring->sq_array[index] = index;
     }
 
-    return status;
-}
+    __atomic_store_n(ring->sq_tail, tail, __ATOMIC_RELEASE);
 
-// modelled after /proc/net/dev, example:
-//Inter-|   Receive                                                |  Transmit
-// face |bytes    packets errs drop fifo frame compressed multicast|bytes    packets errs drop fifo colls carrier compressed
-//    lo:     720      12    0    0    0     0          0         0      720      12    0    0    0     0       0          0
-//  eth0:   11031      34    0    0    0     0          0         0     5996      48    0    0    0     0       0          0
-void prf_print_net_info() {
-    printf("READ: %s\n\
-Interface | Receive                                                        | Transmit\n\
-          | bytes\tpackets\terrs\tdrop\tfifo\tframe\tcompressed\tmulticast | bytes\tpackets\terrs\tdrop\tfifo\tcolls\tcarrier\tcompressed\n\
-%s %8lu\t%8lu\t%5lu\t%5lu\t%5lu\t%6lu\t%11lu\t%10lu | %8lu\t%8lu\t%5lu\t%5lu\t%5lu\t%6lu\t%8lu\t%11lu\n%s\n",
-           PRF_NET_INFO_FILE,
-           prf_cfg_interface_name,
-           prf_net_rx[0], prf_net_rx[1], prf_net_rx[2], prf_net_rx[3],
-           prf_net_rx[4], prf_net_rx[5], prf_net_rx[6], prf_net_rx[7],
-           prf_net_tx[0], prf_net_tx[1], prf_net_tx[2], prf_net_tx[3],
-           prf_net_tx[4], prf_net_tx[5], prf_net_tx[6], prf_net_tx[7],
-           PRF_LIB_HEADER
-    );
-}
+    do {
+        ret = syscall(__NR_io_uring_enter, ring->fd, count, count, IORING_ENTER_GETEVENTS, NULL, 0);
+    } while (ret < 0 && errno == EINTR);
 
-// Rx and Tx rates (kb/s)
-void prf_print_net_rates() {
-    printf("READ: %s\nRx: %10lu bytes, %8.2f kbps | Tx: %10lu bytes, %8.2f kbps\n%s\n",
-            PRF_NET_INFO_FILE,
-            prf_net_rx[0], prf_net_rx_rate, prf_net_tx[0], prf_net_tx_rate,
-            PRF_LIB_HEADER);
-}
+    // a signal may cut the wait short once the reads are submitted, the completions are waited for again
+    if (ret != count) {
+        if (ret >= 0) {
+            errno = EIO;
+        }
+        return false;
+    }
 
-void prf_get_net_raw_info(unsigned long r[PRF_NET_ARRAY_LEN], unsigned long t[PRF_NET_ARRAY_LEN]) {
-    memcpy(r, prf_net_rx, sizeof(prf_net_rx));
-    memcpy(t, prf_net_tx, sizeof(prf_net_tx));
+    return true;
 }
 
-void prf_get_net_rate_info(float n[2]) {
-    n[0] = prf_net_rx_rate;
-    n[1] = prf_net_tx_rate;
+/*
+ * reaps the <count> completions of a round into the slots, fills the slots of the next round into <slots>
+ * returns the number of slots of the next round, -1 on error
+ */
+static int prf_uring_reap(prf_ctx_t* ctx, int* slots, int count) {
+    prf_uring_t*            ring    = &ctx->uring;
+    unsigned int            head    = *ring->cq_head;
+    unsigned int            tail;
+    struct io_uring_cqe*    cqe;
+    int                     slot;
+    int                     reaped  = 0;
+    int                     next    = 0;
+    long                    ret;
+
+    while (reaped < count) {
+        tail = __atomic_load_n(ring->cq_tail, __ATOMIC_ACQUIRE);
+        if (head == tail) {
+            ret = syscall(__NR_io_uring_enter, ring->fd, 0, count - reaped, IORING_ENTER_GETEVENTS, NULL, 0);
+            if (ret < 0 && errno != EINTR) {
+                return -1;
+            }
+            continue;
+        }
+
+        for (; head != tail && reaped < count; head++, reaped++) {
+            cqe  = &ring->cqes[head & *ring->cq_mask];
+            slot = (int)cqe->user_data;
+
+            if (cqe->res < 0) {
+                // an error after some bytes ends the file, like pread()
+                ctx->uring_len[slot] = (ctx->uring_len[slot] > 0) ? ctx->uring_len[slot] : -1;
+            } else if (cqe->res > 0) {
+                ctx->uring_len[slot] += cqe->res;
+                if (ctx->uring_len[slot] == ctx->uring_size[slot]) {
+                    ctx->uring_more[slot] = true;
+                } else if (slot < PRF_FILE_COUNT && prf_file_is_seq[slot]) {
+                    slots[next++] = slot;
+                }
+            }
+        }
+
+        __atomic_store_n(ring->cq_head, head, __ATOMIC_RELEASE);
+    }
+
+    return next;
 }
 
-bool prf_read_file(const char* file_name, char** buffer, long* file_size) {
-    bool        status = false;
-    FILE*       fl;
+bool prf_read_batch(prf_ctx_t* ctx) {
+    int                 slots[PRF_URING_SLOT_COUNT];
+    int                 count   = 0;
+    size_t              need    = 0;
+    prf_pid_entry_t*    entry;
 
-    fl = fopen(file_name, "rb");
+    if (ctx->cfg_io_backend != PRF_IO_BACKEND_URING || ctx->uring_failed) {
+        return false;
+    }
 
-    if (fl && file_size) {
-        // get file size
-        if (*file_size == 0) {
-            fseek(fl, 0, SEEK_END);
-            *file_size = ftell(fl);
-            fseek(fl, 0, SEEK_SET);
-            (*file_size)++; // +1 for '\0'
+    if (ctx->uring.fd < 0 && !prf_uring_open(ctx)) {
+        return prf_uring_fail(ctx, "set up");
+    }
+
+    for (int i = 0; i < PRF_URING_SLOT_COUNT; i++) {
+        ctx->uring_fds[i] = -1;
+    }
+
+    // the files the readers of the tick read: the /proc pseudo-files, the cgroup files and those of the processes
+    for (int i = 0; i < PRF_FILE_COUNT; i++) {
+        if (prf_uring_is_batched(ctx, i) && prf_open_proc_file(ctx, i)) {
+            prf_uring_add(ctx, slots, &count, i, ctx->file_fds[i]);
         }
+    }
 
-        if (*buffer == NULL) {
-            *buffer = (char*)malloc(*file_size);
+    for (int i = 0; i < PRF_CGROUP_FILE_COUNT; i++) {
+        if (ctx->cgroup_fds[i] >= 0) {
+            prf_uring_add(ctx, slots, &count, PRF_URING_CGROUP_SLOT(i), ctx->cgroup_fds[i]);
         }
+    }
 
-        if (*buffer) {
-            memset(*buffer, 0, *file_size);
-            fread(*buffer, 1, (*file_size -1), fl);
-            status = true;
-        } else {
-            fprintf(stderr, "** ERROR - memory error!");
+    for (int i = 0; i < ctx->pid_count; i++) {
+        entry = &ctx->pid_entries[i];
+        for (int j = 0; j < PRF_PID_FILE_COUNT; j++) {
+            if (entry->dir_fd >= 0 && entry->fds[j] >= 0) {
+                prf_uring_add(ctx, slots, &count, PRF_URING_PID_SLOT(i, j), entry->fds[j]);
+            }
         }
+    }
 
-        fclose(fl);
-    } else {
-        fprintf(stderr, "** ERROR - unable to open file '%s'\n", file_name);
+    if (count == 0) {
+        return false;
     }
 
-    return status;
+    // the slots one after the other in the registered buffer, a file that outgrew its slot has a larger one
+    for (int i = 0; i < count; i++) {
+        ctx->uring_off[slots[i]] = need;
+        need += ctx->uring_size[slots[i]];
+    }
+
+    if (need > ctx->uring.arena_size && !prf_uring_set_arena(ctx, need)) {
+        return prf_uring_fail(ctx, "register the buffer of");
+    }
+
+    if (!prf_uring_set_files(ctx)) {
+        return prf_uring_fail(ctx, "register the files of");
+    }
+
+    // every round is one io_uring_enter() call, the seq_files that filled a page continue in the next one
+    while (count > 0) {
+        if (!prf_uring_submit(ctx, slots, count) || (count = prf_uring_reap(ctx, slots, count)) < 0) {
+            return prf_uring_fail(ctx, "read with");
+        }
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &ctx->uring_stamp);
+
+    return true;
 }
 
-void prf_free_mem(void* mem) {
-    if (mem != NULL) {
-        free(mem);
-        mem = NULL;
+/*
+ * copies the read of descriptor <fd> in slot <slot> of the last batch into <buffer>, a full slot is continued
+ * with pread(), the read is consumed unless <buffer> is too small, so a growable buffer may take it again
+ * returns the number of bytes read, -1 on error, PRF_URING_MISS if the batch did not read <fd>
+ */
+static long prf_uring_take(prf_ctx_t* ctx, int slot, int fd, char* buffer, long size) {
+    long    len     = ctx->uring_len[slot];
+    long    total;
+
+    if (fd < 0 || ctx->uring_fds[slot] != fd) {
+        return PRF_URING_MISS;
     }
+
+    if (len < 0) {
+        ctx->uring_fds[slot] = -1;
+        buffer[0] = '\0';
+        return -1;
+    }
+
+    total = (len < size - 1) ? len : size - 1;
+    memcpy(buffer, ctx->uring.arena + ctx->uring_off[slot], total);
+    buffer[total] = '\0';
+    if (total < len) {
+        return total;
+    }
+
+    ctx->uring_fds[slot] = -1;
+    if (ctx->uring_more[slot]) {
+        // the next batch reads the whole file into the slot
+        total = prf_pread_from(fd, buffer, size, total, slot < PRF_FILE_COUNT && prf_file_is_seq[slot]);
+        while (ctx->uring_size[slot] <= total) {
+            ctx->uring_size[slot] *= 2;
+        }
+    }
+
+    return total;
 }
 
-bool prf_is_perf_thread_running() {
-    return *prf_perf_is_running;
+/*
+ * reads descriptor <fd> into <buffer>, from slot <slot> of the last batch if it read <fd>, with pread() otherwise
+ * returns the number of bytes read, -1 on error
+ */
+static long prf_read_slot(prf_ctx_t* ctx, int slot, int fd, char* buffer, long size) {
+    long    len = prf_uring_take(ctx, slot, fd, buffer, size);
+
+    return (len != PRF_URING_MISS) ? len : prf_pread_file(fd, buffer, size);
 }
 
-void prf_cancel_perf_thread() {
-    if (*prf_perf_is_running) {
-        *prf_perf_is_running = false;
+/*
+ * reads the /proc pseudo-file <file> into <buffer> with pread() on its persistent descriptor, or takes the read
+ * of the last io_uring batch, the descriptor is opened on first use
+ * returns the number of bytes read, -1 on error
+ */
+static long prf_read_proc_file(prf_ctx_t* ctx, prf_file_t file, char* buffer, long size) {
+    long    len;
+
+    if (ctx->cfg_source.read != NULL) {
+        len = ctx->cfg_source.read(ctx->cfg_source.arg, prf_file_names[file], buffer, size);
+        len = (len < size) ? len : size - 1;
+        buffer[(len < 0) ? 0 : len] = '\0';
+    } else if ((len = prf_uring_take(ctx, file, ctx->file_fds[file], buffer, size)) != PRF_URING_MISS) {
+        // the batch is read at the start of the tick
+        ctx->file_stamps[file] = ctx->uring_stamp;
+        return len;
+    } else {
+        len = prf_open_proc_file(ctx, file) ? prf_pread_from(ctx->file_fds[file], buffer, size, 0, prf_file_is_seq[file]) : -1;
     }
-}
 
+    if (len >= 0) {
+        clock_gettime(CLOCK_MONOTONIC, &ctx->file_stamps[file]);
+    }
+
+    return len;
+}
+
+/*
+ * reads the /proc pseudo-file <file> into the growable heap buffer <*buffer> of <*size> bytes
+ * the buffer is doubled and re-read until it holds the whole file or <is_complete> reports
+ * that the part of interest fits, so it is sized once and reused by the following reads
+ * <is_complete> may be NULL to read the whole file
+ * returns the number of bytes read, -1 on error
+ */
+static long prf_read_proc_file_grow(prf_ctx_t* ctx, prf_file_t file, char** buffer, long* size,
+                                    bool (*is_complete)(const char* buffer, long len)) {
+    long    len;
+    char*   grown;
+
+    if (*buffer == NULL) {
+        *size   = (*size > 0) ? *size : BUFSIZ;
+        *buffer = (char*)malloc(*size);
+        if (*buffer == NULL) {
+            fprintf(stderr, "** ERROR - memory error!");
+            return -1;
+        }
+    }
+
+    for (;;) {
+        len = prf_read_proc_file(ctx, file, *buffer, *size);
+        if (len < *size - 1 || (is_complete != NULL && is_complete(*buffer, len))) {
+            break;
+        }
+
+        grown = (char*)realloc(*buffer, *size * 2);
+        if (grown == NULL) {
+            fprintf(stderr, "** ERROR - memory error!");
+            break;
+        }
+
+        *buffer = grown;
+        *size  *= 2;
+    }
+
+    return len;
+}
+
+/*
+ * reports whether <buffer> holds all "cpu" lines of /proc/stat, that is a complete line follows them
+ */
+static bool prf_is_cpu_info_complete(const char* buffer, long len) {
+    const char*     p   = buffer;
+    const char*     end = buffer + len;
+
+    while ((p = memchr(p, '\n', end - p)) != NULL && ++p < end) {
+        if (end - p < 3 || memcmp(p, "cpu", 3) != 0) {
+            return memchr(p, '\n', end - p) != NULL;
+        }
+    }
+
+    return false;
+}
+
+/*
+ * pthread cleanup handler, the thread may be cancelled while sleeping
+ */
+static void prf_cleanup_files(void* arg) {
+    prf_close_files((prf_ctx_t*)arg);
+}
+
+/*
+ * returns the seconds elapsed from <from> to <to>
+ */
+static inline double prf_elapsed_seconds(const struct timespec* from, const struct timespec* to) {
+    return (double)(to->tv_sec - from->tv_sec) + (double)(to->tv_nsec - from->tv_nsec) / 1000000000.0;
+}
+
+/*
+ * returns the seconds from the previous read at <last> to the read at <now>, 0 for the first read, when <last> is unset
+ * the rates of the counters are taken over this measured time, not over the configured interval, so a late tick
+ * or an adaptive interval does not skew them, and the first read has none
+ */
+static inline double prf_rate_seconds(const struct timespec* last, const struct timespec* now) {
+    return (last->tv_sec == 0 && last->tv_nsec == 0) ? 0.0 : prf_elapsed_seconds(last, now);
+}
+
+/*
+ * returns the rate per second of a counter, 0 unless it moved forward: a reset or a re-created interface gives 0
+ */
+static inline float prf_calc_rate(unsigned long now, unsigned long last, float seconds) {
+    return (now > last && seconds > 0.0) ? (float)(now - last) / seconds : 0.0;
+}
+
+/*
+ * parses an unsigned decimal at <*p>, skipping leading blanks, and advances <*p> past it
+ * replaces strtoull() on the hot path: no locale, no errno, no sign handling
+ */
+static inline unsigned long prf_parse_ulong(const char** p, const char* end) {
+    const char*     s   = *p;
+    unsigned long   val = 0;
+
+    while (s < end && (*s == ' ' || *s == '\t')) {
+        s++;
+    }
+
+    while (s < end && (unsigned)(*s - '0') < 10) {
+        val = val * 10 + (unsigned long)(*s - '0');
+        s++;
+    }
+
+    *p = s;
+
+    return val;
+}
+
+/*
+ * parses an unsigned decimal fraction like "12.34" at <*p>, skipping leading blanks, and advances <*p> past it
+ */
+static inline float prf_parse_decimal(const char** p, const char* end) {
+    unsigned long   int_part    = prf_parse_ulong(p, end);
+    unsigned long   frac_part   = 0;
+    unsigned long   scale       = 1;
+    const char*     s           = *p;
+
+    if (s < end && *s == '.') {
+        for (s++; s < end && (unsigned)(*s - '0') < 10; s++) {
+            if (scale < 1000000000UL) {
+                frac_part = frac_part * 10 + (unsigned long)(*s - '0');
+                scale    *= 10;
+            }
+        }
+    }
+
+    *p = s;
+
+    return (float)int_part + (float)frac_part / (float)scale;
+}
+
+#if defined(__SSE2__) && defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+#define PRF_HAS_DIGIT_KERNEL    1
+
+/*
+ * converts the <len> (1 - 8) ASCII digits at <s> into a number without a loop (SWAR)
+ * <s> must be readable for 8 bytes
+ */
+static inline uint64_t prf_parse_digits8(const char* s, int len) {
+    uint64_t    val;
+
+    memcpy(&val, s, sizeof(val));
+    // move the digits to the top, the vacated low bytes act as leading zeros
+    val <<= 8 * (8 - len);
+    val = ((val & 0x0F0F0F0F0F0F0F0FULL) * 2561) >> 8;
+    val = ((val & 0x00FF00FF00FF00FFULL) * 6553601) >> 16;
+    val = ((val & 0x0000FFFF0000FFFFULL) * 42949672960001ULL) >> 32;
+
+    return val;
+}
+#endif
+
+/*
+ * parses an unsigned decimal like prf_parse_ulong(), vectorized when 16 bytes are left:
+ * SSE2 finds the length of the digit run, which is converted 8 digits at a time
+ */
+static inline unsigned long prf_parse_ulong_fast(const char** p, const char* end) {
+#if defined(PRF_HAS_DIGIT_KERNEL)
+    const char*     s   = *p;
+    __m128i         v;
+    __m128i         d;
+    unsigned        mask;
+    int             len;
+
+    while (s < end && *s == ' ') {
+        s++;
+    }
+
+    if (end - s >= 16) {
+        v    = _mm_loadu_si128((const __m128i*)s);
+        d    = _mm_sub_epi8(v, _mm_set1_epi8('0'));
+        // a byte is a digit if (byte - '0') <= 9 unsigned
+        mask = (unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_min_epu8(d, _mm_set1_epi8(9)), d));
+        len  = __builtin_ctz(~mask);
+
+        if (len >= 1 && len <= 8) {
+            *p = s + len;
+            return (unsigned long)prf_parse_digits8(s, len);
+        } else if (len > 8 && len < 16) {
+            *p = s + len;
+            return (unsigned long)(prf_parse_digits8(s, len - 8) * 100000000ULL + prf_parse_digits8(s + len - 8, 8));
+        }
+    }
+
+    *p = s;
+#endif
+
+    return prf_parse_ulong(p, end);
+}
+
+/*
+ * advances the absolute CLOCK_MONOTONIC <deadline> by <interval>
+ * overslept by more than an interval: the schedule restarts from now instead of catching up in a burst
+ */
+static void prf_advance_deadline(struct timespec* deadline, const struct timespec* interval) {
+    struct timespec     now;
+
+    deadline->tv_sec  += interval->tv_sec;
+    deadline->tv_nsec += interval->tv_nsec;
+    while (deadline->tv_nsec >= 1000000000L) {
+        deadline->tv_nsec -= 1000000000L;
+        deadline->tv_sec++;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    if (prf_elapsed_seconds(deadline, &now) > (double)interval->tv_sec + (double)interval->tv_nsec / 1000000000.0) {
+        *deadline = now;
+    }
+}
+
+/*
+ * advances <deadline> by the interval of <ctx> and sleeps until it, like prf_sleep_until(),
+ * but wakes up early when prf_cancel_perf_thread() writes to the eventfd of <ctx>
+ * returns false if woken up by prf_cancel_perf_thread()
+ */
+static bool prf_ctx_sleep_until(prf_ctx_t* ctx, struct timespec* deadline) {
+    struct pollfd       pfd     = {ctx->wake_fd, POLLIN, 0};
+    struct timespec     now;
+    struct timespec     rest;
+    uint64_t            count;
+
+    prf_advance_deadline(deadline, &ctx->sleep_req);
+
+    for (;;) {
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        rest.tv_sec  = deadline->tv_sec - now.tv_sec;
+        rest.tv_nsec = deadline->tv_nsec - now.tv_nsec;
+        if (rest.tv_nsec < 0) {
+            rest.tv_nsec += 1000000000L;
+            rest.tv_sec--;
+        }
+
+        if (rest.tv_sec < 0 || (rest.tv_sec == 0 && rest.tv_nsec == 0)) {
+            return true;
+        }
+
+        // ppoll() is relative, the remaining time is recomputed after a signal
+        if (ppoll(&pfd, 1, &rest, NULL) > 0) {
+            if (read(ctx->wake_fd, &count, sizeof(count)) < 0) {
+                // already drained
+            }
+            return false;
+        }
+    }
+}
+
+/*
+ * allocates the history of <ctx>: <len> samples per metric, rounded up to a power of 2
+ */
+static bool prf_alloc_history(prf_ctx_t* ctx, int len, float ewma_s) {
+    int     size = 1;
+
+    len = (len > 0) ? len : PRF_HISTORY_DEF_LEN;
+    len = (len < PRF_HISTORY_MAX_LEN) ? len : PRF_HISTORY_MAX_LEN;
+    while (size < len) {
+        size *= 2;
+    }
+
+    ctx->hist_len    = size;
+    ctx->hist_ewma_s = (ewma_s > 0.0) ? ewma_s : PRF_HISTORY_DEF_EWMA_S;
+    ctx->hist_stamp  = (double*)calloc(size, sizeof(double));
+    ctx->hist_val    = (float*)calloc((size_t)PRF_METRIC_COUNT * size, sizeof(float));
+    ctx->hist_sum    = (double*)calloc((size_t)PRF_METRIC_COUNT * size, sizeof(double));
+    ctx->hist_min    = (float*)malloc((size_t)PRF_METRIC_COUNT * 2 * size * sizeof(float));
+    ctx->hist_max    = (float*)malloc((size_t)PRF_METRIC_COUNT * 2 * size * sizeof(float));
+
+    if (ctx->hist_stamp == NULL || ctx->hist_val == NULL || ctx->hist_sum == NULL ||
+        ctx->hist_min == NULL || ctx->hist_max == NULL) {
+        fprintf(stderr, "** ERROR - memory error!");
+        return false;
+    }
+
+    // empty slots never win a comparison
+    for (long i = 0; i < (long)PRF_METRIC_COUNT * 2 * size; i++) {
+        ctx->hist_min[i] = FLT_MAX;
+        ctx->hist_max[i] = -FLT_MAX;
+    }
+
+    atomic_init(&ctx->hist_seq, 0);
+
+    return true;
+}
+
+/*
+ * sets leaf <slot> of the min and max segment trees of <len> leaves to <val> and updates its ancestors
+ */
+static inline void prf_set_tree_leaf(float* min, float* max, int len, int slot, float val) {
+    int     i = len + slot;
+
+    min[i] = max[i] = val;
+
+    for (i /= 2; i >= 1; i /= 2) {
+        min[i] = (min[2 * i] < min[2 * i + 1]) ? min[2 * i] : min[2 * i + 1];
+        max[i] = (max[2 * i] > max[2 * i + 1]) ? max[2 * i] : max[2 * i + 1];
+    }
+}
+
+/*
+ * folds the minimum and the maximum of the leaves [<from>, <to>) of the segment trees into <*lo> and <*hi>
+ */
+static inline void prf_query_tree(const float* min, const float* max, int len, int from, int to, float* lo, float* hi) {
+    for (from += len, to += len; from < to; from /= 2, to /= 2) {
+        if (from & 1) {
+            *lo = (min[from] < *lo) ? min[from] : *lo;
+            *hi = (max[from] > *hi) ? max[from] : *hi;
+            from++;
+        }
+        if (to & 1) {
+            to--;
+            *lo = (min[to] < *lo) ? min[to] : *lo;
+            *hi = (max[to] > *hi) ? max[to] : *hi;
+        }
+    }
+}
+
+/*
+ * returns the load of <type> of the 1, 5 and 15 minute load averages <v> and the estimators <ewma>
+ */
+static float prf_select_load_avg(prf_cpu_load_t type, const float v[3], const float ewma[3]) {
+    switch (type) {
+        case TYPE_EWMA_1:
+            return ewma[0];
+
+        case TYPE_EWMA_2:
+            return ewma[1];
+
+        case TYPE_EWMA_3:
+            return ewma[2];
+
+        case TYPE_MIN_1:
+            return v[0];
+
+        case TYPE_MIN_15:
+            return v[2];
+
+        case TYPE_MIN_5:
+        default:
+            return v[1];
+    }
+}
+
+/*
+ * fills the metrics of <snap> into array <v>, indexed by prf_metric_t
+ */
+static void prf_get_metric_values(prf_ctx_t* ctx, const prf_snapshot_t* snap, float v[PRF_METRIC_COUNT]) {
+    v[PRF_METRIC_THRESHOLD]         = snap->threshold;
+    v[PRF_METRIC_LOAD_AVG]          = prf_select_load_avg(ctx->cfg_cpu_load_type, snap->load_avg, snap->load_ewma);
+    v[PRF_METRIC_LOAD_EWMA]         = snap->load_ewma[0];
+    v[PRF_METRIC_CPU_LOAD]          = 100.0 - snap->cpu_pt[3];
+    v[PRF_METRIC_CPU_TOTAL_LOAD]    = 100.0 - snap->cpu_total_pt[3];
+    v[PRF_METRIC_CPU_IOWAIT]        = snap->cpu_total_pt[4];
+    v[PRF_METRIC_CPU_BUSIEST_LOAD]  = snap->cpu_busiest_load;
+    v[PRF_METRIC_MEM_USED]          = (snap->mem[0] > 0) ?
+                                      100.0 * (float)(snap->mem[0] - snap->mem_available) / (float)snap->mem[0] : 0.0;
+    v[PRF_METRIC_MEM_AVAILABLE]     = (float)snap->mem_available;
+    v[PRF_METRIC_NET_RX_RATE]       = snap->net_rate[0];
+    v[PRF_METRIC_NET_TX_RATE]       = snap->net_rate[1];
+    v[PRF_METRIC_NET_TOTAL_RX]      = snap->net_total.rx_bytes_rate;
+    v[PRF_METRIC_NET_TOTAL_TX]      = snap->net_total.tx_bytes_rate;
+    v[PRF_METRIC_PSI_CPU]           = snap->psi[PRF_PSI_CPU].some_rate;
+    v[PRF_METRIC_PSI_MEMORY]        = snap->psi[PRF_PSI_MEMORY].some_rate;
+    v[PRF_METRIC_PSI_IO]            = snap->psi[PRF_PSI_IO].some_rate;
+    v[PRF_METRIC_DISK_IOPS]         = snap->disk_total.read_iops + snap->disk_total.write_iops;
+    v[PRF_METRIC_DISK_MBPS]         = snap->disk_total.read_mbps + snap->disk_total.write_mbps;
+    v[PRF_METRIC_DISK_UTIL]         = snap->disk_total.util;
+    v[PRF_METRIC_CGROUP_CPU]        = snap->cgroup.cpu_pt;
+    v[PRF_METRIC_CGROUP_THROTTLED]  = snap->cgroup.throttled_pt;
+    v[PRF_METRIC_CGROUP_MEMORY]     = snap->cgroup.mem_pt;
+    v[PRF_METRIC_VM_MAJFAULT]       = snap->vmstat.rate[PRF_VM_PGMAJFAULT];
+    v[PRF_METRIC_VM_SWAP]           = snap->vmstat.rate[PRF_VM_PSWPIN] + snap->vmstat.rate[PRF_VM_PSWPOUT];
+    v[PRF_METRIC_VM_SCAN]           = snap->vmstat.rate[PRF_VM_PGSCAN_KSWAPD] + snap->vmstat.rate[PRF_VM_PGSCAN_DIRECT];
+    v[PRF_METRIC_VM_SCAN_DIRECT]    = snap->vmstat.rate[PRF_VM_PGSCAN_DIRECT];
+    v[PRF_METRIC_VM_ALLOCSTALL]     = snap->vmstat.rate[PRF_VM_ALLOCSTALL];
+    v[PRF_METRIC_SOFTIRQ_NET_RX]    = snap->softirq[PRF_SOFTIRQ_NET_RX].max_rate;
+    v[PRF_METRIC_SOFTIRQ_IMBALANCE] = snap->softirq[PRF_SOFTIRQ_NET_RX].imbalance;
+    v[PRF_METRIC_IRQ_IMBALANCE]     = snap->irq.imbalance;
+}
+
+/*
+ * appends the metrics <v> read at <now> to the history, called by prf_publish_snapshot()
+ */
+static void prf_append_history(prf_ctx_t* ctx, const float v[PRF_METRIC_COUNT], const struct timespec* now) {
+    int             len     = ctx->hist_len;
+    int             slot    = ctx->hist_head;
+    unsigned long   seq     = atomic_load_explicit(&ctx->hist_seq, memory_order_relaxed);
+    double          stamp   = (double)now->tv_sec + (double)now->tv_nsec / 1000000000.0;
+    double          dt      = 0.0;
+
+    if (len == 0) {
+        return;
+    }
+
+    if (ctx->hist_count > 0) {
+        dt = stamp - ctx->hist_stamp[(slot - 1) & (len - 1)];
+    }
+
+    atomic_store_explicit(&ctx->hist_seq, seq + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+
+    ctx->hist_stamp[slot] = stamp;
+
+    for (int m = 0; m < PRF_METRIC_COUNT; m++) {
+        ctx->hist_val[m * len + slot] = v[m];
+        ctx->hist_sum[m * len + slot] = ctx->hist_total[m];
+        ctx->hist_total[m]           += v[m];
+        prf_set_tree_leaf(&ctx->hist_min[m * 2 * len], &ctx->hist_max[m * 2 * len], len, slot, v[m]);
+
+        // first order low-pass filter over the measured time step, exact for irregular intervals
+        if (ctx->hist_count == 0) {
+            ctx->hist_ewma[m]  = v[m];
+        } else {
+            ctx->hist_ewma[m] += (v[m] - ctx->hist_ewma[m]) * (float)(dt / (ctx->hist_ewma_s + dt));
+        }
+    }
+
+    ctx->hist_head  = (slot + 1) & (len - 1);
+    ctx->hist_count = (ctx->hist_count < len) ? ctx->hist_count + 1 : len;
+
+    atomic_store_explicit(&ctx->hist_seq, seq + 2, memory_order_release);
+}
+
+/*
+ * evaluates the subscriptions against the metrics <v> of the snapshot published at <stamp>
+ * the eventfds are written under the lock, the callbacks are called after it
+ */
+static void prf_notify_subs(prf_ctx_t* ctx, const float v[PRF_METRIC_COUNT], const struct timespec* stamp) {
+    prf_event_t     events[PRF_SUB_MAX];
+    prf_sub_t       subs[PRF_SUB_MAX];
+    int             count   = 0;
+    uint64_t        one     = 1;
+    bool            is_above;
+    float           value;
+
+    pthread_mutex_lock(&ctx->sub_lock);
+
+    for (int i = 0; i < PRF_SUB_MAX; i++) {
+        if (ctx->sub_fds[i] < 0) {
+            continue;
+        }
+
+        value    = v[ctx->subs[i].metric];
+        is_above = ctx->sub_is_above[i];
+
+        if (!is_above && value >= ctx->subs[i].threshold) {
+            is_above = true;
+        } else if (is_above && value < ctx->subs[i].threshold - ctx->subs[i].hysteresis) {
+            is_above = false;
+        }
+
+        if (is_above != ctx->sub_is_above[i]) {
+            ctx->sub_is_above[i]            = is_above;
+            ctx->sub_has_fired[i]           = true;
+            ctx->sub_events[i].sub_id       = i;
+            ctx->sub_events[i].metric       = ctx->subs[i].metric;
+            ctx->sub_events[i].value        = value;
+            ctx->sub_events[i].is_above     = is_above;
+            ctx->sub_events[i].stamp        = *stamp;
+
+            if (write(ctx->sub_fds[i], &one, sizeof(one)) < 0) {
+                // the counter is saturated, the fd is readable anyway
+            }
+
+            if (ctx->subs[i].callback != NULL) {
+                events[count] = ctx->sub_events[i];
+                subs[count]   = ctx->subs[i];
+                count++;
+            }
+        }
+    }
+
+    pthread_mutex_unlock(&ctx->sub_lock);
+
+    for (int i = 0; i < count; i++) {
+        subs[i].callback(&events[i], subs[i].arg);
+    }
+}
+
+/*
+ * finds the samples not older than <from> seconds, binary search over the monotonic stamps
+ * fills the slot of the oldest one into <*first>
+ * returns the number of samples, read inside the seqlock of the history
+ */
+static int prf_find_history_window(prf_ctx_t* ctx, double from, int* first) {
+    int     mask    = ctx->hist_len - 1;
+    int     count   = ctx->hist_count;
+    int     oldest  = (ctx->hist_head - count) & mask;
+    int     lo      = 0;
+    int     hi      = count;
+    int     mid;
+
+    while (lo < hi) {
+        mid = lo + (hi - lo) / 2;
+        if (ctx->hist_stamp[(oldest + mid) & mask] < from) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+
+    *first = (oldest + lo) & mask;
+
+    return count - lo;
+}
+
+/*
+ * returns the seconds of the start of a window of <window> seconds ending now, any time for <window> <= 0
+ * the window of a replay ends at the replayed snapshot
+ */
+static double prf_history_window_start(prf_ctx_t* ctx, float window) {
+    struct timespec     now;
+
+    if (window <= 0.0) {
+        return -DBL_MAX;
+    }
+
+    if (ctx->is_replay) {
+        return ctx->replay_now - window;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (double)now.tv_sec + (double)now.tv_nsec / 1000000000.0 - window;
+}
+
+/*
+ * partially sorts <v> of <n> values so that v[k] is the k-th smallest, quickselect
+ */
+static float prf_select_kth(float* v, int n, int k) {
+    int     lo = 0;
+    int     hi = n - 1;
+    int     i;
+    int     j;
+    float   pivot;
+    float   tmp;
+
+    while (lo < hi) {
+        pivot = v[lo + (hi - lo) / 2];
+        i     = lo;
+        j     = hi;
+
+        while (i <= j) {
+            while (v[i] < pivot) {
+                i++;
+            }
+            while (v[j] > pivot) {
+                j--;
+            }
+            if (i <= j) {
+                tmp  = v[i];
+                v[i] = v[j];
+                v[j] = tmp;
+                i++;
+                j--;
+            }
+        }
+
+        if (k <= j) {
+            hi = j;
+        } else if (k >= i) {
+            lo = i;
+        } else {
+            break;
+        }
+    }
+
+    return v[k];
+}
+
+/*
+ * sets the interval of <ctx> to <seconds>
+ */
+static void prf_set_interval(prf_ctx_t* ctx, float seconds) {
+    ctx->interval_seconds   = seconds;
+    ctx->sleep_req.tv_sec   = (time_t)seconds;
+    ctx->sleep_req.tv_nsec  = (long)((seconds - (float)ctx->sleep_req.tv_sec) * 1000000000.0);
+}
+
+/*
+ * adapts the interval of <ctx> to the threshold source after a tick: shorter near the threshold
+ * or while the value moves fast, exponentially longer while it is steady
+ */
+static void prf_adapt_interval(prf_ctx_t* ctx) {
+    float   value;
+    float   change;
+    float   scale       = (ctx->cfg_cpu_threshold > 0.0) ? ctx->cfg_cpu_threshold : 1.0;
+    float   interval    = ctx->interval_seconds;
+
+    if (ctx->cfg_interval_min <= 0.0) {
+        return;
+    }
+
+    value               = prf_get_current_threshold(ctx);
+    change              = ctx->adapt_has_last ? value - ctx->adapt_last : 0.0;
+    change              = (change < 0.0) ? -change : change;
+    ctx->adapt_last     = value;
+    ctx->adapt_has_last = true;
+
+    if (value >= ctx->cfg_cpu_threshold) {
+        interval = ctx->cfg_interval_min;
+    } else if (value >= scale * PRF_ADAPT_NEAR || change >= scale * PRF_ADAPT_CHANGE) {
+        interval *= PRF_ADAPT_TIGHTEN;
+    } else {
+        interval *= PRF_ADAPT_BACKOFF;
+    }
+
+    interval = (interval > ctx->cfg_interval_min) ? interval : ctx->cfg_interval_min;
+    interval = (interval < ctx->cfg_interval_max) ? interval : ctx->cfg_interval_max;
+
+    prf_set_interval(ctx, interval);
+}
+
+/*
+ * evaluates the rules of <gate> on the history of its context, the lock of <gate> is held
+ */
+static void prf_eval_gate(prf_gate_t* gate) {
+    prf_gate_verdict_t*     verdict     = &gate->verdict;
+    const prf_gate_rule_t*  rule;
+    prf_stats_t             stats;
+    float                   values[PRF_GATE_MAX_RULES];
+    float                   weight;
+    float                   weights     = 0.0;
+    float                   score       = 0.0;
+    float                   score_low   = 0.0;
+    int                     over_count  = 0;
+    int                     first_over  = -1;
+
+    for (int i = 0; i < gate->cfg.rule_count; i++) {
+        rule      = &gate->cfg.rules[i];
+        values[i] = 0.0;
+
+        // no sample yet: the rule is not over
+        if (prf_get_history_stats(gate->ctx, rule->metric, rule->smooth_s, &stats)) {
+            values[i] = (rule->smooth_s > 0.0) ? stats.mean : stats.last;
+        }
+
+        if (!gate->is_over[i] && values[i] >= rule->high) {
+            gate->is_over[i] = true;
+        } else if (gate->is_over[i] && values[i] < rule->low) {
+            gate->is_over[i] = false;
+        }
+
+        if (gate->is_over[i]) {
+            over_count++;
+            first_over = (first_over < 0) ? i : first_over;
+        }
+
+        if (rule->high > 0.0) {
+            weight     = (rule->weight > 0.0) ? rule->weight : 1.0;
+            weights   += weight;
+            score     += weight * values[i] / rule->high;
+            score_low += weight * rule->low / rule->high;
+        }
+    }
+
+    score     = (weights > 0.0) ? score / weights : 0.0;
+    score_low = (weights > 0.0) ? score_low / weights : 0.0;
+
+    switch (gate->cfg.mode) {
+        case PRF_GATE_ALL:
+            gate->is_deferring = (over_count == gate->cfg.rule_count);
+            break;
+
+        case PRF_GATE_WEIGHTED:
+            if (!gate->is_deferring && score >= 1.0) {
+                gate->is_deferring = true;
+            } else if (gate->is_deferring && score < score_low) {
+                gate->is_deferring = false;
+            }
+            break;
+
+        case PRF_GATE_ANY:
+        default:
+            gate->is_deferring = (over_count > 0);
+            break;
+    }
+
+    verdict->admit  = !gate->is_deferring;
+    verdict->score  = score;
+    verdict->rule   = (gate->is_deferring && gate->cfg.mode != PRF_GATE_WEIGHTED) ? first_over : -1;
+    verdict->metric = gate->cfg.rules[(verdict->rule >= 0) ? verdict->rule : 0].metric;
+    verdict->value  = (verdict->rule >= 0) ? values[verdict->rule] : 0.0;
+
+    if (verdict->admit) {
+        snprintf(verdict->reason, sizeof(verdict->reason), "admitted");
+    } else if (verdict->rule < 0) {
+        snprintf(verdict->reason, sizeof(verdict->reason), "weighted score %.2f over 1.00, low %.2f", score, score_low);
+    } else {
+        rule = &gate->cfg.rules[verdict->rule];
+        snprintf(verdict->reason, sizeof(verdict->reason), "%s%s %.2f over high %.2f, low %.2f",
+                 (gate->cfg.mode == PRF_GATE_ALL) ? "all rules over, " : "",
+                 prf_get_metric_name(rule->metric), verdict->value, rule->high, rule->low);
+    }
+}
+
+/*
+ * evaluates the gates of <ctx> and wakes up their waiters, called by prf_publish_snapshot()
+ */
+static void prf_update_gates(prf_ctx_t* ctx) {
+    pthread_mutex_lock(&ctx->gate_lock);
+
+    for (int i = 0; i < PRF_GATE_MAX; i++) {
+        if (ctx->gates[i] != NULL) {
+            pthread_mutex_lock(&ctx->gates[i]->lock);
+            prf_eval_gate(ctx->gates[i]);
+            pthread_cond_broadcast(&ctx->gates[i]->cond);
+            pthread_mutex_unlock(&ctx->gates[i]->lock);
+        }
+    }
+
+    pthread_mutex_unlock(&ctx->gate_lock);
+}
+
+/*
+ * adds <seconds> to <ts>
+ */
+static void prf_add_seconds(struct timespec* ts, double seconds) {
+    time_t      sec = (time_t)seconds;
+
+    ts->tv_sec  += sec;
+    ts->tv_nsec += (long)((seconds - (double)sec) * 1000000000.0);
+    while (ts->tv_nsec >= 1000000000L) {
+        ts->tv_nsec -= 1000000000L;
+        ts->tv_sec++;
+    }
+}
+
+/*
+ * folds the load of the latest tick into the estimators, called after the reads of /proc/loadavg and /proc/stat
+ * the load is the busy share of the online CPUs plus the runnable tasks waiting for a CPU, the collector excluded,
+ * so that it is in the units of the kernel's load average without its lag of minutes
+ */
+static void prf_update_load_ewma(prf_ctx_t* ctx) {
+    const struct timespec*  now     = &ctx->file_stamps[PRF_FILE_LOAD_AVG];
+    int                     cpus    = prf_get_cpu_online(ctx);
+    float                   busy    = 100.0 - ctx->cpu_total_pt[3] - ctx->cpu_total_pt[4];
+    float                   sample;
+    int                     queued;
+    double                  dt;
+
+    cpus    = (cpus > 0) ? cpus : 1;
+    queued  = (ctx->load_running - 1) - cpus;
+    sample  = ((busy > 0.0) ? busy : 0.0) * (float)cpus / 100.0 + ((queued > 0) ? (float)queued : 0.0);
+
+    if (!ctx->load_has_ewma) {
+        for (int i = 0; i < 3; i++) {
+            ctx->load_ewma[i] = sample;
+        }
+        ctx->load_has_ewma = true;
+    } else {
+        dt = prf_elapsed_seconds(&ctx->load_ewma_stamp, now);
+        if (dt <= 0.0) {
+            return;
+        }
+
+        for (int i = 0; i < 3; i++) {
+            ctx->load_ewma[i] += (sample - ctx->load_ewma[i]) * (float)(dt / (ctx->cfg_load_ewma_s[i] + dt));
+        }
+    }
+
+    ctx->load_ewma_stamp = *now;
+}
+
+/*
+ * thread for collecting CPU and network statistics
+ */
+void* prf_perf_collect(void* arg) {
+    prf_ctx_t*                  ctx = (prf_ctx_t*)arg;
+    struct timespec             deadline;
+
+    // open once, re-read on every tick
+    prf_open_files(ctx);
+    pthread_cleanup_push(prf_cleanup_files, ctx);
+
+    // init
+    prf_read_batch(ctx);
+    prf_read_load_avg(ctx);
+    prf_read_psi_info(ctx);
+    prf_read_cpu_info(ctx);
+    prf_read_mem_info(ctx);
+    if (ctx->cfg_vmstat_enabled) {
+        prf_read_vmstat_info(ctx);
+    }
+    if (ctx->cfg_irq_enabled) {
+        prf_read_irq_info(ctx);
+    }
+    prf_read_net_info(ctx);
+    if (ctx->cfg_disk_enabled) {
+        prf_read_disk_info(ctx);
+    }
+    prf_read_pid_info(ctx);
+    prf_read_cgroup_info(ctx);
+    prf_update_load_ewma(ctx);
+
+    if (ctx->cfg_is_debug) {
+        if (ctx->cfg_interval_min > 0.0) {
+            printf("INTERVAL: %6.4fs, adaptive %6.4fs - %6.4fs\n",
+                    ctx->interval_seconds, ctx->cfg_interval_min, ctx->cfg_interval_max);
+        } else {
+            printf("INTERVAL: %6.4fs\n", ctx->interval_seconds);
+        }
+        printf("%s\n", PRF_LIB_HEADER);
+
+        prf_print_load_avg(ctx);
+        prf_print_psi_info(ctx);
+        prf_print_cgroup_info(ctx);
+        prf_print_cpu_load(ctx);
+        prf_print_cpu_pt_all(ctx);
+        prf_print_mem_info_full(ctx);
+        prf_print_net_info(ctx);
+        printf("-- %-74s --\n%s\n", PRF_PER_READS, PRF_LIB_HEADER);
+    }
+
+    // absolute deadlines, the time spent reading and printing does not add up to a drift
+    clock_gettime(CLOCK_MONOTONIC, &deadline);
+
+    prf_adapt_interval(ctx);
+    prf_publish_snapshot(ctx);
+
+    while (atomic_load(&ctx->is_running)) {
+        if (!prf_ctx_sleep_until(ctx, &deadline)) {
+            break;
+        }
+
+        prf_read_batch(ctx);
+        prf_read_load_avg(ctx);
+        prf_read_psi_info(ctx);
+        prf_read_cpu_info(ctx);
+        prf_read_net_info(ctx);
+        if (ctx->cfg_disk_enabled) {
+            prf_read_disk_info(ctx);
+        }
+        prf_read_mem_info(ctx);
+        if (ctx->cfg_vmstat_enabled) {
+            prf_read_vmstat_info(ctx);
+        }
+        if (ctx->cfg_irq_enabled) {
+            prf_read_irq_info(ctx);
+        }
+        prf_read_pid_info(ctx);
+        prf_read_cgroup_info(ctx);
+        prf_update_load_ewma(ctx);
+
+        prf_adapt_interval(ctx);
+        prf_publish_snapshot(ctx);
+
+        if (ctx->cfg_is_debug) {
+            if (ctx->cfg_interval_min > 0.0) {
+                printf("INTERVAL: %6.4fs\n", ctx->interval_seconds);
+            }
+            prf_print_load_avg(ctx);
+            prf_print_psi_info(ctx);
+            prf_print_cgroup_info(ctx);
+            prf_print_cpu_pt_load(ctx);
+            prf_print_mem_info(ctx);
+            if (ctx->cfg_vmstat_enabled) {
+                prf_print_vmstat_info(ctx);
+            }
+            if (ctx->cfg_irq_enabled) {
+                prf_print_irq_info(ctx);
+            }
+            prf_print_net_rates(ctx);
+            prf_print_net_itf_rates(ctx);
+            if (ctx->cfg_disk_enabled) {
+                prf_print_disk_rates(ctx);
+            }
+            prf_print_pid_info(ctx);
+            prf_print_history(ctx, PRF_HISTORY_PRINT_S);
+        }
+
+        if (ctx->cfg_is_joinable) {
+            float current_threshold = prf_get_current_threshold(ctx);
+            printf("-- joined: %4.2f | is overloaded? %s\n",
+                   current_threshold, (current_threshold >= ctx->cfg_cpu_threshold) ? PRF_TRUE : PRF_FALSE);
+        }
+
+        if (ctx->cfg_is_debug) {
+            printf("%s\n", PRF_LIB_HEADER);
+        }
+    }
+
+    pthread_cleanup_pop(1);
+
+    return NULL;
+}
+
+/*
+ * creates the shared-memory segment <cfg_shm_name>, or takes over the segment of a publisher that died,
+ * and initializes its header
+ * the publisher holds an exclusive flock() on the segment until prf_ctx_destroy(), a segment whose lock is held
+ * belongs to a running collector and is refused, the lock of a dead process is released by the kernel
+ */
+static bool prf_shm_create(prf_ctx_t* ctx) {
+    prf_shm_layout_t*   map;
+    int                 fd;
+    bool                is_created;
+
+    fd = shm_open(ctx->cfg_shm_name, O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+    is_created = (fd >= 0);
+    if (fd < 0 && errno == EEXIST) {
+        fd = shm_open(ctx->cfg_shm_name, O_RDWR | O_CLOEXEC, 0);
+    }
+    if (fd < 0) {
+        fprintf(stderr, "** ERROR - unable to open shared memory '%s': %s\n", ctx->cfg_shm_name, strerror(errno));
+        return false;
+    }
+
+    if (flock(fd, LOCK_EX | LOCK_NB) < 0) {
+        if (errno == EWOULDBLOCK) {
+            fprintf(stderr, "** ERROR - shared memory '%s' is published by another collector\n", ctx->cfg_shm_name);
+        } else {
+            fprintf(stderr, "** ERROR - unable to lock shared memory '%s': %s\n", ctx->cfg_shm_name, strerror(errno));
+        }
+        close(fd);
+        return false;
+    }
+
+    map = (ftruncate(fd, sizeof(prf_shm_layout_t)) == 0) ?
+          mmap(NULL, sizeof(prf_shm_layout_t), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0) : MAP_FAILED;
+    if (map == MAP_FAILED) {
+        fprintf(stderr, "** ERROR - unable to map shared memory '%s': %s\n", ctx->cfg_shm_name, strerror(errno));
+        // a segment of a dead publisher stays for the next attempt, a new one is removed
+        if (is_created) {
+            shm_unlink(ctx->cfg_shm_name);
+        }
+        close(fd);
+        return false;
+    }
+
+    // readers of a previous publisher reject the segment until the header is complete
+    atomic_store_explicit(&map->magic, 0, memory_order_relaxed);
+    atomic_store_explicit(&map->seq, 0, memory_order_relaxed);
+    map->version        = PRF_SHM_VERSION;
+    map->size           = sizeof(prf_shm_layout_t);
+    map->metric_count   = PRF_METRIC_COUNT;
+    map->pid            = getpid();
+    map->hist_count     = 0;
+    atomic_store_explicit(&map->magic, PRF_SHM_MAGIC, memory_order_release);
+
+    ctx->shm    = map;
+    ctx->shm_fd = fd;
+
+    return true;
+}
+
+/*
+ * copies snapshot <snap> and its metrics <v> into the shared-memory segment, if any
+ */
+static void prf_shm_publish(prf_ctx_t* ctx, const prf_snapshot_t* snap, const float v[PRF_METRIC_COUNT]) {
+    prf_shm_layout_t*   map     = ctx->shm;
+    unsigned long       seq;
+    int                 slot;
+
+    if (map == NULL) {
+        return;
+    }
+
+    seq  = atomic_load_explicit(&map->seq, memory_order_relaxed);
+    slot = (int)(map->hist_count % PRF_SHM_HISTORY_LEN);
+
+    atomic_store_explicit(&map->seq, seq + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    memcpy(&map->snapshot, snap, sizeof(*snap));
+    map->hist_stamp[slot] = (double)snap->stamp.tv_sec + (double)snap->stamp.tv_nsec / 1000000000.0;
+    for (int m = 0; m < PRF_METRIC_COUNT; m++) {
+        map->hist_val[m][slot] = v[m];
+    }
+    map->hist_count++;
+    atomic_store_explicit(&map->seq, seq + 2, memory_order_release);
+}
+
+/*
+ * creates or continues the ring file <path> of <len> records and maps it
+ * a file of another version or size is started over
+ */
+static bool prf_rec_create(prf_ctx_t* ctx, const char* path, int len) {
+    prf_rec_header_t    header;
+    prf_rec_header_t*   map;
+    uint32_t            capacity    = (len > 0) ? (uint32_t)len : PRF_REC_DEF_LEN;
+    size_t              size        = sizeof(prf_rec_header_t) + (size_t)capacity * sizeof(prf_rec_t);
+    struct stat         st;
+    bool                is_valid;
+    int                 fd;
+    int                 err;
+
+    fd = open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        fprintf(stderr, "** ERROR - unable to open recording '%s': %s\n", path, strerror(errno));
+        return false;
+    }
+
+    // a recording truncated after a crash or by another tool is started anew, a write past its end raises SIGBUS
+    is_valid = (fstat(fd, &st) == 0 && st.st_size >= (off_t)size &&
+                pread(fd, &header, sizeof(header), 0) == (ssize_t)sizeof(header) &&
+                header.magic == PRF_REC_MAGIC && header.version == PRF_REC_VERSION &&
+                header.header_size == sizeof(prf_rec_header_t) && header.record_size == sizeof(prf_rec_t) &&
+                header.capacity == capacity && header.metric_count == PRF_METRIC_COUNT);
+
+    // preallocated, a full disk fails here instead of with a SIGBUS on a write to the mapping
+    err = is_valid ? 0 : (ftruncate(fd, 0) < 0) ? errno : posix_fallocate(fd, 0, (off_t)size);
+    if (err != 0) {
+        fprintf(stderr, "** ERROR - unable to allocate recording '%s': %s\n", path, strerror(err));
+        close(fd);
+        return false;
+    }
+
+    map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        fprintf(stderr, "** ERROR - unable to map recording '%s': %s\n", path, strerror(errno));
+        return false;
+    }
+
+    if (!is_valid) {
+        map->version        = PRF_REC_VERSION;
+        map->header_size    = sizeof(prf_rec_header_t);
+        map->record_size    = sizeof(prf_rec_t);
+        map->capacity       = capacity;
+        map->metric_count   = PRF_METRIC_COUNT;
+        atomic_store_explicit(&map->count, 0, memory_order_relaxed);
+        atomic_thread_fence(memory_order_release);
+        map->magic          = PRF_REC_MAGIC;
+    }
+
+    ctx->rec        = map;
+    ctx->rec_size   = size;
+
+    return true;
+}
+
+/*
+ * returns record <index> of the ring file <rec>
+ */
+static inline prf_rec_t* prf_rec_get(const prf_rec_header_t* rec, uint64_t index) {
+    return (prf_rec_t*)((char*)rec + rec->header_size) + (index % rec->capacity);
+}
+
+/*
+ * appends snapshot <snap> to the recording, if any: a copy into the mapping, the kernel writes it back
+ */
+static void prf_rec_append(prf_ctx_t* ctx, const prf_snapshot_t* snap) {
+    prf_rec_t*          record;
+    uint64_t            count;
+
+    if (ctx->rec == NULL || ctx->is_replay) {
+        return;
+    }
+
+    count  = atomic_load_explicit(&ctx->rec->count, memory_order_relaxed);
+    record = prf_rec_get(ctx->rec, count);
+    clock_gettime(CLOCK_REALTIME, &record->wall);
+    record->snap = *snap;
+    atomic_store_explicit(&ctx->rec->count, count + 1, memory_order_release);
+}
+
+/*
+ * publishes the assembled snapshot <snap>: the copy for the readers, the history, the shared memory,
+ * the recording, the subscriptions and the gates
+ */
+static void prf_store_snapshot(prf_ctx_t* ctx, const prf_snapshot_t* snap) {
+    float               v[PRF_METRIC_COUNT];
+    unsigned long       seq     = atomic_load_explicit(&ctx->snapshot_seq, memory_order_relaxed);
+
+    atomic_store_explicit(&ctx->snapshot_seq, seq + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    memcpy(&ctx->snapshot, snap, sizeof(*snap));
+    atomic_store_explicit(&ctx->snapshot_seq, seq + 2, memory_order_release);
+
+    prf_get_metric_values(ctx, snap, v);
+    prf_append_history(ctx, v, &snap->stamp);
+    prf_shm_publish(ctx, snap, v);
+    prf_rec_append(ctx, snap);
+    prf_notify_subs(ctx, v, &snap->stamp);
+    prf_update_gates(ctx);
+}
+
+void prf_publish_snapshot(prf_ctx_t* ctx) {
+    prf_snapshot_t      snap;
+    unsigned long       seq     = atomic_load_explicit(&ctx->snapshot_seq, memory_order_relaxed);
+
+    // assembled outside of the write section, which is a single copy
+    memset(&snap, 0, sizeof(snap));
+    snap.seq                = seq / 2 + 1;
+    clock_gettime(CLOCK_MONOTONIC, &snap.stamp);
+    prf_get_load_avg(ctx, snap.load_avg);
+    prf_get_load_ewma(ctx, snap.load_ewma);
+    snap.threshold          = prf_get_current_threshold(ctx);
+    snap.is_overloaded      = (snap.threshold >= ctx->cfg_cpu_threshold);
+    prf_get_cpu_pt_info(ctx, snap.cpu_pt);
+    prf_get_cpu_pt_total(ctx, snap.cpu_total_pt);
+    snap.cpu_count          = prf_get_cpu_count(ctx);
+    snap.cpu_busiest        = prf_get_cpu_busiest(ctx, &snap.cpu_busiest_load);
+    prf_get_current_mem_info(ctx, snap.mem);
+    snap.mem_available      = ctx->mem[PRF_MEM_AVAILABLE];
+    prf_get_net_rate_info(ctx, snap.net_rate);
+    prf_get_net_total(ctx, &snap.net_total);
+    memcpy(snap.psi, ctx->psi, sizeof(snap.psi));
+    prf_get_disk_total(ctx, &snap.disk_total);
+    snap.cgroup             = ctx->cgroup;
+    prf_get_vmstat_info(ctx, &snap.vmstat);
+    memcpy(snap.softirq, ctx->softirq_dist, sizeof(snap.softirq));
+    snap.irq                = ctx->irq_dist;
+    snap.interval           = ctx->interval_seconds;
+
+    prf_store_snapshot(ctx, &snap);
+}
+
+bool prf_get_snapshot(prf_ctx_t* ctx, prf_snapshot_t* snap) {
+    unsigned long       seq_begin;
+    unsigned long       seq_end;
+
+    do {
+        seq_begin = atomic_load_explicit(&ctx->snapshot_seq, memory_order_acquire);
+        if (seq_begin == 0) {
+            return false;
+        }
+
+        memcpy(snap, &ctx->snapshot, sizeof(*snap));
+        atomic_thread_fence(memory_order_acquire);
+        seq_end = atomic_load_explicit(&ctx->snapshot_seq, memory_order_relaxed);
+        // retry if a write was in progress or started meanwhile
+    } while ((seq_begin & 1) || seq_begin != seq_end);
+
+    return true;
+}
+
+prf_shm_t* prf_shm_open(const char* name) {
+    prf_shm_t*                  shm;
+    const prf_shm_layout_t*     map;
+    struct stat                 st;
+    int                         fd;
+
+    fd = shm_open(name, O_RDONLY | O_CLOEXEC, 0);
+    if (fd < 0) {
+        fprintf(stderr, "** ERROR - unable to open shared memory '%s': %s\n", name, strerror(errno));
+        return NULL;
+    }
+
+    if (fstat(fd, &st) < 0 || st.st_size < (off_t)sizeof(prf_shm_layout_t)) {
+        fprintf(stderr, "** ERROR - shared memory '%s' is not a segment of this library\n", name);
+        close(fd);
+        return NULL;
+    }
+
+    map = mmap(NULL, sizeof(prf_shm_layout_t), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        fprintf(stderr, "** ERROR - unable to map shared memory '%s': %s\n", name, strerror(errno));
+        return NULL;
+    }
+
+    if (atomic_load_explicit(&map->magic, memory_order_acquire) != PRF_SHM_MAGIC ||
+        map->version != PRF_SHM_VERSION || map->size != sizeof(prf_shm_layout_t) ||
+        map->metric_count != PRF_METRIC_COUNT) {
+        fprintf(stderr, "** ERROR - shared memory '%s' is not a segment of this library version\n", name);
+        munmap((void*)map, sizeof(prf_shm_layout_t));
+        return NULL;
+    }
+
+    shm = calloc(1, sizeof(prf_shm_t));
+    if (shm == NULL) {
+        munmap((void*)map, sizeof(prf_shm_layout_t));
+        return NULL;
+    }
+    shm->map = map;
+
+    return shm;
+}
+
+void prf_shm_close(prf_shm_t* shm) {
+    if (shm != NULL) {
+        munmap((void*)shm->map, sizeof(prf_shm_layout_t));
+        free(shm);
+    }
+}
+
+bool prf_shm_get_snapshot(prf_shm_t* shm, prf_snapshot_t* snap) {
+    const prf_shm_layout_t*     map = shm->map;
+    unsigned long               seq_begin;
+    unsigned long               seq_end;
+
+    // bounded: a publisher that died mid-write leaves <seq> odd for good
+    for (int i = 0; i < PRF_SHM_READ_TRIES; i++) {
+        seq_begin = atomic_load_explicit(&map->seq, memory_order_acquire);
+        if (seq_begin == 0) {
+            return false;
+        }
+        if (seq_begin & 1) {
+            // the publisher is writing, or was preempted while writing
+            sched_yield();
+            continue;
+        }
+
+        memcpy(snap, &map->snapshot, sizeof(*snap));
+        atomic_thread_fence(memory_order_acquire);
+        seq_end = atomic_load_explicit(&map->seq, memory_order_relaxed);
+        if (seq_begin == seq_end) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+int prf_shm_get_history(prf_shm_t* shm, prf_metric_t metric, float* v, double* stamps, int max) {
+    const prf_shm_layout_t*     map = shm->map;
+    unsigned long               seq_begin;
+    unsigned long               seq_end;
+    unsigned long               total;
+    int                         count;
+    int                         slot;
+
+    if (metric < 0 || metric >= PRF_METRIC_COUNT || max < 1) {
+        return 0;
+    }
+
+    // bounded like prf_shm_get_snapshot()
+    for (int tries = 0; tries < PRF_SHM_READ_TRIES; tries++) {
+        seq_begin = atomic_load_explicit(&map->seq, memory_order_acquire);
+        if (seq_begin & 1) {
+            sched_yield();
+            continue;
+        }
+
+        total = map->hist_count;
+        count = (total < (unsigned long)max) ? (int)total : max;
+        count = (count < PRF_SHM_HISTORY_LEN) ? count : PRF_SHM_HISTORY_LEN;
+        for (int i = 0; i < count; i++) {
+            slot = (int)((total - count + i) % PRF_SHM_HISTORY_LEN);
+            v[i] = map->hist_val[metric][slot];
+            if (stamps != NULL) {
+                stamps[i] = map->hist_stamp[slot];
+            }
+        }
+
+        atomic_thread_fence(memory_order_acquire);
+        seq_end = atomic_load_explicit(&map->seq, memory_order_relaxed);
+        if (seq_begin == seq_end) {
+            return count;
+        }
+    }
+
+    return -1;
+}
+
+pid_t prf_shm_get_publisher(prf_shm_t* shm) {
+    return shm->map->pid;
+}
+
+bool prf_get_history_stats(prf_ctx_t* ctx, prf_metric_t metric, float window, prf_stats_t* stats) {
+    double              from    = prf_history_window_start(ctx, window);
+    unsigned long       seq_begin;
+    unsigned long       seq_end;
+    int                 len;
+    int                 first;
+    int                 count;
+    const float*        min;
+    const float*        max;
+
+    if (metric < 0 || metric >= PRF_METRIC_COUNT || ctx->hist_len == 0) {
+        return false;
+    }
+
+    do {
+        seq_begin = atomic_load_explicit(&ctx->hist_seq, memory_order_acquire);
+
+        len   = ctx->hist_len;
+        count = prf_find_history_window(ctx, from, &first);
+        min   = &ctx->hist_min[metric * 2 * len];
+        max   = &ctx->hist_max[metric * 2 * len];
+
+        if (count > 0) {
+            stats->count = count;
+            stats->min   = FLT_MAX;
+            stats->max   = -FLT_MAX;
+
+            // the window may wrap around the end of the ring
+            if (first + count <= len) {
+                prf_query_tree(min, max, len, first, first + count, &stats->min, &stats->max);
+            } else {
+                prf_query_tree(min, max, len, first, len, &stats->min, &stats->max);
+                prf_query_tree(min, max, len, 0, first + count - len, &stats->min, &stats->max);
+            }
+
+            // the window always ends with the latest sample
+            stats->mean  = (float)((ctx->hist_total[metric] - ctx->hist_sum[metric * len + first]) / count);
+            stats->ewma  = ctx->hist_ewma[metric];
+            stats->last  = ctx->hist_val[metric * len + ((first + count - 1) & (len - 1))];
+        }
+
+        atomic_thread_fence(memory_order_acquire);
+        seq_end = atomic_load_explicit(&ctx->hist_seq, memory_order_relaxed);
+        // retry if an append was in progress or started meanwhile
+    } while ((seq_begin & 1) || seq_begin != seq_end);
+
+    return (count > 0);
+}
+
+bool prf_get_history_percentile(prf_ctx_t* ctx, prf_metric_t metric, float window, float percentile, float* value) {
+    double              from    = prf_history_window_start(ctx, window);
+    unsigned long       seq_begin;
+    unsigned long       seq_end;
+    int                 len     = ctx->hist_len;
+    int                 first;
+    int                 count;
+    int                 rank;
+    float               pos;
+    float               buff[(len > 0) ? len : 1];
+
+    if (metric < 0 || metric >= PRF_METRIC_COUNT || len == 0) {
+        return false;
+    }
+
+    do {
+        seq_begin = atomic_load_explicit(&ctx->hist_seq, memory_order_acquire);
+
+        count = prf_find_history_window(ctx, from, &first);
+        for (int i = 0; i < count; i++) {
+            buff[i] = ctx->hist_val[metric * len + ((first + i) & (len - 1))];
+        }
+
+        atomic_thread_fence(memory_order_acquire);
+        seq_end = atomic_load_explicit(&ctx->hist_seq, memory_order_relaxed);
+    } while ((seq_begin & 1) || seq_begin != seq_end);
+
+    if (count < 1) {
+        return false;
+    }
+
+    // nearest rank: the smallest value with at least <percentile> % of the samples at or below it
+    pos  = percentile / 100.0 * (float)count;
+    rank = (int)pos;
+    if ((float)rank < pos) {
+        rank++;
+    }
+    rank = (rank < 1) ? 1 : (rank > count) ? count : rank;
+
+    *value = prf_select_kth(buff, count, rank - 1);
+
+    return true;
+}
+
+int prf_subscribe(prf_ctx_t* ctx, const prf_sub_t* sub) {
+    int     id = -1;
+
+    if (sub == NULL || sub->metric < 0 || sub->metric >= PRF_METRIC_COUNT) {
+        fprintf(stderr, "** ERROR - invalid subscription\n");
+        return -1;
+    }
+
+    pthread_mutex_lock(&ctx->sub_lock);
+
+    for (int i = 0; i < PRF_SUB_MAX && id < 0; i++) {
+        if (ctx->sub_fds[i] < 0) {
+            ctx->sub_fds[i] = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+            if (ctx->sub_fds[i] >= 0) {
+                id                      = i;
+                ctx->subs[i]            = *sub;
+                ctx->subs[i].hysteresis = (sub->hysteresis > 0.0) ? sub->hysteresis : 0.0;
+                ctx->sub_is_above[i]    = false;
+                ctx->sub_has_fired[i]   = false;
+            } else {
+                fprintf(stderr, "** ERROR - unable to create an eventfd for the subscription\n");
+                break;
+            }
+        }
+    }
+
+    pthread_mutex_unlock(&ctx->sub_lock);
+
+    return id;
+}
+
+void prf_unsubscribe(prf_ctx_t* ctx, int sub_id) {
+    if (sub_id < 0 || sub_id >= PRF_SUB_MAX) {
+        return;
+    }
+
+    pthread_mutex_lock(&ctx->sub_lock);
+
+    if (ctx->sub_fds[sub_id] >= 0) {
+        close(ctx->sub_fds[sub_id]);
+        ctx->sub_fds[sub_id] = -1;
+    }
+
+    pthread_mutex_unlock(&ctx->sub_lock);
+}
+
+int prf_get_sub_fd(prf_ctx_t* ctx, int sub_id) {
+    int     fd = -1;
+
+    if (sub_id >= 0 && sub_id < PRF_SUB_MAX) {
+        pthread_mutex_lock(&ctx->sub_lock);
+        fd = ctx->sub_fds[sub_id];
+        pthread_mutex_unlock(&ctx->sub_lock);
+    }
+
+    return fd;
+}
+
+bool prf_get_sub_event(prf_ctx_t* ctx, int sub_id, prf_event_t* event) {
+    bool    status = false;
+
+    if (sub_id >= 0 && sub_id < PRF_SUB_MAX) {
+        pthread_mutex_lock(&ctx->sub_lock);
+        if (ctx->sub_fds[sub_id] >= 0 && ctx->sub_has_fired[sub_id]) {
+            *event = ctx->sub_events[sub_id];
+            status = true;
+        }
+        pthread_mutex_unlock(&ctx->sub_lock);
+    }
+
+    return status;
+}
+
+prf_gate_t* prf_gate_create(prf_ctx_t* ctx, const prf_gate_cfg_t* cfg) {
+    prf_gate_t*         gate;
+    pthread_condattr_t  attr;
+    int                 slot    = -1;
+
+    if (ctx == NULL || cfg == NULL || cfg->rule_count < 1 || cfg->rule_count > PRF_GATE_MAX_RULES) {
+        fprintf(stderr, "** ERROR - invalid gate\n");
+        return NULL;
+    }
+
+    for (int i = 0; i < cfg->rule_count; i++) {
+        if (cfg->rules[i].metric < 0 || cfg->rules[i].metric >= PRF_METRIC_COUNT) {
+            fprintf(stderr, "** ERROR - invalid gate rule %d\n", i);
+            return NULL;
+        }
+    }
+
+    gate = (prf_gate_t*)calloc(1, sizeof(prf_gate_t));
+    if (gate == NULL) {
+        fprintf(stderr, "** ERROR - memory error!");
+        return NULL;
+    }
+
+    gate->ctx                   = ctx;
+    gate->cfg                   = *cfg;
+    gate->cfg.release_burst     = (cfg->release_burst > 0) ? cfg->release_burst : 1;
+    gate->cfg.release_rate      = (cfg->release_rate > 0.0) ? cfg->release_rate : 0.0;
+    for (int i = 0; i < cfg->rule_count; i++) {
+        if (gate->cfg.rules[i].low > gate->cfg.rules[i].high) {
+            gate->cfg.rules[i].low = gate->cfg.rules[i].high;
+        }
+    }
+
+    gate->tokens = (float)gate->cfg.release_burst;
+    clock_gettime(CLOCK_MONOTONIC, &gate->token_stamp);
+
+    // timed waits on CLOCK_MONOTONIC, like the collector
+    pthread_mutex_init(&gate->lock, NULL);
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&gate->cond, &attr);
+    pthread_condattr_destroy(&attr);
+
+    // the history may already hold samples
+    prf_eval_gate(gate);
+
+    pthread_mutex_lock(&ctx->gate_lock);
+    for (int i = 0; i < PRF_GATE_MAX && slot < 0; i++) {
+        if (ctx->gates[i] == NULL) {
+            ctx->gates[i] = gate;
+            slot          = i;
+        }
+    }
+    pthread_mutex_unlock(&ctx->gate_lock);
+
+    if (slot < 0) {
+        fprintf(stderr, "** ERROR - all %d gates are taken\n", PRF_GATE_MAX);
+        pthread_cond_destroy(&gate->cond);
+        pthread_mutex_destroy(&gate->lock);
+        free(gate);
+        return NULL;
+    }
+
+    return gate;
+}
+
+void prf_gate_destroy(prf_gate_t* gate) {
+    if (gate == NULL) {
+        return;
+    }
+
+    pthread_mutex_lock(&gate->ctx->gate_lock);
+    for (int i = 0; i < PRF_GATE_MAX; i++) {
+        if (gate->ctx->gates[i] == gate) {
+            gate->ctx->gates[i] = NULL;
+        }
+    }
+    pthread_mutex_unlock(&gate->ctx->gate_lock);
+
+    pthread_cond_destroy(&gate->cond);
+    pthread_mutex_destroy(&gate->lock);
+    free(gate);
+}
+
+bool prf_gate_check(prf_gate_t* gate, prf_gate_verdict_t* verdict) {
+    bool    admit;
+
+    pthread_mutex_lock(&gate->lock);
+    admit = gate->verdict.admit;
+    if (verdict != NULL) {
+        *verdict = gate->verdict;
+    }
+    pthread_mutex_unlock(&gate->lock);
+
+    return admit;
+}
+
+bool prf_gate_wait(prf_gate_t* gate, float timeout_s, prf_gate_verdict_t* verdict) {
+    prf_gate_waiter_t   self        = {NULL};
+    prf_gate_waiter_t*  waiter;
+    prf_gate_waiter_t*  prev        = NULL;
+    struct timespec     now;
+    struct timespec     deadline;
+    struct timespec     wake;
+    bool                admitted    = false;
+    bool                has_wake;
+
+    clock_gettime(CLOCK_MONOTONIC, &deadline);
+    prf_add_seconds(&deadline, (timeout_s > 0.0) ? timeout_s : 0.0);
+
+    pthread_mutex_lock(&gate->lock);
+
+    // first come, first served
+    if (gate->tail != NULL) {
+        gate->tail->next = &self;
+    } else {
+        gate->head = &self;
+    }
+    gate->tail = &self;
+    gate->waiting++;
+
+    for (;;) {
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        has_wake = (timeout_s >= 0.0);
+        wake     = deadline;
+
+        if (gate->head == &self && !gate->is_deferring) {
+            if (gate->cfg.release_rate > 0.0) {
+                gate->tokens += (float)(prf_elapsed_seconds(&gate->token_stamp, &now) * gate->cfg.release_rate);
+                gate->tokens  = (gate->tokens < (float)gate->cfg.release_burst) ? gate->tokens : (float)gate->cfg.release_burst;
+            }
+            gate->token_stamp = now;
+
+            if (gate->cfg.release_rate <= 0.0 || gate->tokens >= 1.0) {
+                gate->tokens -= (gate->cfg.release_rate > 0.0) ? 1.0 : 0.0;
+                admitted = true;
+                break;
+            }
+
+            // the next token, unless the timeout comes first
+            wake = now;
+            prf_add_seconds(&wake, (1.0 - gate->tokens) / gate->cfg.release_rate);
+            if (has_wake && prf_elapsed_seconds(&deadline, &wake) > 0.0) {
+                wake = deadline;
+            }
+            has_wake = true;
+        }
+
+        if (timeout_s >= 0.0 && prf_elapsed_seconds(&deadline, &now) >= 0.0) {
+            break;
+        }
+
+        if (has_wake) {
+            pthread_cond_timedwait(&gate->cond, &gate->lock, &wake);
+        } else {
+            pthread_cond_wait(&gate->cond, &gate->lock);
+        }
+    }
+
+    // leave the queue, the next waiter may be up
+    for (waiter = gate->head; waiter != &self; waiter = waiter->next) {
+        prev = waiter;
+    }
+    if (prev != NULL) {
+        prev->next = self.next;
+    } else {
+        gate->head = self.next;
+    }
+    if (gate->tail == &self) {
+        gate->tail = prev;
+    }
+    gate->waiting--;
+    pthread_cond_broadcast(&gate->cond);
+
+    if (verdict != NULL) {
+        *verdict       = gate->verdict;
+        verdict->admit = admitted;
+        if (!admitted && !gate->is_deferring) {
+            snprintf(verdict->reason, sizeof(verdict->reason), "rate limited, %d waiting", gate->waiting + 1);
+        }
+    }
+
+    pthread_mutex_unlock(&gate->lock);
+
+    return admitted;
+}
+
+const char* prf_get_metric_name(prf_metric_t metric) {
+    return (metric >= 0 && metric < PRF_METRIC_COUNT) ? prf_metric_names[metric] : NULL;
+}
+
+void prf_print_history(prf_ctx_t* ctx, float window) {
+    prf_stats_t     stats;
+    float           p95;
+
+    printf("HISTORY: last %.1fs\n%-17s | %6s %14s %14s %14s %14s %14s\n",
+            window, "Metric", "count", "min", "max", "mean", "ewma", "p95");
+
+    for (int m = 0; m < PRF_METRIC_COUNT; m++) {
+        if (prf_get_history_stats(ctx, m, window, &stats) &&
+            prf_get_history_percentile(ctx, m, window, 95.0, &p95)) {
+            printf("%-17s | %6d %14.2f %14.2f %14.2f %14.2f %14.2f\n",
+                    prf_metric_names[m], stats.count, stats.min, stats.max, stats.mean, stats.ewma, p95);
+        }
+    }
+
+    printf("%s\n", PRF_LIB_HEADER);
+}
+
+/*
+ * reports whether the /proc read of the fields sysinfo() lacks, last at <stamp>, is due at <now>
+ */
+static inline bool prf_is_sysinfo_refresh(const struct timespec* stamp, const struct timespec* now) {
+    return (stamp->tv_sec == 0 && stamp->tv_nsec == 0) || prf_elapsed_seconds(stamp, now) >= PRF_SYSINFO_REFRESH_S;
+}
+
+/*
+ * reads the load averages and the number of tasks with a single sysinfo() call,
+ * the runnable tasks from /proc/loadavg once per PRF_SYSINFO_REFRESH_S, in between the load estimators use the last ones
+ */
+static bool prf_read_load_sysinfo(prf_ctx_t* ctx) {
+    long            size    = PRF_AVG_BUFF_SIZE;
+    char            buff[size];
+    struct sysinfo  info;
+    struct timespec now;
+
+    if (sysinfo(&info) < 0) {
+        return false;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    if (prf_is_sysinfo_refresh(&ctx->sys_load_stamp, &now) && prf_read_proc_file(ctx, PRF_FILE_LOAD_AVG, buff, size) >= 0) {
+        sscanf(buff, "%*f %*f %*f %d/%d", &ctx->load_running, &ctx->load_tasks);
+        ctx->sys_load_stamp = now;
+    }
+
+    // fixed point with SI_LOAD_SHIFT fraction bits, like the kernel's own avenrun[]
+    for (int i = 0; i < 3; i++) {
+        ctx->load_avg[i] = (float)info.loads[i] / (float)(1 << SI_LOAD_SHIFT);
+    }
+    ctx->load_tasks = info.procs;
+
+    ctx->file_stamps[PRF_FILE_LOAD_AVG] = now;
+
+    return true;
+}
+
+bool prf_read_load_avg(prf_ctx_t* ctx) {
+    bool    status = false;
+    long    size   = PRF_AVG_BUFF_SIZE;
+    char    buff[size];
+
+    if (ctx->cfg_sys_backend == PRF_SYS_BACKEND_SYSINFO) {
+        return prf_read_load_sysinfo(ctx);
+    }
+
+    ctx->load_avg[0] = ctx->load_avg[1] = ctx->load_avg[2] = 0.0;
+    ctx->load_running = ctx->load_tasks = 0;
+
+    if (prf_read_proc_file(ctx, PRF_FILE_LOAD_AVG, buff, size) >= 0) {
+        sscanf(buff, "%f %f %f %d/%d",
+                      &ctx->load_avg[0], &ctx->load_avg[1], &ctx->load_avg[2], &ctx->load_running, &ctx->load_tasks);
+        status = true;
+    }
+
+    return status;
+}
+
+void prf_print_load_avg(prf_ctx_t* ctx) {
+    printf("READ: %s\n\
+Load average: %4.2f, %4.2f, %4.2f\n\
+Load EWMA %.0fs/%.0fs/%.0fs: %4.2f, %4.2f, %4.2f\n\
+Runnable: %d/%d\n%s\n",
+           (ctx->cfg_sys_backend == PRF_SYS_BACKEND_SYSINFO) ? PRF_SYSINFO_CALL : PRF_LOAD_AVG_FILE,
+           ctx->load_avg[0], ctx->load_avg[1], ctx->load_avg[2],
+           ctx->cfg_load_ewma_s[0], ctx->cfg_load_ewma_s[1], ctx->cfg_load_ewma_s[2],
+           ctx->load_ewma[0], ctx->load_ewma[1], ctx->load_ewma[2],
+           ctx->load_running, ctx->load_tasks,
+           PRF_LIB_HEADER);
+}
+
+void prf_get_load_avg(prf_ctx_t* ctx, float v[3]) {
+    memcpy(v, ctx->load_avg, sizeof(ctx->load_avg));
+}
+
+void prf_get_load_ewma(prf_ctx_t* ctx, float v[3]) {
+    memcpy(v, ctx->load_ewma, sizeof(ctx->load_ewma));
+}
+
+float prf_get_current_load_avg(prf_ctx_t* ctx) {
+    return prf_select_load_avg(ctx->cfg_cpu_load_type, ctx->load_avg, ctx->load_ewma);
+}
+
+bool prf_is_valid_load_avg_val(int val) {
+    switch (val) {
+        case TYPE_EWMA_1:
+        case TYPE_EWMA_2:
+        case TYPE_EWMA_3:
+        case TYPE_MIN_1:
+        case TYPE_MIN_5:
+        case TYPE_MIN_15:
+            return true;
+            break;
+
+        default:
+            return false;
+            break;
+    }
+}
+
+float prf_get_current_interval(prf_ctx_t* ctx) {
+    return ctx->interval_seconds;
+}
+
+float prf_get_current_threshold(prf_ctx_t* ctx) {
+    switch (ctx->cfg_threshold_source) {
+        case PRF_THRESHOLD_PSI_CPU:
+            return ctx->psi[PRF_PSI_CPU].some_rate;
+
+        case PRF_THRESHOLD_PSI_MEMORY:
+            return ctx->psi[PRF_PSI_MEMORY].some_rate;
+
+        case PRF_THRESHOLD_PSI_IO:
+            return ctx->psi[PRF_PSI_IO].some_rate;
+
+        case PRF_THRESHOLD_CGROUP_CPU:
+            return ctx->cgroup.cpu_pt;
+
+        case PRF_THRESHOLD_CGROUP_MEMORY:
+            return ctx->cgroup.mem_pt;
+
+        case PRF_THRESHOLD_LOAD_AVG:
+        default:
+            return prf_get_current_load_avg(ctx);
+    }
+}
+
+bool prf_get_threshold_source(const char* name, prf_threshold_src_t* src) {
+    for (int i = 0; name != NULL && i < PRF_THRESHOLD_SOURCE_COUNT; i++) {
+        if (strcmp(name, prf_threshold_names[i]) == 0) {
+            *src = (prf_threshold_src_t)i;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+const char* prf_get_threshold_source_name(prf_threshold_src_t src) {
+    return (src >= 0 && src < PRF_THRESHOLD_SOURCE_COUNT) ? prf_threshold_names[src] : NULL;
+}
+
+bool prf_read_psi_info(prf_ctx_t* ctx) {
+    bool    status = true;
+    long    size   = PRF_PSI_BUFF_SIZE;
+    char    buff[size];
+    long    len;
+
+    for (int i = 0; i < PRF_PSI_COUNT; i++) {
+        len = prf_read_proc_file(ctx, PRF_FILE_PSI_CPU + i, buff, size);
+        if (len < 0 || !prf_parse_psi_info(ctx, i, buff, len, &ctx->file_stamps[PRF_FILE_PSI_CPU + i])) {
+            status = false;
+        }
+    }
+
+    return status;
+}
+
+/*
+ * returns the percentage of <seconds> stalled, from the stall time delta of the totals <now> and <last> in us
+ */
+static inline float prf_calc_stall_rate(unsigned long now, unsigned long last, double seconds) {
+    float   rate = (now > last) ? (float)((double)(now - last) / (seconds * 10000.0)) : 0.0;
+
+    // the totals and the stamp are not taken at the same instant
+    return (rate < 100.0) ? rate : 100.0;
+}
+
+bool prf_parse_psi_info(prf_ctx_t* ctx, prf_psi_resource_t resource, const char* buffer, long size,
+                        const struct timespec* stamp) {
+    const char*         p       = buffer;
+    const char*         end     = buffer + size;
+    prf_psi_t*          last    = &ctx->psi[resource];
+    prf_psi_t           psi;
+    float*              avg;
+    unsigned long*      total;
+    struct timespec     now;
+    double              seconds;
+    bool                found   = false;
+
+    if (buffer == NULL || size <= 0 || resource < 0 || resource >= PRF_PSI_COUNT) {
+        return false;
+    }
+
+    if (stamp == NULL) {
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        stamp = &now;
+    }
+
+    memset(&psi, 0, sizeof(psi));
+
+    // "some avg10=0.00 avg60=0.00 avg300=0.00 total=0\n", then the same for "full"
+    while (p != NULL && end - p > 4) {
+        if (memcmp(p, "some", 4) == 0) {
+            avg   = psi.some_avg;
+            total = &psi.some_total;
+        } else if (memcmp(p, "full", 4) == 0) {
+            avg   = psi.full_avg;
+            total = &psi.full_total;
+        } else {
+            break;
+        }
+
+        for (int i = 0; i < 3 && p != NULL; i++) {
+            p = memchr(p, '=', end - p);
+            p = (p != NULL) ? p + 1 : NULL;
+            avg[i] = (p != NULL) ? prf_parse_decimal(&p, end) : 0.0;
+        }
+
+        p = (p != NULL) ? memchr(p, '=', end - p) : NULL;
+        if (p == NULL) {
+            break;
+        }
+        p++;
+        *total = prf_parse_ulong(&p, end);
+        found  = true;
+
+        p = memchr(p, '\n', end - p);
+        p = (p != NULL) ? p + 1 : NULL;
+    }
+
+    if (!found) {
+        return false;
+    }
+
+    // sub-second rates over the measured time since the previous read, the kernel's avg10 for the first one
+    seconds = ctx->psi_found[resource] ? prf_elapsed_seconds(&ctx->psi_stamp[resource], stamp) : 0.0;
+    if (seconds > 0.0) {
+        psi.some_rate = prf_calc_stall_rate(psi.some_total, last->some_total, seconds);
+        psi.full_rate = prf_calc_stall_rate(psi.full_total, last->full_total, seconds);
+    } else {
+        psi.some_rate = psi.some_avg[0];
+        psi.full_rate = psi.full_avg[0];
+    }
+
+    *last                       = psi;
+    ctx->psi_found[resource]    = true;
+    ctx->psi_stamp[resource]    = *stamp;
+
+    return true;
+}
+
+void prf_print_psi_info(prf_ctx_t* ctx) {
+    static const char*  names[PRF_PSI_COUNT] = {"cpu", "memory", "io"};
+    const prf_psi_t*    psi;
+
+    printf("READ: %s\n%-8s | %-6s %6s %6s %6s %7s | %-6s %6s %6s %6s %7s\n",
+            PRF_PSI_DIR,
+            "Resource", "some", "avg10", "avg60", "avg300", "rate", "full", "avg10", "avg60", "avg300", "rate");
+
+    for (int i = 0; i < PRF_PSI_COUNT; i++) {
+        if (ctx->psi_found[i]) {
+            psi = &ctx->psi[i];
+            printf("%-8s | %-6s %6.2f %6.2f %6.2f %6.2f%% | %-6s %6.2f %6.2f %6.2f %6.2f%%\n",
+                    names[i],
+                    "", psi->some_avg[0], psi->some_avg[1], psi->some_avg[2], psi->some_rate,
+                    "", psi->full_avg[0], psi->full_avg[1], psi->full_avg[2], psi->full_rate);
+        }
+    }
+
+    printf("%s\n", PRF_LIB_HEADER);
+}
+
+bool prf_get_psi_info(prf_ctx_t* ctx, prf_psi_resource_t resource, prf_psi_t* psi) {
+    if (resource < 0 || resource >= PRF_PSI_COUNT || !ctx->psi_found[resource]) {
+        return false;
+    }
+
+    *psi = ctx->psi[resource];
+
+    return true;
+}
+
+/*
+ * finds the directory of the cgroup v2 of the process: the "0::<path>" line of /proc/self/cgroup
+ * below the mount point of the cgroup2 file system
+ * returns a heap string, NULL if there is no cgroup v2
+ */
+static char* prf_find_cgroup_path(prf_ctx_t* ctx) {
+    FILE*       fl;
+    char*       line        = NULL;
+    size_t      line_size   = 0;
+    char*       cgroup      = NULL;
+    char*       root        = NULL;
+    char*       mount       = NULL;
+    char*       path        = NULL;
+    char*       fields[5];
+    char*       rest_line;
+    char*       sep;
+    size_t      root_len;
+
+    fl = prf_fopen_root(ctx, PRF_CGROUP_SELF_FILE);
+    while (fl != NULL && cgroup == NULL && getline(&line, &line_size, fl) > 0) {
+        if (strncmp(line, "0::", 3) == 0) {
+            line[strcspn(line, "\n")] = '\0';
+            cgroup = strdup(line + 3);
+        }
+    }
+    if (fl != NULL) {
+        fclose(fl);
+    }
+
+    // "<id> <parent> <major:minor> <root> <mount point> <options> ... - cgroup2 <source> <options>"
+    fl = (cgroup != NULL) ? prf_fopen_root(ctx, PRF_MOUNT_INFO_FILE) : NULL;
+    while (fl != NULL && mount == NULL && getline(&line, &line_size, fl) > 0) {
+        sep = strstr(line, " - cgroup2 ");
+        if (sep == NULL) {
+            continue;
+        }
+
+        rest_line = NULL;
+        fields[0] = strtok_r(line, " ", &rest_line);
+        for (int i = 1; i < 5; i++) {
+            fields[i] = (fields[i - 1] != NULL) ? strtok_r(NULL, " ", &rest_line) : NULL;
+        }
+
+        if (fields[4] != NULL) {
+            root  = strdup(fields[3]);
+            mount = strdup(fields[4]);
+        }
+    }
+    if (fl != NULL) {
+        fclose(fl);
+    }
+
+    if (cgroup != NULL && mount != NULL && root != NULL) {
+        // a mount of a subtree, f.e. a container without a cgroup namespace, starts at <root>,
+        // a whole path component: a root of "/a" is no prefix of "/ab/x"
+        root_len = strlen(root);
+        if (root_len > 1 && strncmp(cgroup, root, root_len) == 0 &&
+            (cgroup[root_len] == '/' || cgroup[root_len] == '\0')) {
+            memmove(cgroup, cgroup + root_len, strlen(cgroup + root_len) + 1);
+        }
+
+        path = (char*)malloc(strlen(mount) + strlen(cgroup) + 1);
+        if (path != NULL) {
+            strcpy(path, mount);
+            strcat(path, (strcmp(cgroup, "/") == 0) ? "" : cgroup);
+        }
+    }
+
+    prf_free_mem(line);
+    prf_free_mem(cgroup);
+    prf_free_mem(root);
+    prf_free_mem(mount);
+
+    return path;
+}
+
+/*
+ * opens the cgroup v2 of the process and its files, the files of disabled controllers are missing
+ */
+static bool prf_open_cgroup(prf_ctx_t* ctx) {
+    ctx->cgroup_is_probed = true;
+
+    prf_free_mem(ctx->cgroup_path);
+    ctx->cgroup_path = prf_find_cgroup_path(ctx);
+    if (ctx->cgroup_path == NULL) {
+        return false;
+    }
+
+    ctx->cgroup_dir_fd = prf_open_root(ctx, ctx->cgroup_path, O_PATH | O_DIRECTORY | O_CLOEXEC);
+    if (ctx->cgroup_dir_fd < 0) {
+        return false;
+    }
+
+    for (int i = 0; i < PRF_CGROUP_FILE_COUNT; i++) {
+        ctx->cgroup_fds[i] = openat(ctx->cgroup_dir_fd, prf_cgroup_file_names[i], O_RDONLY | O_CLOEXEC);
+    }
+
+    // cpu.stat is there for every cgroup, regardless of the controllers
+    return (ctx->cgroup_fds[PRF_CGROUP_FILE_CPU_STAT] >= 0);
+}
+
+/*
+ * finds the "<key> <value>" line of <key> in <buffer> and parses its value into <*value>
+ */
+static bool prf_find_key_value(const char* buffer, const char* end, const char* key, unsigned long* value) {
+    size_t          key_len = strlen(key);
+    const char*     p;
+
+    p = buffer;
+    while (p != NULL && end - p > (long)key_len) {
+        if (memcmp(p, key, key_len) == 0 && p[key_len] == ' ') {
+            p += key_len;
+            *value = prf_parse_ulong(&p, end);
+            return true;
+        }
+
+        p = memchr(p, '\n', end - p);
+        p = (p != NULL) ? p + 1 : NULL;
+    }
+
+    return false;
+}
+
+/*
+ * reads the cgroup file <file> into <buffer>, returns the number of bytes read, -1 if it is missing
+ */
+static long prf_read_cgroup_file(prf_ctx_t* ctx, prf_cgroup_file_t file, char* buffer, long size) {
+    int     fd = ctx->cgroup_fds[file];
+
+    return (fd >= 0) ? prf_read_slot(ctx, PRF_URING_CGROUP_SLOT(file), fd, buffer, size) : -1;
+}
+
+bool prf_read_cgroup_info(prf_ctx_t* ctx) {
+    char            buff[PRF_CGROUP_BUFF_SIZE];
+    const char*     p;
+    const char*     end;
+    long            len;
+    prf_cgroup_t    cg;
+    prf_cgroup_t*   last        = &ctx->cgroup;
+    struct timespec stamp;
+    double          seconds;
+
+    if (!ctx->cgroup_is_probed) {
+        ctx->cgroup_found = prf_open_cgroup(ctx);
+        if (!ctx->cgroup_found && (ctx->cfg_threshold_source == PRF_THRESHOLD_CGROUP_CPU ||
+                                   ctx->cfg_threshold_source == PRF_THRESHOLD_CGROUP_MEMORY)) {
+            fprintf(stderr, "** ERROR - unable to find the cgroup v2 of the process, the threshold stays 0\n");
+        }
+    }
+
+    if (!ctx->cgroup_found) {
+        return false;
+    }
+
+    memset(&cg, 0, sizeof(cg));
+
+    // "<quota|max> <period>"
+    len = prf_read_cgroup_file(ctx, PRF_CGROUP_FILE_CPU_MAX, buff, sizeof(buff));
+    cg.has_cpu_max = (len > 0);
+    if (cg.has_cpu_max) {
+        p   = buff;
+        end = buff + len;
+        if (strncmp(p, "max", 3) == 0) {
+            p += 3;
+        } else {
+            cg.cpu_quota_us = prf_parse_ulong(&p, end);
+        }
+        cg.cpu_period_us = prf_parse_ulong(&p, end);
+    }
+
+    // without a quota the cgroup may use all online CPUs
+    cg.cpu_limit = (cg.cpu_quota_us > 0 && cg.cpu_period_us > 0) ?
+                   (float)cg.cpu_quota_us / (float)cg.cpu_period_us :
+                   (float)((prf_get_cpu_online(ctx) > 0) ? prf_get_cpu_online(ctx) : sysconf(_SC_NPROCESSORS_ONLN));
+
+    len = prf_read_cgroup_file(ctx, PRF_CGROUP_FILE_CPU_STAT, buff, sizeof(buff));
+    clock_gettime(CLOCK_MONOTONIC, &stamp);
+    if (len <= 0) {
+        // the cgroup was removed
+        return false;
+    }
+    prf_find_key_value(buff, buff + len, "usage_usec", &cg.usage_us);
+    prf_find_key_value(buff, buff + len, "nr_periods", &cg.nr_periods);
+    prf_find_key_value(buff, buff + len, "nr_throttled", &cg.nr_throttled);
+    prf_find_key_value(buff, buff + len, "throttled_usec", &cg.throttled_us);
+
+    // "<bytes>", memory.max may be "max"
+    len = prf_read_cgroup_file(ctx, PRF_CGROUP_FILE_MEM_CURRENT, buff, sizeof(buff));
+    cg.has_memory = (len > 0);
+    if (cg.has_memory) {
+        p = buff;
+        cg.mem_current = prf_parse_ulong(&p, buff + len);
+
+        len = prf_read_cgroup_file(ctx, PRF_CGROUP_FILE_MEM_MAX, buff, sizeof(buff));
+        p   = buff;
+        cg.mem_max = (len > 0 && strncmp(buff, "max", 3) != 0) ? prf_parse_ulong(&p, buff + len) : 0;
+        if (cg.mem_max == 0) {
+            cg.mem_max = ctx->mem[PRF_MEM_TOTAL] * 1024;
+        }
+
+        len = prf_read_cgroup_file(ctx, PRF_CGROUP_FILE_MEM_EVENTS, buff, sizeof(buff));
+        if (len > 0) {
+            prf_find_key_value(buff, buff + len, "high", &cg.mem_high_events);
+            prf_find_key_value(buff, buff + len, "max", &cg.mem_max_events);
+            prf_find_key_value(buff, buff + len, "oom", &cg.mem_oom_events);
+            prf_find_key_value(buff, buff + len, "oom_kill", &cg.mem_oom_kill_events);
+        }
+
+        cg.mem_headroom = (cg.mem_max > cg.mem_current) ? cg.mem_max - cg.mem_current : 0;
+        cg.mem_pt       = (cg.mem_max > 0) ? 100.0 * (float)cg.mem_current / (float)cg.mem_max : 0.0;
+    }
+
+    seconds = prf_rate_seconds(&ctx->cgroup_stamp, &stamp);
+    if (seconds > 0.0 && cg.usage_us > last->usage_us) {
+        cg.cpu_usage = (float)((double)(cg.usage_us - last->usage_us) / (seconds * 1000000.0));
+        cg.cpu_pt    = (cg.cpu_limit > 0.0) ? 100.0 * cg.cpu_usage / cg.cpu_limit : 0.0;
+    }
+    if (seconds > 0.0 && cg.nr_periods > last->nr_periods && cg.nr_throttled >= last->nr_throttled) {
+        cg.throttled_pt = 100.0 * (float)(cg.nr_throttled - last->nr_throttled) / (float)(cg.nr_periods - last->nr_periods);
+    }
+
+    *last               = cg;
+    ctx->cgroup_stamp   = stamp;
+
+    return true;
+}
+
+void prf_print_cgroup_info(prf_ctx_t* ctx) {
+    const prf_cgroup_t*     cg = &ctx->cgroup;
+
+    if (!ctx->cgroup_found) {
+        return;
+    }
+
+    printf("READ: %s\nCPU: %6.2f of %6.2f CPUs, %6.2f%% | throttled: %6.2f%% of periods, %10lu us\n",
+            ctx->cgroup_path,
+            cg->cpu_usage, cg->cpu_limit, cg->cpu_pt, cg->throttled_pt, cg->throttled_us);
+
+    if (cg->has_memory) {
+        printf("Mem: %12lu of %12lu bytes, %6.2f%% | headroom: %12lu bytes | high: %lu, max: %lu, oom: %lu, oom_kill: %lu\n",
+                cg->mem_current, cg->mem_max, cg->mem_pt, cg->mem_headroom,
+                cg->mem_high_events, cg->mem_max_events, cg->mem_oom_events, cg->mem_oom_kill_events);
+    }
+
+    printf("%s\n", PRF_LIB_HEADER);
+}
+
+bool prf_get_cgroup_info(prf_ctx_t* ctx, prf_cgroup_t* cgroup) {
+    if (!ctx->cgroup_found) {
+        return false;
+    }
+
+    *cgroup = ctx->cgroup;
+
+    return true;
+}
+
+const char* prf_get_cgroup_path(prf_ctx_t* ctx) {
+    return ctx->cgroup_found ? ctx->cgroup_path : NULL;
+}
+
+bool prf_read_cpu_info(prf_ctx_t* ctx) {
+    bool    status  = false;
+    long    len;
+
+    if (ctx->cpu_buff == NULL) {
+        // the "cpu" line and one line per configured CPU, the rest of /proc/stat is not read
+        ctx->cpu_buff_size = PRF_CPU_BUFF_SIZE;
+        while (ctx->cpu_buff_size < (sysconf(_SC_NPROCESSORS_CONF) + 2) * PRF_CPU_LINE_SIZE) {
+            ctx->cpu_buff_size *= 2;
+        }
+    }
+
+    len = prf_read_proc_file_grow(ctx, PRF_FILE_CPU_INFO, &ctx->cpu_buff, &ctx->cpu_buff_size, prf_is_cpu_info_complete);
+
+    if (len >= 0 && prf_parse_cpu_info(ctx, ctx->cpu_buff, len)) {
+        if (ctx->cfg_cpu_index < 0) {
+            memcpy(ctx->cpu, ctx->cpu_total, sizeof(ctx->cpu));
+            memcpy(ctx->cpu_pt, ctx->cpu_total_pt, sizeof(ctx->cpu_pt));
+            status = true;
+        } else if (ctx->cfg_cpu_index < ctx->cpu_count && ctx->cpu_core_seen[ctx->cfg_cpu_index]) {
+            for (int i = 0; i < PRF_CPU_ARRAY_LEN; i++) {
+                ctx->cpu[i]    = ctx->cpu_core[i][ctx->cfg_cpu_index];
+                ctx->cpu_pt[i] = ctx->cpu_core_pt[i][ctx->cfg_cpu_index];
+            }
+            status = true;
+        } else {
+            if (!ctx->cpu_warned) {
+                ctx->cpu_warned = true;
+                fprintf(stderr, "** ERROR - unable to find the CPU '%s'\n", ctx->cfg_cpu_name);
+            }
+        }
+    }
+
+    return status;
+}
+
+/*
+ * computes the percentages of CPU time spent in each state since the last read
+ * <raw> holds the last read values in /proc/stat's order, it is updated with <cpu_new>
+ * <pt> is filled in top's order, both are accessed with <stride> to serve the per-core arrays too
+ */
+static void prf_calc_cpu_pt(unsigned long* raw, float* pt, int stride, const unsigned long cpu_new[PRF_CPU_ARRAY_LEN]) {
+    // top's order: us, sy, ni, id, wa, hi, si, st - /proc/stat's order: us, ni, sy, id, wa, hi, si, st
+    static const int    order[PRF_CPU_ARRAY_LEN] = {0, 2, 1, 3, 4, 5, 6, 7};
+    unsigned long       frme[PRF_CPU_ARRAY_LEN];
+    unsigned long       tot_frme    = 0;
+    float               scale       = 0.0;
+
+    for (int i = 0; i < PRF_CPU_ARRAY_LEN; i++) {
+        // counters may go backwards, f.e. idle on tickless kernels or after CPU hotplug
+        frme[i]   = (cpu_new[i] > raw[i * stride]) ? cpu_new[i] - raw[i * stride] : 0;
+        tot_frme += frme[i];
+        raw[i * stride] = cpu_new[i];
+    }
+
+    // no tick since the last read, f.e. a static fixture or reads within a jiffy: the percentages stay
+    if (tot_frme < 1) {
+        return;
+    }
+
+    scale = 100.0 / (float)tot_frme;
+
+    for (int i = 0; i < PRF_CPU_ARRAY_LEN; i++) {
+        pt[i * stride] = (float)frme[order[i]] * scale;
+    }
+}
+
+bool prf_parse_cpu_info(prf_ctx_t* ctx, const char* buffer, long size) {
+    const char*     p       = buffer;
+    const char*     end     = buffer + size;
+    int             count   = 0;
+    int             online  = 0;
+    unsigned long   id;
+    unsigned long   cpu_new[PRF_CPU_ARRAY_LEN];
+
+    if (buffer == NULL || size <= 0) {
+        return false;
+    }
+
+    // offline cores have no "cpuN" line, their last values stay but they are not seen in this pass
+    memset(ctx->cpu_core_seen, 0, ctx->cpu_count * sizeof(ctx->cpu_core_seen[0]));
+
+    // the "cpu" line and the "cpuN" lines come first, parsing stops at the first other line
+    while (end - p > 3 && memcmp(p, "cpu", 3) == 0) {
+        p += 3;
+
+        if (*p == ' ') {
+            id = PRF_CPU_MAX_CORES;
+        } else {
+            id = prf_parse_ulong(&p, end);
+        }
+
+        for (int i = 0; i < PRF_CPU_ARRAY_LEN; i++) {
+            cpu_new[i] = prf_parse_ulong_fast(&p, end);
+        }
+
+        if (id == PRF_CPU_MAX_CORES) {
+            prf_calc_cpu_pt(ctx->cpu_total, ctx->cpu_total_pt, 1, cpu_new);
+        } else if (id < PRF_CPU_MAX_CORES) {
+            prf_calc_cpu_pt(&ctx->cpu_core[0][id], &ctx->cpu_core_pt[0][id], PRF_CPU_MAX_CORES, cpu_new);
+            ctx->cpu_core_seen[id] = true;
+            online++;
+            if ((int)id >= count) {
+                count = (int)id + 1;
+            }
+        }
+
+        p = memchr(p, '\n', end - p);
+        if (p == NULL) {
+            break;
+        }
+        p++;
+    }
+
+    ctx->cpu_count  = count;
+    ctx->cpu_online = online;
+
+    return (p != buffer);
+}
+
+void prf_print_cpu_load(prf_ctx_t* ctx) {
+    printf("READ: %s\n%s: %ld, %ld, %ld, %ld, %ld, %ld, %ld, %ld\n%s\n",
+            PRF_CPU_INFO_FILE,
+            ctx->cfg_cpu_name,
+            ctx->cpu[0], ctx->cpu[1], ctx->cpu[2], ctx->cpu[3],
+            ctx->cpu[4], ctx->cpu[5], ctx->cpu[6], ctx->cpu[7],
+            PRF_LIB_HEADER);
+}
+
+// modelled after top's CPU line, example:
+// Cpu(s):  1.3%us, 28.0%sy,  0.0%ni, 70.3%id,  0.0%wa,  0.3%hi,  0.0%si,  0.0%st
+void prf_print_cpu_pt_load(prf_ctx_t* ctx) {
+    printf("READ: %s\nCpu: %6.1f%%us, %6.1f%%sy, %6.1f%%ni, %6.1f%%id, %6.1f%%wa, %6.1f%%hi, %6.1f%%si, %6.1f%%st\n%s\n",
+            PRF_CPU_INFO_FILE,
+            ctx->cpu_pt[0], ctx->cpu_pt[1], ctx->cpu_pt[2], ctx->cpu_pt[3],
+            ctx->cpu_pt[4], ctx->cpu_pt[5], ctx->cpu_pt[6], ctx->cpu_pt[7],
+            PRF_LIB_HEADER);
+}
+
+// per-core percentages, one line per core
+void prf_print_cpu_pt_all(prf_ctx_t* ctx) {
+    printf("READ: %s\n", PRF_CPU_INFO_FILE);
+
+    for (int i = 0; i < ctx->cpu_count; i++) {
+        if (!ctx->cpu_core_seen[i]) {
+            continue;
+        }
+        printf("cpu%-4d %6.1f%%us, %6.1f%%sy, %6.1f%%ni, %6.1f%%id, %6.1f%%wa, %6.1f%%hi, %6.1f%%si, %6.1f%%st\n",
+               i,
+               ctx->cpu_core_pt[0][i], ctx->cpu_core_pt[1][i], ctx->cpu_core_pt[2][i], ctx->cpu_core_pt[3][i],
+               ctx->cpu_core_pt[4][i], ctx->cpu_core_pt[5][i], ctx->cpu_core_pt[6][i], ctx->cpu_core_pt[7][i]);
+    }
+
+    printf("%s\n", PRF_LIB_HEADER);
+}
+
+void prf_get_cpu_raw_info(prf_ctx_t* ctx, unsigned long c[PRF_CPU_ARRAY_LEN]) {
+    memcpy(c, ctx->cpu, sizeof(ctx->cpu));
+}
+
+void prf_get_cpu_pt_info(prf_ctx_t* ctx, float p[PRF_CPU_ARRAY_LEN]) {
+    memcpy(p, ctx->cpu_pt, sizeof(ctx->cpu_pt));
+}
+
+void prf_get_cpu_pt_total(prf_ctx_t* ctx, float p[PRF_CPU_ARRAY_LEN]) {
+    memcpy(p, ctx->cpu_total_pt, sizeof(ctx->cpu_total_pt));
+}
+
+int prf_get_cpu_count(prf_ctx_t* ctx) {
+    return ctx->cpu_count;
+}
+
+int prf_get_cpu_online(prf_ctx_t* ctx) {
+    return ctx->cpu_online;
+}
+
+bool prf_is_cpu_online(prf_ctx_t* ctx, int core) {
+    return (core >= 0 && core < ctx->cpu_count && ctx->cpu_core_seen[core]);
+}
+
+int prf_get_cpu_raw_all(prf_ctx_t* ctx, unsigned long* c[PRF_CPU_ARRAY_LEN], int len) {
+    int     count       = (len < ctx->cpu_count) ? len : ctx->cpu_count;
+    bool    has_offline = (ctx->cpu_online < ctx->cpu_count);
+
+    for (int i = 0; i < PRF_CPU_ARRAY_LEN; i++) {
+        if (c[i] != NULL && count > 0) {
+            memcpy(c[i], ctx->cpu_core[i], count * sizeof(ctx->cpu_core[i][0]));
+            for (int j = 0; has_offline && j < count; j++) {
+                if (!ctx->cpu_core_seen[j]) {
+                    c[i][j] = 0;
+                }
+            }
+        }
+    }
+
+    return count;
+}
+
+int prf_get_cpu_pt_all(prf_ctx_t* ctx, float* p[PRF_CPU_ARRAY_LEN], int len) {
+    int     count       = (len < ctx->cpu_count) ? len : ctx->cpu_count;
+    bool    has_offline = (ctx->cpu_online < ctx->cpu_count);
+
+    for (int i = 0; i < PRF_CPU_ARRAY_LEN; i++) {
+        if (p[i] != NULL && count > 0) {
+            memcpy(p[i], ctx->cpu_core_pt[i], count * sizeof(ctx->cpu_core_pt[i][0]));
+            for (int j = 0; has_offline && j < count; j++) {
+                if (!ctx->cpu_core_seen[j]) {
+                    p[i][j] = 0.0;
+                }
+            }
+        }
+    }
+
+    return count;
+}
+
+int prf_get_cpu_busiest(prf_ctx_t* ctx, float* load) {
+    int     core = -1;
+    float   idle = 101.0;
+
+    // a single scan over the contiguous idle array, an offline core keeps the percentages of its last pass
+    for (int i = 0; i < ctx->cpu_count; i++) {
+        if (ctx->cpu_core_pt[3][i] < idle && ctx->cpu_core_seen[i]) {
+            idle = ctx->cpu_core_pt[3][i];
+            core = i;
+        }
+    }
+
+    if (load != NULL) {
+        *load = (core < 0) ? 0.0 : 100.0 - idle;
+    }
+
+    return core;
+}
+
+int prf_get_cpu_index(const char* cpu_name) {
+    char*   tail;
+    long    index;
+
+    if (cpu_name == NULL || strcmp(cpu_name, "cpu") == 0) {
+        return -1;
+    }
+
+    // "cpuN", exact match: "cpu1" is not "cpu10"
+    if (strncmp(cpu_name, "cpu", 3) == 0 && cpu_name[3] != '\0') {
+        index = strtol(cpu_name + 3, &tail, 10);
+        if (*tail == '\0' && index >= 0 && index < PRF_CPU_MAX_CORES) {
+            return (int)index;
+        }
+    }
+
+    fprintf(stderr, "** ERROR - invalid CPU name '%s', using 'cpu'\n", cpu_name);
+
+    return -1;
+}
+
+float prf_get_cpu_idle(prf_ctx_t* ctx) {
+   return ctx->cpu_pt[3];
+}
+
+float prf_get_cpu_load(prf_ctx_t* ctx) {
+   return (100.0 - ctx->cpu_pt[3]);
+}
+
+/*
+ * reads /proc/meminfo
+ */
+static bool prf_read_mem_info_proc(prf_ctx_t* ctx) {
+    long    size = PRF_MEM_BUFF_SIZE;
+    char    buff[size];
+    long    len  = prf_read_proc_file(ctx, PRF_FILE_MEM_INFO, buff, size);
+
+    return (len >= 0) && prf_parse_mem_info(ctx, buff, len);
+}
+
+/*
+ * reads the basic memory fields with a single sysinfo() call, the others from /proc/meminfo once per PRF_SYSINFO_REFRESH_S
+ * in between MemAvailable moves with MemFree: allocations and frees show in both, reclaim of the page cache is
+ * caught up by the next /proc/meminfo read
+ */
+static bool prf_read_mem_sysinfo(prf_ctx_t* ctx) {
+    struct sysinfo  info;
+    struct timespec now;
+    unsigned long   kb_free;
+    long            available;
+
+    if (sysinfo(&info) < 0) {
+        return false;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    // sizes in <mem_unit> bytes
+    kb_free = (unsigned long)((unsigned long long)info.freeram * info.mem_unit / 1024);
+
+    if (prf_is_sysinfo_refresh(&ctx->sys_mem_stamp, &now) && prf_read_mem_info_proc(ctx)) {
+        ctx->sys_mem_stamp      = now;
+        ctx->sys_mem_free       = kb_free;
+        ctx->sys_mem_available  = ctx->mem[PRF_MEM_AVAILABLE];
+    }
+
+    ctx->mem[PRF_MEM_TOTAL]         = (unsigned long)((unsigned long long)info.totalram  * info.mem_unit / 1024);
+    ctx->mem[PRF_MEM_FREE]          = kb_free;
+    ctx->mem[PRF_MEM_BUFFERS]       = (unsigned long)((unsigned long long)info.bufferram * info.mem_unit / 1024);
+    ctx->mem[PRF_MEM_SHMEM]         = (unsigned long)((unsigned long long)info.sharedram * info.mem_unit / 1024);
+    ctx->mem[PRF_MEM_SWAP_TOTAL]    = (unsigned long)((unsigned long long)info.totalswap * info.mem_unit / 1024);
+    ctx->mem[PRF_MEM_SWAP_FREE]     = (unsigned long)((unsigned long long)info.freeswap  * info.mem_unit / 1024);
+
+    if (ctx->mem_found[PRF_MEM_AVAILABLE]) {
+        available = (long)ctx->sys_mem_available + ((long)kb_free - (long)ctx->sys_mem_free);
+        ctx->mem[PRF_MEM_AVAILABLE] = (available < 0) ? 0 :
+                                      ((unsigned long)available > ctx->mem[PRF_MEM_TOTAL]) ? ctx->mem[PRF_MEM_TOTAL] :
+                                      (unsigned long)available;
+    }
+
+    // derived
+    ctx->kb_swap_used = ctx->mem[PRF_MEM_SWAP_TOTAL] - ctx->mem[PRF_MEM_SWAP_FREE];
+    ctx->kb_main_used = ctx->mem[PRF_MEM_TOTAL] - ctx->mem[PRF_MEM_FREE];
+
+    ctx->file_stamps[PRF_FILE_MEM_INFO] = now;
+
+    return true;
+}
+
+bool prf_read_mem_info(prf_ctx_t* ctx) {
+    return (ctx->cfg_sys_backend == PRF_SYS_BACKEND_SYSINFO) ? prf_read_mem_sysinfo(ctx) : prf_read_mem_info_proc(ctx);
+}
+
+bool prf_parse_mem_info(prf_ctx_t* ctx, const char* buffer, long size) {
+    const char*     p       = buffer;
+    const char*     end     = buffer + size;
+    const char*     key;
+    const char*     colon;
+    long            len;
+    unsigned        field;
+
+    if (buffer == NULL || size <= 0) {
+        return false;
+    }
+
+    // "<key>:<spaces><value>[ kB]\n"
+    while (p < end) {
+        key   = p;
+        colon = memchr(p, ':', end - p);
+        if (colon == NULL) {
+            break;
+        }
+
+        len   = colon - key;
+        p     = colon + 1;
+        field = (len >= 2) ? prf_mem_hash[PRF_MEM_HASH(key, len)] : 0;
+
+        if (len >= 2 && strncmp(prf_mem_names[field], key, len) == 0 && prf_mem_names[field][len] == '\0') {
+            ctx->mem[field]       = prf_parse_ulong(&p, end);
+            ctx->mem_found[field] = true;
+        }
+
+        p = memchr(p, '\n', end - p);
+        if (p == NULL) {
+            break;
+        }
+        p++;
+    }
+
+    // derived
+    ctx->kb_swap_used = ctx->mem[PRF_MEM_SWAP_TOTAL] - ctx->mem[PRF_MEM_SWAP_FREE];
+    ctx->kb_main_used = ctx->mem[PRF_MEM_TOTAL] - ctx->mem[PRF_MEM_FREE];
+
+    return true;
+}
+
+// modelled after top's memory lines, example:
+// Mem:    767684k total,   748792k used,    18892k free,   108260k buffers
+// Swap:   831480k total,        0k used,   831480k free,   294848k cached
+void prf_print_mem_info(prf_ctx_t* ctx) {
+    printf("READ: %s\n\
+Mem: %9ldk total, %8ldk used, %8ldk free, %8ldk buffers\n\
+Swap: %8ldk total, %8ldk used, %8ldk free, %8ldk cached\n%s\n",
+        (ctx->cfg_sys_backend == PRF_SYS_BACKEND_SYSINFO) ? PRF_SYSINFO_CALL : PRF_MEM_INFO_FILE,
+        ctx->mem[PRF_MEM_TOTAL], ctx->kb_main_used, ctx->mem[PRF_MEM_FREE], ctx->mem[PRF_MEM_BUFFERS],
+        ctx->mem[PRF_MEM_SWAP_TOTAL], ctx->kb_swap_used, ctx->mem[PRF_MEM_SWAP_FREE], ctx->mem[PRF_MEM_CACHED],
+        PRF_LIB_HEADER);
+}
+
+void prf_print_mem_info_full(prf_ctx_t* ctx) {
+    char    name[32];
+
+    printf("READ: %s\n", PRF_MEM_INFO_FILE);
+
+    for (int i = 0; i < PRF_MEM_FIELD_COUNT; i++) {
+        if (ctx->mem_found[i]) {
+            snprintf(name, sizeof(name), "%s:", prf_mem_names[i]);
+
+            switch (i) {
+                case PRF_MEM_HUGE_PAGES_TOTAL:
+                case PRF_MEM_HUGE_PAGES_FREE:
+                case PRF_MEM_HUGE_PAGES_RSVD:
+                case PRF_MEM_HUGE_PAGES_SURP:
+                    printf(PRF_MEM_INFO_LINE_CNT, name, ctx->mem[i]);
+                    break;
+
+                default:
+                    printf(PRF_MEM_INFO_LINE, name, ctx->mem[i]);
+                    break;
+            }
+        }
+    }
+
+    printf("%s\n", PRF_LIB_HEADER);
+}
+
+void prf_get_current_mem_info(prf_ctx_t* ctx, unsigned long m[8]) {
+    m[0] = ctx->mem[PRF_MEM_TOTAL];
+    m[1] = ctx->kb_main_used;
+    m[2] = ctx->mem[PRF_MEM_FREE];
+    m[3] = ctx->mem[PRF_MEM_BUFFERS];
+    m[4] = ctx->mem[PRF_MEM_SWAP_TOTAL];
+    m[5] = ctx->kb_swap_used;
+    m[6] = ctx->mem[PRF_MEM_SWAP_FREE];
+    m[7] = ctx->mem[PRF_MEM_CACHED];
+}
+
+void prf_get_mem_info_full(prf_ctx_t* ctx, unsigned long m[PRF_MEM_FIELD_COUNT]) {
+    memcpy(m, ctx->mem, sizeof(ctx->mem));
+}
+
+const char* prf_get_mem_field_name(prf_mem_field_t field) {
+    return (field >= 0 && field < PRF_MEM_FIELD_COUNT) ? prf_mem_names[field] : NULL;
+}
+
+bool prf_read_vmstat_info(prf_ctx_t* ctx) {
+    long    len;
+
+    if (ctx->vm_buff == NULL) {
+        ctx->vm_buff_size = PRF_VMSTAT_BUFF_SIZE;
+    }
+
+    len = prf_read_proc_file_grow(ctx, PRF_FILE_VMSTAT, &ctx->vm_buff, &ctx->vm_buff_size, NULL);
+
+    return (len >= 0 && prf_parse_vmstat_info(ctx, ctx->vm_buff, len, &ctx->file_stamps[PRF_FILE_VMSTAT]));
+}
+
+/*
+ * returns the field of the /proc/vmstat key <name> of <len> bytes, a total or a per-zone counter, -1 for none
+ */
+static int prf_find_vm_field(const char* name, long len) {
+    long    field_len;
+    long    zone_len;
+
+    // all keys of interest start with "p" or "a"
+    if (name[0] != 'p' && name[0] != 'a') {
+        return -1;
+    }
+
+    for (int i = 0; i < PRF_VM_FIELD_COUNT; i++) {
+        field_len = strlen(prf_vm_names[i]);
+        if (len < field_len || memcmp(name, prf_vm_names[i], field_len) != 0) {
+            continue;
+        }
+
+        if (len == field_len) {
+            return i;
+        }
+
+        // "pgscan_direct_throttle" is not a zone
+        for (size_t z = 0; name[field_len] == '_' && z < sizeof(prf_vm_zones) / sizeof(prf_vm_zones[0]); z++) {
+            zone_len = strlen(prf_vm_zones[z]);
+            if (len == field_len + 1 + zone_len && memcmp(name + field_len + 1, prf_vm_zones[z], zone_len) == 0) {
+                return i;
+            }
+        }
+    }
+
+    return -1;
+}
+
+bool prf_parse_vmstat_info(prf_ctx_t* ctx, const char* buffer, long size, const struct timespec* stamp) {
+    const char*         p       = buffer;
+    const char*         end     = buffer + size;
+    const char*         sep;
+    prf_vmstat_t        vm;
+    struct timespec     now;
+    double              seconds;
+    int                 field;
+
+    if (buffer == NULL || size <= 0) {
+        return false;
+    }
+
+    if (stamp == NULL) {
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        stamp = &now;
+    }
+
+    memset(&vm, 0, sizeof(vm));
+
+    // "<key> <value>\n"
+    while (p < end) {
+        sep = memchr(p, ' ', end - p);
+        if (sep == NULL) {
+            break;
+        }
+
+        field = prf_find_vm_field(p, sep - p);
+        p     = sep + 1;
+        if (field >= 0) {
+            vm.value[field] += prf_parse_ulong(&p, end);
+        }
+
+        p = memchr(p, '\n', end - p);
+        p = (p != NULL) ? p + 1 : end;
+    }
+
+    seconds = prf_rate_seconds(&ctx->vm_stamp, stamp);
+    for (int i = 0; i < PRF_VM_FIELD_COUNT && seconds > 0.0; i++) {
+        vm.rate[i] = prf_calc_rate(vm.value[i], ctx->vmstat.value[i], seconds);
+    }
+
+    ctx->vmstat     = vm;
+    ctx->vm_stamp   = *stamp;
+
+    return true;
+}
+
+void prf_print_vmstat_info(prf_ctx_t* ctx) {
+    printf("READ: %s\n%-16s %16s %12s\n", PRF_VMSTAT_FILE, "Counter", "value", "rate/s");
+
+    for (int i = 0; i < PRF_VM_FIELD_COUNT; i++) {
+        printf("%-16s %16lu %12.2f\n", prf_vm_names[i], ctx->vmstat.value[i], ctx->vmstat.rate[i]);
+    }
+
+    printf("%s\n", PRF_LIB_HEADER);
+}
+
+void prf_get_vmstat_info(prf_ctx_t* ctx, prf_vmstat_t* vmstat) {
+    *vmstat = ctx->vmstat;
+}
+
+const char* prf_get_vm_field_name(prf_vm_field_t field) {
+    return (field >= 0 && field < PRF_VM_FIELD_COUNT) ? prf_vm_names[field] : NULL;
+}
+
+bool prf_read_irq_info(prf_ctx_t* ctx) {
+    long    len;
+    bool    status;
+
+    if (ctx->softirq_buff == NULL) {
+        ctx->softirq_buff_size = PRF_IRQ_BUFF_SIZE;
+    }
+    if (ctx->irq_buff == NULL) {
+        ctx->irq_buff_size = PRF_IRQ_BUFF_SIZE;
+    }
+
+    len     = prf_read_proc_file_grow(ctx, PRF_FILE_SOFTIRQ, &ctx->softirq_buff, &ctx->softirq_buff_size, NULL);
+    status  = (len >= 0 && prf_parse_softirq_info(ctx, ctx->softirq_buff, len, &ctx->file_stamps[PRF_FILE_SOFTIRQ]));
+
+    len     = prf_read_proc_file_grow(ctx, PRF_FILE_IRQ, &ctx->irq_buff, &ctx->irq_buff_size, NULL);
+    status  = (len >= 0 && prf_parse_irq_info(ctx, ctx->irq_buff, len, &ctx->file_stamps[PRF_FILE_IRQ])) && status;
+
+    return status;
+}
+
+/*
+ * parses the header line "CPU0 CPU1 ..." of a per-CPU column table at <*p> into the CPU numbers <cpus>
+ * and advances <*p> to the next line
+ * returns the number of columns, at most PRF_IRQ_MAX_CPU
+ */
+static int prf_parse_irq_header(const char** p, const char* end, int cpus[PRF_IRQ_MAX_CPU]) {
+    const char*     s       = *p;
+    int             cols    = 0;
+
+    while (s < end && *s != '\n') {
+        if (*s == 'C' && end - s > 3 && s[1] == 'P' && s[2] == 'U') {
+            s += 3;
+            if (cols < PRF_IRQ_MAX_CPU) {
+                cpus[cols++] = (int)prf_parse_ulong(&s, end);
+            }
+        } else {
+            s++;
+        }
+    }
+
+    *p = (s < end) ? s + 1 : end;
+
+    return cols;
+}
+
+/*
+ * parses up to <cols> counters of a row at <*p>, past its label, into <counts>, stops at the first non-number
+ * returns the number of counters parsed
+ */
+static inline int prf_parse_irq_row(const char** p, const char* end, unsigned long* counts, int cols) {
+    const char*     s   = *p;
+    int             n   = 0;
+
+    for (; n < cols; n++) {
+        while (s < end && *s == ' ') {
+            s++;
+        }
+        if (s >= end || (unsigned)(*s - '0') >= 10) {
+            break;
+        }
+        counts[n] = prf_parse_ulong(&s, end);
+    }
+
+    *p = s;
+
+    return n;
+}
+
+/*
+ * computes the per-CPU <rates> of <cols> counters <counts> from the <last> counters over <seconds>, then <last> is updated,
+ * and fills their distribution into <dist>
+ */
+static void prf_calc_irq_dist(const unsigned long* counts, unsigned long* last, float* rates, const int* cpus, int cols,
+                              float seconds, prf_irq_dist_t* dist) {
+    memset(dist, 0, sizeof(*dist));
+
+    for (int i = 0; i < cols; i++) {
+        rates[i]          = (seconds > 0.0) ? prf_calc_rate(counts[i], last[i], seconds) : 0.0;
+        last[i]           = counts[i];
+        dist->total_rate += rates[i];
+        if (rates[i] > dist->max_rate) {
+            dist->max_rate = rates[i];
+            dist->max_cpu  = cpus[i];
+        }
+    }
+
+    dist->imbalance = (dist->total_rate > 0.0) ? dist->max_rate * (float)cols / dist->total_rate : 0.0;
+}
+
+bool prf_parse_softirq_info(prf_ctx_t* ctx, const char* buffer, long size, const struct timespec* stamp) {
+    const char*         p       = buffer;
+    const char*         end     = buffer + size;
+    const char*         label;
+    unsigned long       counts[PRF_SOFTIRQ_COUNT][PRF_IRQ_MAX_CPU];
+    struct timespec     now;
+    double              seconds;
+    int                 cols;
+    int                 vector;
+
+    if (buffer == NULL || size <= 0) {
+        return false;
+    }
+
+    if (stamp == NULL) {
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        stamp = &now;
+    }
+
+    cols = prf_parse_irq_header(&p, end, ctx->softirq_cpus);
+    if (cols == 0) {
+        return false;
+    }
+
+    // "      NET_RX:     123     456 ...", a column count change, f.e. after CPU hotplug, restarts the rates
+    seconds = (ctx->softirq_cols == cols) ? prf_elapsed_seconds(&ctx->softirq_stamp, stamp) : 0.0;
+    memset(counts, 0, sizeof(counts));
+
+    while (p < end) {
+        while (p < end && *p == ' ') {
+            p++;
+        }
+        label = p;
+        p     = memchr(p, ':', end - p);
+        if (p == NULL) {
+            break;
+        }
+
+        vector = -1;
+        for (int i = 0; i < PRF_SOFTIRQ_COUNT && vector < 0; i++) {
+            if ((long)strlen(prf_softirq_names[i]) == p - label && memcmp(label, prf_softirq_names[i], p - label) == 0) {
+                vector = i;
+            }
+        }
+
+        p++;
+        if (vector >= 0) {
+            prf_parse_irq_row(&p, end, counts[vector], cols);
+        }
+
+        p = memchr(p, '\n', end - p);
+        p = (p != NULL) ? p + 1 : end;
+    }
+
+    for (int i = 0; i < PRF_SOFTIRQ_COUNT; i++) {
+        prf_calc_irq_dist(counts[i], ctx->softirq[i], ctx->softirq_rate[i], ctx->softirq_cpus, cols, seconds,
+                          &ctx->softirq_dist[i]);
+    }
+
+    ctx->softirq_cols   = cols;
+    ctx->softirq_stamp  = *stamp;
+
+    return true;
+}
+
+bool prf_parse_irq_info(prf_ctx_t* ctx, const char* buffer, long size, const struct timespec* stamp) {
+    const char*         p       = buffer;
+    const char*         end     = buffer + size;
+    unsigned long       counts[PRF_IRQ_MAX_CPU];
+    unsigned long       row[PRF_IRQ_MAX_CPU];
+    struct timespec     now;
+    double              seconds;
+    int                 cols;
+    int                 n;
+
+    if (buffer == NULL || size <= 0) {
+        return false;
+    }
+
+    if (stamp == NULL) {
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        stamp = &now;
+    }
+
+    cols = prf_parse_irq_header(&p, end, ctx->irq_cpus);
+    if (cols == 0) {
+        return false;
+    }
+
+    seconds = (ctx->irq_cols == cols) ? prf_elapsed_seconds(&ctx->irq_stamp, stamp) : 0.0;
+    memset(counts, 0, sizeof(counts));
+
+    // " 24:     123     456   IO-APIC   5-edge   eth0", the named lines like "LOC:" are per-CPU by nature
+    while (p < end) {
+        while (p < end && *p == ' ') {
+            p++;
+        }
+
+        if (p < end && (unsigned)(*p - '0') < 10) {
+            p = memchr(p, ':', end - p);
+            if (p == NULL) {
+                break;
+            }
+            p++;
+
+            n = prf_parse_irq_row(&p, end, row, cols);
+            for (int i = 0; i < n; i++) {
+                counts[i] += row[i];
+            }
+        }
+
+        p = memchr(p, '\n', end - p);
+        p = (p != NULL) ? p + 1 : end;
+    }
+
+    prf_calc_irq_dist(counts, ctx->irq, ctx->irq_rate, ctx->irq_cpus, cols, seconds, &ctx->irq_dist);
+
+    ctx->irq_cols   = cols;
+    ctx->irq_stamp  = *stamp;
+
+    return true;
+}
+
+void prf_print_irq_info(prf_ctx_t* ctx) {
+    const prf_irq_dist_t*   dist;
+
+    printf("READ: %s, %s\n%-10s %12s %12s %6s %9s\n",
+            PRF_SOFTIRQ_FILE, PRF_IRQ_FILE, "Vector", "total/s", "max/s", "on CPU", "imbalance");
+
+    for (int i = 0; i <= PRF_SOFTIRQ_COUNT; i++) {
+        dist = (i < PRF_SOFTIRQ_COUNT) ? &ctx->softirq_dist[i] : &ctx->irq_dist;
+        printf("%-10s %12.1f %12.1f %6d %9.2f\n",
+                (i < PRF_SOFTIRQ_COUNT) ? prf_softirq_names[i] : "IRQ",
+                dist->total_rate, dist->max_rate, dist->max_cpu, dist->imbalance);
+    }
+
+    printf("%s\n", PRF_LIB_HEADER);
+}
+
+void prf_get_softirq_dist(prf_ctx_t* ctx, prf_softirq_t vector, prf_irq_dist_t* dist) {
+    if (vector >= 0 && vector < PRF_SOFTIRQ_COUNT) {
+        *dist = ctx->softirq_dist[vector];
+    } else {
+        memset(dist, 0, sizeof(*dist));
+    }
+}
+
+void prf_get_irq_dist(prf_ctx_t* ctx, prf_irq_dist_t* dist) {
+    *dist = ctx->irq_dist;
+}
+
+int prf_get_softirq_rates(prf_ctx_t* ctx, prf_softirq_t vector, float* rates, int* cpus, int len) {
+    int     count = (len < ctx->softirq_cols) ? len : ctx->softirq_cols;
+
+    if (vector < 0 || vector >= PRF_SOFTIRQ_COUNT || count < 0) {
+        return 0;
+    }
+
+    memcpy(rates, ctx->softirq_rate[vector], count * sizeof(float));
+    if (cpus != NULL) {
+        memcpy(cpus, ctx->softirq_cpus, count * sizeof(int));
+    }
+
+    return count;
+}
+
+int prf_get_irq_rates(prf_ctx_t* ctx, float* rates, int* cpus, int len) {
+    int     count = (len < ctx->irq_cols) ? len : ctx->irq_cols;
+
+    if (count < 0) {
+        return 0;
+    }
+
+    memcpy(rates, ctx->irq_rate, count * sizeof(float));
+    if (cpus != NULL) {
+        memcpy(cpus, ctx->irq_cpus, count * sizeof(int));
+    }
+
+    return count;
+}
+
+const char* prf_get_softirq_name(prf_softirq_t vector) {
+    return (vector >= 0 && vector < PRF_SOFTIRQ_COUNT) ? prf_softirq_names[vector] : NULL;
+}
+
+/*
+ * matches <name> against the include and exclude glob patterns
+ */
+static bool prf_is_filter_match(const prf_filter_t* filter, const char* name) {
+    bool    included = (filter->include_count == 0);
+
+    for (int i = 0; i < filter->include_count && !included; i++) {
+        included = (fnmatch(filter->include[i], name, 0) == 0);
+    }
+
+    for (int i = 0; i < filter->exclude_count && included; i++) {
+        included = (fnmatch(filter->exclude[i], name, 0) != 0);
+    }
+
+    return included;
+}
+
+/*
+ * starts a new per-interface table read at <stamp>
+ * returns the seconds elapsed since the previous table, 0 for the first one
+ */
+static float prf_begin_net_table(prf_ctx_t* ctx, const struct timespec* stamp) {
+    prf_net_itf_t*  total   = &ctx->net_total;
+
+    memset(total, 0, sizeof(*total));
+    strcpy(total->name, "total");
+    ctx->net_itf_index = -1;
+
+    return prf_rate_seconds(&ctx->net_stamp, stamp);
+}
+
+/*
+ * completes interface <count> of the new table, its name and counters filled by the parser:
+ * the rates against the previous table, the filter, <interface_name> and the totals
+ */
+static void prf_add_net_itf(prf_ctx_t* ctx, int count, float seconds) {
+    int             last        = ctx->net_cur;
+    int             cur         = 1 - last;
+    int             last_count  = ctx->net_itf_count[last];
+    prf_net_itf_t*  itf         = &ctx->net_itfs[cur][count];
+    prf_net_itf_t*  prev        = NULL;
+    prf_net_itf_t*  total       = &ctx->net_total;
+
+    // previous read: the same position, unless interfaces came or went
+    if (count < last_count && strcmp(ctx->net_itfs[last][count].name, itf->name) == 0) {
+        prev = &ctx->net_itfs[last][count];
+    } else {
+        for (int i = 0; i < last_count; i++) {
+            if (strcmp(ctx->net_itfs[last][i].name, itf->name) == 0) {
+                prev = &ctx->net_itfs[last][i];
+                break;
+            }
+        }
+    }
+
+    if (prev != NULL) {
+        // filter results are kept with the interface, globs are matched once per interface
+        ctx->net_itf_included[cur][count] = ctx->net_itf_included[last][prev - ctx->net_itfs[last]];
+        itf->rx_bytes_rate      = prf_calc_rate(itf->rx[0], prev->rx[0], seconds);
+        itf->tx_bytes_rate      = prf_calc_rate(itf->tx[0], prev->tx[0], seconds);
+        itf->rx_packets_rate    = prf_calc_rate(itf->rx[1], prev->rx[1], seconds);
+        itf->tx_packets_rate    = prf_calc_rate(itf->tx[1], prev->tx[1], seconds);
+        itf->rx_errs_rate       = prf_calc_rate(itf->rx[2], prev->rx[2], seconds);
+        itf->tx_errs_rate       = prf_calc_rate(itf->tx[2], prev->tx[2], seconds);
+        itf->rx_drops_rate      = prf_calc_rate(itf->rx[3], prev->rx[3], seconds);
+        itf->tx_drops_rate      = prf_calc_rate(itf->tx[3], prev->tx[3], seconds);
+    } else {
+        ctx->net_itf_included[cur][count] = prf_is_filter_match(&ctx->cfg_net_filter, itf->name);
+        itf->rx_bytes_rate      = itf->tx_bytes_rate    = 0.0;
+        itf->rx_packets_rate    = itf->tx_packets_rate  = 0.0;
+        itf->rx_errs_rate       = itf->tx_errs_rate     = 0.0;
+        itf->rx_drops_rate      = itf->tx_drops_rate    = 0.0;
+    }
+
+    if (ctx->cfg_interface_name != NULL && strcmp(itf->name, ctx->cfg_interface_name) == 0) {
+        ctx->net_itf_index = count;
+    }
+
+    if (ctx->net_itf_included[cur][count]) {
+        for (int i = 0; i < PRF_NET_ARRAY_LEN; i++) {
+            total->rx[i] += itf->rx[i];
+            total->tx[i] += itf->tx[i];
+        }
+        total->rx_bytes_rate    += itf->rx_bytes_rate;
+        total->tx_bytes_rate    += itf->tx_bytes_rate;
+        total->rx_packets_rate  += itf->rx_packets_rate;
+        total->tx_packets_rate  += itf->tx_packets_rate;
+        total->rx_errs_rate     += itf->rx_errs_rate;
+        total->tx_errs_rate     += itf->tx_errs_rate;
+        total->rx_drops_rate    += itf->rx_drops_rate;
+        total->tx_drops_rate    += itf->tx_drops_rate;
+    }
+}
+
+/*
+ * makes the new table of <count> interfaces read at <stamp> the current one
+ */
+static void prf_end_net_table(prf_ctx_t* ctx, int count, const struct timespec* stamp) {
+    int     cur = 1 - ctx->net_cur;
+
+    ctx->net_itf_count[cur]  = count;
+    ctx->net_cur             = cur;
+    ctx->net_stamp           = *stamp;
+}
+
+bool prf_parse_net_info(prf_ctx_t* ctx, const char* buffer, long size, const struct timespec* stamp) {
+    const char*     p           = buffer;
+    const char*     end         = buffer + size;
+    const char*     name;
+    const char*     colon;
+    const char*     eol;
+    int             cur         = 1 - ctx->net_cur;
+    int             count       = 0;
+    long            len;
+    prf_net_itf_t*  itf;
+    struct timespec now;
+    float           seconds;
+
+    if (buffer == NULL || size <= 0) {
+        return false;
+    }
+
+    if (stamp == NULL) {
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        stamp = &now;
+    }
+
+    seconds = prf_begin_net_table(ctx, stamp);
+
+    // skip the two header lines
+    for (int i = 0; i < 2 && p != NULL; i++) {
+        p = memchr(p, '\n', end - p);
+        p = (p != NULL) ? p + 1 : NULL;
+    }
+
+    // "<spaces><name>: <16 counters>\n"
+    while (p != NULL && p < end && count < PRF_NET_MAX_ITF) {
+        eol = memchr(p, '\n', end - p);
+        eol = (eol != NULL) ? eol : end;
+
+        while (p < eol && *p == ' ') {
+            p++;
+        }
+
+        name  = p;
+        colon = memchr(p, ':', eol - p);
+        if (colon == NULL) {
+            break;
+        }
+
+        len = colon - name;
+        if (len >= PRF_NET_NAME_LEN) {
+            len = PRF_NET_NAME_LEN - 1;
+        }
+
+        itf = &ctx->net_itfs[cur][count];
+        memcpy(itf->name, name, len);
+        itf->name[len] = '\0';
+
+        p = colon + 1;
+        for (int i = 0; i < PRF_NET_ARRAY_LEN; i++) {
+            itf->rx[i] = prf_parse_ulong_fast(&p, eol);
+        }
+        for (int i = 0; i < PRF_NET_ARRAY_LEN; i++) {
+            itf->tx[i] = prf_parse_ulong_fast(&p, eol);
+        }
+
+        prf_add_net_itf(ctx, count, seconds);
+
+        count++;
+        p = eol + 1;
+    }
+
+    prf_end_net_table(ctx, count, stamp);
+
+    return true;
+}
+
+/*
+ * appends an RTM_GETLINK request with sequence number <seq> to <req> at <len>, for the interface <name>,
+ * a dump of all interfaces for NULL
+ * returns the new length of <req>
+ */
+static long prf_add_net_link_req(char* req, long len, unsigned int seq, const char* name) {
+    struct nlmsghdr*    nh      = (struct nlmsghdr*)(req + len);
+    struct ifinfomsg*   ifi;
+    struct rtattr*      rta;
+    size_t              name_len;
+
+    memset(nh, 0, PRF_NL_REQ_SIZE);
+    nh->nlmsg_len       = NLMSG_LENGTH(sizeof(struct ifinfomsg));
+    nh->nlmsg_type      = RTM_GETLINK;
+    nh->nlmsg_flags     = NLM_F_REQUEST | ((name == NULL) ? NLM_F_DUMP : 0);
+    nh->nlmsg_seq       = seq;
+
+    ifi                 = NLMSG_DATA(nh);
+    ifi->ifi_family     = AF_UNSPEC;
+
+    if (name != NULL) {
+        name_len        = strnlen(name, PRF_NET_NAME_LEN - 1);
+        rta             = (struct rtattr*)((char*)nh + NLMSG_ALIGN(nh->nlmsg_len));
+        rta->rta_type   = IFLA_IFNAME;
+        rta->rta_len    = RTA_LENGTH(name_len + 1);
+        memcpy(RTA_DATA(rta), name, name_len);
+        nh->nlmsg_len   = NLMSG_ALIGN(nh->nlmsg_len) + RTA_ALIGN(rta->rta_len);
+    }
+
+    return len + NLMSG_ALIGN(nh->nlmsg_len);
+}
+
+/*
+ * appends an RTM_GETSTATS dump request of the IFLA_STATS_LINK_64 counters with sequence number <seq> to <req> at <len>
+ * returns the new length of <req>
+ */
+static long prf_add_net_stats_req(char* req, long len, unsigned int seq) {
+    struct nlmsghdr*        nh      = (struct nlmsghdr*)(req + len);
+    struct if_stats_msg*    ism;
+
+    memset(nh, 0, PRF_NL_REQ_SIZE);
+    nh->nlmsg_len       = NLMSG_LENGTH(sizeof(struct if_stats_msg));
+    nh->nlmsg_type      = RTM_GETSTATS;
+    nh->nlmsg_flags     = NLM_F_REQUEST | NLM_F_DUMP;
+    nh->nlmsg_seq       = seq;
+
+    ism                 = NLMSG_DATA(nh);
+    ism->family         = AF_UNSPEC;
+    ism->filter_mask    = IFLA_STATS_FILTER_BIT(IFLA_STATS_LINK_64);
+
+    return len + NLMSG_ALIGN(nh->nlmsg_len);
+}
+
+/*
+ * opens the persistent rtnetlink socket, subscribed to the link notifications that invalidate the names of the indexes
+ */
+static bool prf_open_net_link(prf_ctx_t* ctx) {
+    struct sockaddr_nl  addr    = { .nl_family = AF_NETLINK, .nl_groups = RTMGRP_LINK };
+
+    ctx->nl_fd = socket(AF_NETLINK, SOCK_RAW | SOCK_CLOEXEC, NETLINK_ROUTE);
+    if (ctx->nl_fd < 0) {
+        return false;
+    }
+
+    if (bind(ctx->nl_fd, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
+        close(ctx->nl_fd);
+        ctx->nl_fd = -1;
+        return false;
+    }
+
+    ctx->nl_is_stale = true;
+
+    return true;
+}
+
+/*
+ * sends the requests of a read on the rtnetlink socket, opened on first use:
+ * - when the include filter names interfaces literally, without glob characters, an RTM_GETLINK request for each
+ *   of them and <interface_name>
+ * - otherwise an RTM_GETSTATS dump of the counters only, a fraction of the size of an RTM_GETLINK dump with all
+ *   attributes, but identified by index: an RTM_GETLINK dump replaces it when the names of the indexes are stale
+ * returns the number of replies expected, 0 for a dump, -1 on error
+ */
+static int prf_send_net_link(prf_ctx_t* ctx) {
+    const prf_filter_t* filter      = &ctx->cfg_net_filter;
+    char                req[(PRF_MAX_PATTERNS + 1) * PRF_NL_REQ_SIZE];
+    long                len         = 0;
+    int                 count       = 0;
+    bool                is_literal  = (filter->include_count > 0);
+
+    if (ctx->nl_fd < 0 && !prf_open_net_link(ctx)) {
+        return -1;
+    }
+
+    for (int i = 0; i < filter->include_count && is_literal; i++) {
+        is_literal = (strpbrk(filter->include[i], "*?[") == NULL);
+    }
+
+    ctx->nl_seq++;
+    ctx->nl_is_names_dump = false;
+
+    if (is_literal) {
+        for (int i = 0; i < filter->include_count; i++, count++) {
+            len = prf_add_net_link_req(req, len, ctx->nl_seq, filter->include[i]);
+        }
+        if (ctx->cfg_interface_name != NULL && ctx->cfg_interface_name[0] != '\0' &&
+            !prf_is_filter_match(filter, ctx->cfg_interface_name)) {
+            len = prf_add_net_link_req(req, len, ctx->nl_seq, ctx->cfg_interface_name);
+            count++;
+        }
+    } else if (ctx->nl_is_stale || ctx->nl_no_stats) {
+        len = prf_add_net_link_req(req, len, ctx->nl_seq, NULL);
+        ctx->nl_is_names_dump = true;
+    } else {
+        len = prf_add_net_stats_req(req, len, ctx->nl_seq);
+    }
+
+    // the kernel processes every request of the datagram in order
+    if (send(ctx->nl_fd, req, len, 0) != len) {
+        return -1;
+    }
+
+    return count;
+}
+
+/*
+ * sends the requests of a read on the persistent rtnetlink socket and receives all replies into the growable
+ * reply buffer, a dump in several parts
+ * link notifications queued since the previous read mark the names of the indexes stale
+ * returns the number of bytes received, -1 on error
+ */
+static long prf_read_net_link(prf_ctx_t* ctx) {
+    long                len         = 0;
+    long                part;
+    int                 expected;
+    int                 replies     = 0;
+    bool                is_done     = false;
+    char*               buff;
+    struct nlmsghdr*    nh;
+    long                nh_len;
+
+    expected = prf_send_net_link(ctx);
+    if (expected < 0) {
+        if (!ctx->net_warned) {
+            ctx->net_warned = true;
+            fprintf(stderr, "** ERROR - unable to query the interfaces over rtnetlink: %s, reading %s\n",
+                    strerror(errno), PRF_NET_INFO_FILE);
+        }
+        ctx->cfg_net_backend = PRF_NET_BACKEND_PROC;
+        return -1;
+    }
+
+    while (!is_done) {
+        // a part of a dump is never larger than PRF_NL_RECV_SIZE, a smaller room would truncate it
+        if (ctx->nl_buff_size - len < PRF_NL_RECV_SIZE) {
+            buff = realloc(ctx->nl_buff, ctx->nl_buff_size + 2 * PRF_NL_RECV_SIZE);
+            if (buff == NULL) {
+                fprintf(stderr, "** ERROR - memory error!");
+                return -1;
+            }
+            ctx->nl_buff        = buff;
+            ctx->nl_buff_size  += 2 * PRF_NL_RECV_SIZE;
+        }
+
+        part = recv(ctx->nl_fd, ctx->nl_buff + len, ctx->nl_buff_size - len, 0);
+        if (part < 0 && (errno == EINTR || errno == ENOBUFS)) {
+            // ENOBUFS: notifications were lost, not the parts of the dump, which are built as they are received
+            ctx->nl_is_stale = ctx->nl_is_stale || (errno == ENOBUFS);
+            continue;
+        }
+        if (part <= 0) {
+            return -1;
+        }
+
+        // notifications, and replies of an earlier, failed read, are dropped
+        nh = (struct nlmsghdr*)(ctx->nl_buff + len);
+        if (!NLMSG_OK(nh, part) || nh->nlmsg_seq != ctx->nl_seq) {
+            ctx->nl_is_stale = ctx->nl_is_stale || (NLMSG_OK(nh, part) && nh->nlmsg_pid == 0 && nh->nlmsg_seq == 0);
+            continue;
+        }
+
+        for (nh_len = part; NLMSG_OK(nh, nh_len) && !is_done; nh = NLMSG_NEXT(nh, nh_len)) {
+            if (nh->nlmsg_type == NLMSG_DONE) {
+                is_done = true;
+            } else if (expected > 0 && ++replies == expected) {
+                // one RTM_NEWLINK or an ENODEV error per requested interface
+                is_done = true;
+            } else if (expected == 0 && nh->nlmsg_type == NLMSG_ERROR) {
+                // RTM_GETSTATS is refused before Linux 4.7, the dumps of all attributes are used instead
+                ctx->nl_no_stats = ctx->nl_no_stats || !ctx->nl_is_names_dump;
+                return -1;
+            }
+        }
+
+        len += part;
+    }
+
+    // the names of the indexes are rebuilt from the dump
+    if (ctx->nl_is_names_dump) {
+        ctx->nl_name_count  = 0;
+        ctx->nl_is_stale    = false;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &ctx->file_stamps[PRF_FILE_NET_INFO]);
+
+    return len;
+}
+
+/*
+ * returns the position of interface index <index> in the names of the indexes, -1 for none
+ * <hint> is the expected position, the kernel reports the interfaces in the same order on every dump
+ */
+static int prf_find_net_link_name(prf_ctx_t* ctx, int index, int hint) {
+    if (hint < ctx->nl_name_count && ctx->nl_index[hint] == index) {
+        return hint;
+    }
+
+    for (int i = 0; i < ctx->nl_name_count; i++) {
+        if (ctx->nl_index[i] == index) {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+/*
+ * fills the /proc/net/dev counters of <itf> from <stats>, the same sums as the kernel prints there
+ */
+static void prf_set_net_link_stats(prf_net_itf_t* itf, const struct rtnl_link_stats64* stats) {
+    itf->rx[0]  = stats->rx_bytes;
+    itf->rx[1]  = stats->rx_packets;
+    itf->rx[2]  = stats->rx_errors;
+    itf->rx[3]  = stats->rx_dropped + stats->rx_missed_errors;
+    itf->rx[4]  = stats->rx_fifo_errors;
+    itf->rx[5]  = stats->rx_length_errors + stats->rx_over_errors + stats->rx_crc_errors + stats->rx_frame_errors;
+    itf->rx[6]  = stats->rx_compressed;
+    itf->rx[7]  = stats->multicast;
+    itf->tx[0]  = stats->tx_bytes;
+    itf->tx[1]  = stats->tx_packets;
+    itf->tx[2]  = stats->tx_errors;
+    itf->tx[3]  = stats->tx_dropped;
+    itf->tx[4]  = stats->tx_fifo_errors;
+    itf->tx[5]  = stats->collisions;
+    itf->tx[6]  = stats->tx_carrier_errors + stats->tx_aborted_errors + stats->tx_window_errors +
+                  stats->tx_heartbeat_errors;
+    itf->tx[7]  = stats->tx_compressed;
+}
+
+/*
+ * copies the rtnl_link_stats64 of attribute <rta> into <stats>
+ * the structure grows with the kernel versions, the attribute is only 4-byte aligned
+ */
+static inline void prf_get_net_link_stats(const struct rtattr* rta, struct rtnl_link_stats64* stats) {
+    memset(stats, 0, sizeof(*stats));
+    memcpy(stats, RTA_DATA(rta), (RTA_PAYLOAD(rta) < sizeof(*stats)) ? RTA_PAYLOAD(rta) : sizeof(*stats));
+}
+
+bool prf_parse_net_link(prf_ctx_t* ctx, const char* buffer, long size, const struct timespec* stamp) {
+    const struct nlmsghdr*      nh          = (const struct nlmsghdr*)buffer;
+    const struct ifinfomsg*     ifi;
+    const struct if_stats_msg*  ism;
+    const struct rtattr*        rta;
+    const char*                 name;
+    char                        link_name[PRF_NET_NAME_LEN];
+    size_t                      name_len;
+    long                        nh_len      = size;
+    int                         rta_len;
+    int                         cur         = 1 - ctx->net_cur;
+    int                         count       = 0;
+    int                         pos;
+    bool                        has_stats;
+    struct rtnl_link_stats64    stats;
+    struct timespec             now;
+    float                       seconds;
+
+    if (buffer == NULL || size <= 0) {
+        return false;
+    }
+
+    if (stamp == NULL) {
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        stamp = &now;
+    }
+
+    seconds = prf_begin_net_table(ctx, stamp);
+
+    // the attributes of each message are walked once for the name and the counters
+    for (; NLMSG_OK(nh, nh_len) && count < PRF_NET_MAX_ITF; nh = NLMSG_NEXT(nh, nh_len)) {
+        name        = NULL;
+        has_stats   = false;
+
+        if (nh->nlmsg_type == RTM_NEWLINK && nh->nlmsg_len >= NLMSG_LENGTH(sizeof(struct ifinfomsg))) {
+            ifi     = NLMSG_DATA(nh);
+            rta_len = IFLA_PAYLOAD(nh);
+            for (rta = IFLA_RTA(ifi); RTA_OK(rta, rta_len) && !(name != NULL && has_stats); rta = RTA_NEXT(rta, rta_len)) {
+                if (rta->rta_type == IFLA_IFNAME) {
+                    name_len = strnlen(RTA_DATA(rta), (RTA_PAYLOAD(rta) < PRF_NET_NAME_LEN) ? RTA_PAYLOAD(rta) : PRF_NET_NAME_LEN - 1);
+                    memcpy(link_name, RTA_DATA(rta), name_len);
+                    link_name[name_len] = '\0';
+                    name = link_name;
+
+                    pos  = prf_find_net_link_name(ctx, ifi->ifi_index, count);
+                    pos  = (pos < 0 && ctx->nl_name_count < PRF_NET_MAX_ITF) ? ctx->nl_name_count++ : pos;
+                    if (pos >= 0) {
+                        ctx->nl_index[pos] = ifi->ifi_index;
+                        memcpy(ctx->nl_names[pos], link_name, PRF_NET_NAME_LEN);
+                    }
+                } else if (rta->rta_type == IFLA_STATS64) {
+                    prf_get_net_link_stats(rta, &stats);
+                    has_stats = true;
+                }
+            }
+        } else if (nh->nlmsg_type == RTM_NEWSTATS && nh->nlmsg_len >= NLMSG_LENGTH(sizeof(struct if_stats_msg))) {
+            ism     = NLMSG_DATA(nh);
+            rta_len = nh->nlmsg_len - NLMSG_LENGTH(sizeof(struct if_stats_msg));
+            for (rta = (const struct rtattr*)((const char*)ism + NLMSG_ALIGN(sizeof(struct if_stats_msg)));
+                 RTA_OK(rta, rta_len) && !has_stats; rta = RTA_NEXT(rta, rta_len)) {
+                if (rta->rta_type == IFLA_STATS_LINK_64) {
+                    prf_get_net_link_stats(rta, &stats);
+                    has_stats = true;
+                }
+            }
+
+            // an interface created since the names were read is picked up by the next read
+            pos = prf_find_net_link_name(ctx, ism->ifindex, count);
+            if (pos >= 0) {
+                name = ctx->nl_names[pos];
+            } else {
+                ctx->nl_is_stale = true;
+            }
+        }
+
+        if (name != NULL && has_stats) {
+            strcpy(ctx->net_itfs[cur][count].name, name);
+            prf_set_net_link_stats(&ctx->net_itfs[cur][count], &stats);
+            prf_add_net_itf(ctx, count, seconds);
+            count++;
+        }
+    }
+
+    prf_end_net_table(ctx, count, stamp);
+
+    return true;
+}
+
+bool prf_read_net_info(prf_ctx_t* ctx) {
+    bool                    status          = false;
+    long                    len;
+    prf_net_itf_t*          itf;
+
+    bool                    is_parsed;
+
+    if (ctx->cfg_net_backend == PRF_NET_BACKEND_NETLINK) {
+        len       = prf_read_net_link(ctx);
+        is_parsed = (len >= 0 && prf_parse_net_link(ctx, ctx->nl_buff, len, &ctx->file_stamps[PRF_FILE_NET_INFO]));
+    } else {
+        if (ctx->net_buff == NULL) {
+            ctx->net_buff_size = PRF_NET_BUFF_SIZE;
+        }
+
+        len       = prf_read_proc_file_grow(ctx, PRF_FILE_NET_INFO, &ctx->net_buff, &ctx->net_buff_size, NULL);
+        is_parsed = (len >= 0 && prf_parse_net_info(ctx, ctx->net_buff, len, &ctx->file_stamps[PRF_FILE_NET_INFO]));
+    }
+
+    if (is_parsed) {
+        if (ctx->net_itf_index >= 0) {
+            itf = &ctx->net_itfs[ctx->net_cur][ctx->net_itf_index];
+
+            // bytes/s over the measured time between the reads, 0 on the first read
+            ctx->net_rx_rate = (float)(itf->rx_bytes_rate * PRF_NET_UNIT_CONV);
+            ctx->net_tx_rate = (float)(itf->tx_bytes_rate * PRF_NET_UNIT_CONV);
+
+            // store last read values
+            memcpy(ctx->net_rx, itf->rx, sizeof(ctx->net_rx));
+            memcpy(ctx->net_tx, itf->tx, sizeof(ctx->net_tx));
+
+            status = true;
+        } else {
+            if (!ctx->net_warned) {
+                ctx->net_warned = true;
+                fprintf(stderr, "** ERROR - unable to find the interface '%s'\n", ctx->cfg_interface_name);
+            }
+        }
+    }
+
+    return status;
+}
+
+bool prf_get_sys_backend(const char* name, prf_sys_backend_t* backend) {
+    for (int i = 0; name != NULL && i < PRF_SYS_BACKEND_COUNT; i++) {
+        if (strcmp(name, prf_sys_backend_names[i]) == 0) {
+            *backend = (prf_sys_backend_t)i;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+const char* prf_get_sys_backend_name(prf_sys_backend_t backend) {
+    return (backend >= 0 && backend < PRF_SYS_BACKEND_COUNT) ? prf_sys_backend_names[backend] : NULL;
+}
+
+bool prf_get_net_backend(const char* name, prf_net_backend_t* backend) {
+    for (int i = 0; name != NULL && i < PRF_NET_BACKEND_COUNT; i++) {
+        if (strcmp(name, prf_net_backend_names[i]) == 0) {
+            *backend = (prf_net_backend_t)i;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+const char* prf_get_net_backend_name(prf_net_backend_t backend) {
+    return (backend >= 0 && backend < PRF_NET_BACKEND_COUNT) ? prf_net_backend_names[backend] : NULL;
+}
+
+bool prf_get_io_backend(const char* name, prf_io_backend_t* backend) {
+    for (int i = 0; name != NULL && i < PRF_IO_BACKEND_COUNT; i++) {
+        if (strcmp(name, prf_io_backend_names[i]) == 0) {
+            *backend = (prf_io_backend_t)i;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+const char* prf_get_io_backend_name(prf_io_backend_t backend) {
+    return (backend >= 0 && backend < PRF_IO_BACKEND_COUNT) ? prf_io_backend_names[backend] : NULL;
+}
+
+/*
+ * splits the comma separated glob patterns of <list> into <patterns>
+ */
+static int prf_split_patterns(char* list, char* patterns[PRF_MAX_PATTERNS]) {
+    int     count       = 0;
+    char*   rest_line   = NULL;
+
+    for (char* pattern = strtok_r(list, ",", &rest_line);
+        pattern != NULL && count < PRF_MAX_PATTERNS;
+        pattern = strtok_r(NULL, ",", &rest_line)) {
+        if (*pattern != '\0') {
+            patterns[count++] = pattern;
+        }
+    }
+
+    return count;
+}
+
+/*
+ * sets <filter> to the comma separated glob patterns <include> and <exclude>
+ */
+static void prf_set_filter(prf_filter_t* filter, const char* include, const char* exclude) {
+    size_t  include_len = (include != NULL) ? strlen(include) : 0;
+    size_t  exclude_len = (exclude != NULL) ? strlen(exclude) : 0;
+
+    prf_free_mem(filter->patterns);
+    filter->include_count = 0;
+    filter->exclude_count = 0;
+
+    // one allocation holds both lists, split in place
+    filter->patterns = (char*)malloc(include_len + exclude_len + 2);
+    if (filter->patterns == NULL) {
+        fprintf(stderr, "** ERROR - memory error!");
+        return;
+    }
+
+    memcpy(filter->patterns, (include != NULL) ? include : "", include_len + 1);
+    memcpy(filter->patterns + include_len + 1, (exclude != NULL) ? exclude : "", exclude_len + 1);
+
+    filter->include_count = prf_split_patterns(filter->patterns, filter->include);
+    filter->exclude_count = prf_split_patterns(filter->patterns + include_len + 1, filter->exclude);
+}
+
+void prf_set_net_filters(prf_ctx_t* ctx, const char* include, const char* exclude) {
+    prf_set_filter(&ctx->cfg_net_filter, include, exclude);
+
+    // re-evaluate the filters of the interfaces already read
+    for (int i = 0; i < ctx->net_itf_count[ctx->net_cur]; i++) {
+        ctx->net_itf_included[ctx->net_cur][i] = prf_is_filter_match(&ctx->cfg_net_filter, ctx->net_itfs[ctx->net_cur][i].name);
+    }
+}
+
+// modelled after /proc/net/dev, example:
+//Inter-|   Receive                                                |  Transmit
+// face |bytes    packets errs drop fifo frame compressed multicast|bytes    packets errs drop fifo colls carrier compressed
+//    lo:     720      12    0    0    0     0          0         0      720      12    0    0    0     0       0          0
+//  eth0:   11031      34    0    0    0     0          0         0     5996      48    0    0    0     0       0          0
+void prf_print_net_info(prf_ctx_t* ctx) {
+    printf("READ: %s\n\
+Interface | Receive                                                        | Transmit\n\
+          | bytes\tpackets\terrs\tdrop\tfifo\tframe\tcompressed\tmulticast | bytes\tpackets\terrs\tdrop\tfifo\tcolls\tcarrier\tcompressed\n\
+%s %8lu\t%8lu\t%5lu\t%5lu\t%5lu\t%6lu\t%11lu\t%10lu | %8lu\t%8lu\t%5lu\t%5lu\t%5lu\t%6lu\t%8lu\t%11lu\n%s\n",
+           PRF_NET_INFO_FILE,
+           ctx->cfg_interface_name,
+           ctx->net_rx[0], ctx->net_rx[1], ctx->net_rx[2], ctx->net_rx[3],
+           ctx->net_rx[4], ctx->net_rx[5], ctx->net_rx[6], ctx->net_rx[7],
+           ctx->net_tx[0], ctx->net_tx[1], ctx->net_tx[2], ctx->net_tx[3],
+           ctx->net_tx[4], ctx->net_tx[5], ctx->net_tx[6], ctx->net_tx[7],
+           PRF_LIB_HEADER
+    );
+}
+
+// Rx and Tx rates (kb/s)
+void prf_print_net_rates(prf_ctx_t* ctx) {
+    printf("READ: %s\nRx: %10lu bytes, %8.2f kbps | Tx: %10lu bytes, %8.2f kbps\n%s\n",
+            PRF_NET_INFO_FILE,
+            ctx->net_rx[0], ctx->net_rx_rate, ctx->net_tx[0], ctx->net_tx_rate,
+            PRF_LIB_HEADER);
+}
+
+// per-interface rates of the included interfaces and their totals
+void prf_print_net_itf_rates(prf_ctx_t* ctx) {
+    const prf_net_itf_t*    itf;
+
+    printf("READ: %s\n%-15s | %12s %10s %8s %8s | %12s %10s %8s %8s\n",
+            PRF_NET_INFO_FILE,
+            "Interface", "Rx bytes/s", "packets/s", "errs/s", "drops/s", "Tx bytes/s", "packets/s", "errs/s", "drops/s");
+
+    for (int i = 0; i <= ctx->net_itf_count[ctx->net_cur]; i++) {
+        if (i < ctx->net_itf_count[ctx->net_cur]) {
+            if (!ctx->net_itf_included[ctx->net_cur][i]) {
+                continue;
+            }
+            itf = &ctx->net_itfs[ctx->net_cur][i];
+        } else {
+            itf = &ctx->net_total;
+        }
+
+        printf("%-15s | %12.1f %10.1f %8.1f %8.1f | %12.1f %10.1f %8.1f %8.1f\n",
+                itf->name,
+                itf->rx_bytes_rate, itf->rx_packets_rate, itf->rx_errs_rate, itf->rx_drops_rate,
+                itf->tx_bytes_rate, itf->tx_packets_rate, itf->tx_errs_rate, itf->tx_drops_rate);
+    }
+
+    printf("%s\n", PRF_LIB_HEADER);
+}
+
+void prf_get_net_raw_info(prf_ctx_t* ctx, unsigned long r[PRF_NET_ARRAY_LEN], unsigned long t[PRF_NET_ARRAY_LEN]) {
+    memcpy(r, ctx->net_rx, sizeof(ctx->net_rx));
+    memcpy(t, ctx->net_tx, sizeof(ctx->net_tx));
+}
+
+void prf_get_net_rate_info(prf_ctx_t* ctx, float n[2]) {
+    n[0] = ctx->net_rx_rate;
+    n[1] = ctx->net_tx_rate;
+}
+
+int prf_get_net_itf_all(prf_ctx_t* ctx, prf_net_itf_t* itf, int len) {
+    int     count = 0;
+
+    for (int i = 0; i < ctx->net_itf_count[ctx->net_cur] && count < len; i++) {
+        if (ctx->net_itf_included[ctx->net_cur][i]) {
+            itf[count++] = ctx->net_itfs[ctx->net_cur][i];
+        }
+    }
+
+    return count;
+}
+
+bool prf_get_net_itf(prf_ctx_t* ctx, const char* name, prf_net_itf_t* itf) {
+    for (int i = 0; i < ctx->net_itf_count[ctx->net_cur]; i++) {
+        if (strcmp(ctx->net_itfs[ctx->net_cur][i].name, name) == 0) {
+            *itf = ctx->net_itfs[ctx->net_cur][i];
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void prf_get_net_total(prf_ctx_t* ctx, prf_net_itf_t* total) {
+    *total = ctx->net_total;
+}
+
+bool prf_read_disk_info(prf_ctx_t* ctx) {
+    long    len;
+
+    if (ctx->disk_buff == NULL) {
+        ctx->disk_buff_size = PRF_DISK_BUFF_SIZE;
+    }
+
+    len = prf_read_proc_file_grow(ctx, PRF_FILE_DISK_INFO, &ctx->disk_buff, &ctx->disk_buff_size, NULL);
+
+    return (len >= 0 && prf_parse_disk_info(ctx, ctx->disk_buff, len, &ctx->file_stamps[PRF_FILE_DISK_INFO]));
+}
+
+/*
+ * reports whether the block device <name> passes the filters, a partition has no /sys/block entry
+ */
+static bool prf_is_disk_included(prf_ctx_t* ctx, const char* name) {
+    char    path[sizeof(PRF_SYS_BLOCK_DIR) + PRF_DISK_NAME_LEN];
+    char*   p;
+
+    if (!prf_is_filter_match(&ctx->cfg_disk_filter, name)) {
+        return false;
+    }
+
+    if (ctx->cfg_disk_partitions) {
+        return true;
+    }
+
+    // "cciss/c0d0" is "cciss!c0d0" in sysfs
+    snprintf(path, sizeof(path), "%s%s", PRF_SYS_BLOCK_DIR, name);
+    for (p = path + sizeof(PRF_SYS_BLOCK_DIR) - 1; *p != '\0'; p++) {
+        if (*p == '/') {
+            *p = '!';
+        }
+    }
+
+    return (faccessat((ctx->root_fd < 0) ? AT_FDCWD : ctx->root_fd, path + (ctx->root_fd >= 0), F_OK, 0) == 0);
+}
+
+/*
+ * computes the rates of <disk> from the deltas to <prev> over <seconds>
+ */
+static void prf_calc_disk_rates(prf_disk_t* disk, const prf_disk_t* prev, float seconds) {
+    unsigned long   ios;
+    unsigned long   ticks;
+    float           ms      = seconds * 1000.0;
+
+    disk->read_iops     = prf_calc_rate(disk->stats[0], prev->stats[0], seconds);
+    disk->write_iops    = prf_calc_rate(disk->stats[4], prev->stats[4], seconds);
+    disk->read_mbps     = prf_calc_rate(disk->stats[2], prev->stats[2], seconds) * PRF_DISK_SECTOR_SIZE / 1000000.0;
+    disk->write_mbps    = prf_calc_rate(disk->stats[6], prev->stats[6], seconds) * PRF_DISK_SECTOR_SIZE / 1000000.0;
+
+    // the I/Os completed in the interval and the time they spent, like the await of iostat
+    ios   = (disk->stats[0] - prev->stats[0]) + (disk->stats[4] - prev->stats[4]);
+    ticks = (disk->stats[3] - prev->stats[3]) + (disk->stats[7] - prev->stats[7]);
+    disk->await_ms      = (ios > 0 && disk->stats[0] >= prev->stats[0] && disk->stats[4] >= prev->stats[4]) ?
+                          (float)ticks / (float)ios : 0.0;
+
+    disk->util          = prf_calc_rate(disk->stats[9], prev->stats[9], ms) * 100.0;
+    disk->util          = (disk->util > 100.0) ? 100.0 : disk->util;
+    disk->queue_size    = prf_calc_rate(disk->stats[10], prev->stats[10], ms);
+}
+
+bool prf_parse_disk_info(prf_ctx_t* ctx, const char* buffer, long size, const struct timespec* stamp) {
+    const char*     p           = buffer;
+    const char*     end         = buffer + size;
+    const char*     name;
+    const char*     eol;
+    int             last        = ctx->disk_cur;
+    int             cur         = 1 - last;
+    int             last_count  = ctx->disk_count[last];
+    int             count       = 0;
+    long            len;
+    unsigned long   ios         = 0;
+    unsigned long   ticks       = 0;
+    prf_disk_t*     disk;
+    prf_disk_t*     prev;
+    prf_disk_t*     total       = &ctx->disk_total;
+    struct timespec now;
+    float           seconds;
+
+    if (buffer == NULL || size <= 0) {
+        return false;
+    }
+
+    if (stamp == NULL) {
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        stamp = &now;
+    }
+
+    seconds = prf_rate_seconds(&ctx->disk_stamp, stamp);
+
+    memset(total, 0, sizeof(*total));
+    strcpy(total->name, "total");
+
+    // "<major> <minor> <name> <11 counters> [<discard and flush counters>]\n"
+    while (p < end && count < PRF_DISK_MAX_DEV) {
+        eol = memchr(p, '\n', end - p);
+        eol = (eol != NULL) ? eol : end;
+
+        prf_parse_ulong(&p, eol);
+        prf_parse_ulong(&p, eol);
+
+        while (p < eol && *p == ' ') {
+            p++;
+        }
+
+        name = p;
+        while (p < eol && *p != ' ') {
+            p++;
+        }
+
+        len = p - name;
+        if (len == 0) {
+            break;
+        }
+        if (len >= PRF_DISK_NAME_LEN) {
+            len = PRF_DISK_NAME_LEN - 1;
+        }
+
+        disk = &ctx->disk_devs[cur][count];
+        memcpy(disk->name, name, len);
+        disk->name[len] = '\0';
+
+        for (int i = 0; i < PRF_DISK_ARRAY_LEN; i++) {
+            disk->stats[i] = prf_parse_ulong_fast(&p, eol);
+        }
+
+        // previous read: the same position, unless devices came or went
+        prev = NULL;
+        if (count < last_count && strcmp(ctx->disk_devs[last][count].name, disk->name) == 0) {
+            prev = &ctx->disk_devs[last][count];
+        } else {
+            for (int i = 0; i < last_count; i++) {
+                if (strcmp(ctx->disk_devs[last][i].name, disk->name) == 0) {
+                    prev = &ctx->disk_devs[last][i];
+                    break;
+                }
+            }
+        }
+
+        if (prev != NULL) {
+            // filter results are kept with the device, globs and /sys/block are checked once per device
+            ctx->disk_included[cur][count] = ctx->disk_included[last][prev - ctx->disk_devs[last]];
+            prf_calc_disk_rates(disk, prev, seconds);
+        } else {
+            ctx->disk_included[cur][count] = prf_is_disk_included(ctx, disk->name);
+            disk->read_iops     = disk->write_iops  = 0.0;
+            disk->read_mbps     = disk->write_mbps  = 0.0;
+            disk->await_ms      = disk->util        = disk->queue_size = 0.0;
+        }
+
+        if (ctx->disk_included[cur][count]) {
+            for (int i = 0; i < PRF_DISK_ARRAY_LEN; i++) {
+                total->stats[i] += disk->stats[i];
+            }
+            total->read_iops    += disk->read_iops;
+            total->write_iops   += disk->write_iops;
+            total->read_mbps    += disk->read_mbps;
+            total->write_mbps   += disk->write_mbps;
+            total->queue_size   += disk->queue_size;
+            total->util          = (disk->util > total->util) ? disk->util : total->util;
+
+            if (prev != NULL && disk->await_ms > 0.0) {
+                ios   += (disk->stats[0] - prev->stats[0]) + (disk->stats[4] - prev->stats[4]);
+                ticks += (disk->stats[3] - prev->stats[3]) + (disk->stats[7] - prev->stats[7]);
+            }
+        }
+
+        count++;
+        p = eol + 1;
+    }
+
+    total->await_ms = (ios > 0) ? (float)ticks / (float)ios : 0.0;
+
+    ctx->disk_count[cur]    = count;
+    ctx->disk_cur           = cur;
+    ctx->disk_stamp         = *stamp;
+
+    return true;
+}
+
+void prf_set_disk_filters(prf_ctx_t* ctx, const char* include, const char* exclude, bool partitions) {
+    prf_set_filter(&ctx->cfg_disk_filter, include, exclude);
+    ctx->cfg_disk_partitions = partitions;
+
+    // re-evaluate the filters of the devices already read
+    for (int i = 0; i < ctx->disk_count[ctx->disk_cur]; i++) {
+        ctx->disk_included[ctx->disk_cur][i] = prf_is_disk_included(ctx, ctx->disk_devs[ctx->disk_cur][i].name);
+    }
+}
+
+// per-device rates of the included block devices and their totals
+void prf_print_disk_rates(prf_ctx_t* ctx) {
+    const prf_disk_t*   disk;
+
+    printf("READ: %s\n%-15s | %10s %10s %10s %10s | %10s %8s %8s\n",
+            PRF_DISK_INFO_FILE,
+            "Device", "r/s", "w/s", "rMB/s", "wMB/s", "await ms", "util %", "queue");
+
+    for (int i = 0; i <= ctx->disk_count[ctx->disk_cur]; i++) {
+        if (i < ctx->disk_count[ctx->disk_cur]) {
+            if (!ctx->disk_included[ctx->disk_cur][i]) {
+                continue;
+            }
+            disk = &ctx->disk_devs[ctx->disk_cur][i];
+        } else {
+            disk = &ctx->disk_total;
+        }
+
+        printf("%-15s | %10.1f %10.1f %10.2f %10.2f | %10.2f %8.1f %8.2f\n",
+                disk->name,
+                disk->read_iops, disk->write_iops, disk->read_mbps, disk->write_mbps,
+                disk->await_ms, disk->util, disk->queue_size);
+    }
+
+    printf("%s\n", PRF_LIB_HEADER);
+}
+
+int prf_get_disk_all(prf_ctx_t* ctx, prf_disk_t* disk, int len) {
+    int     count = 0;
+
+    for (int i = 0; i < ctx->disk_count[ctx->disk_cur] && count < len; i++) {
+        if (ctx->disk_included[ctx->disk_cur][i]) {
+            disk[count++] = ctx->disk_devs[ctx->disk_cur][i];
+        }
+    }
+
+    return count;
+}
+
+bool prf_get_disk(prf_ctx_t* ctx, const char* name, prf_disk_t* disk) {
+    for (int i = 0; i < ctx->disk_count[ctx->disk_cur]; i++) {
+        if (strcmp(ctx->disk_devs[ctx->disk_cur][i].name, name) == 0) {
+            *disk = ctx->disk_devs[ctx->disk_cur][i];
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void prf_get_disk_total(prf_ctx_t* ctx, prf_disk_t* total) {
+    *total = ctx->disk_total;
+}
+
+/*
+ * closes the descriptors of the process <entry>
+ */
+static void prf_close_pid_entry(prf_pid_entry_t* entry) {
+    for (int i = 0; i < PRF_PID_FILE_COUNT; i++) {
+        if (entry->fds[i] >= 0) {
+            close(entry->fds[i]);
+            entry->fds[i] = -1;
+        }
+    }
+
+    if (entry->dir_fd >= 0) {
+        close(entry->dir_fd);
+        entry->dir_fd = -1;
+    }
+}
+
+/*
+ * opens /proc/<pid> and its files into <entry>
+ * returns false if the process does not exist
+ */
+static bool prf_open_pid_entry(prf_ctx_t* ctx, prf_pid_entry_t* entry, pid_t pid) {
+    char    path[sizeof(PRF_PID_DIR) + 16];
+
+    memset(entry, 0, sizeof(*entry));
+    entry->info.pid = pid;
+    for (int i = 0; i < PRF_PID_FILE_COUNT; i++) {
+        entry->fds[i] = -1;
+    }
+
+    // O_PATH: the directory is only a base for openat()
+    snprintf(path, sizeof(path), "%s%d", PRF_PID_DIR, (int)pid);
+    entry->dir_fd = prf_open_root(ctx, path, O_PATH | O_DIRECTORY | O_CLOEXEC);
+    if (entry->dir_fd < 0) {
+        return false;
+    }
+
+    for (int i = 0; i < PRF_PID_FILE_COUNT; i++) {
+        entry->fds[i] = openat(entry->dir_fd, prf_pid_file_names[i], O_RDONLY | O_CLOEXEC);
+    }
+
+    // io is missing without ptrace access to the process
+    if (entry->fds[PRF_PID_FILE_STAT] < 0 || entry->fds[PRF_PID_FILE_STATM] < 0) {
+        prf_close_pid_entry(entry);
+        return false;
+    }
+
+    return true;
+}
+
+/*
+ * parses a numeric field of /proc/[pid]/stat at <*p>, the sign is dropped
+ */
+static inline unsigned long prf_parse_stat_field(const char** p, const char* end) {
+    while (*p < end && (**p == ' ' || **p == '-')) {
+        (*p)++;
+    }
+
+    return prf_parse_ulong(p, end);
+}
+
+/*
+ * re-reads the files of the process <entry> at <stamp> and computes its rates
+ * returns false if the process exited
+ */
+static bool prf_read_pid_entry(prf_ctx_t* ctx, prf_pid_entry_t* entry, const struct timespec* stamp) {
+    char            buff[PRF_PID_BUFF_SIZE];
+    const char*     p;
+    const char*     end;
+    const char*     eol;
+    const char*     comm;
+    const char*     comm_end;
+    long            len;
+    unsigned long   v[17];      // fields 4 to 20 of stat: ppid to num_threads
+    unsigned long   ticks;
+    prf_pid_t*      info        = &entry->info;
+    prf_pid_t       prev        = entry->info;
+    int             index       = (int)(entry - ctx->pid_entries);
+    float           seconds;
+
+    // "<pid> (<comm>) <state> <ppid> ...", <comm> may hold spaces and parentheses
+    len = prf_read_slot(ctx, PRF_URING_PID_SLOT(index, PRF_PID_FILE_STAT), entry->fds[PRF_PID_FILE_STAT], buff,
+                        sizeof(buff));
+    if (len <= 0) {
+        return false;
+    }
+
+    end      = buff + len;
+    comm     = memchr(buff, '(', len);
+    comm_end = memrchr(buff, ')', len);
+    if (comm == NULL || comm_end == NULL || comm_end < comm || end - comm_end < 3) {
+        return false;
+    }
+
+    len = comm_end - comm - 1;
+    if (len >= PRF_PID_NAME_LEN) {
+        len = PRF_PID_NAME_LEN - 1;
+    }
+    memcpy(info->name, comm + 1, len);
+    info->name[len] = '\0';
+    info->state     = comm_end[2];
+
+    p = comm_end + 3;
+    for (int i = 0; i < 17; i++) {
+        v[i] = prf_parse_stat_field(&p, end);
+    }
+
+    info->ppid      = (pid_t)v[0];
+    info->maj_flt   = v[8];
+    info->utime     = v[10];
+    info->stime     = v[11];
+    info->threads   = (int)v[16];
+
+    // "<size> <resident> <shared> <text> <lib> <data> <dt>" in pages
+    len = prf_read_slot(ctx, PRF_URING_PID_SLOT(index, PRF_PID_FILE_STATM), entry->fds[PRF_PID_FILE_STATM], buff,
+                        sizeof(buff));
+    if (len <= 0) {
+        return false;
+    }
+
+    p   = buff;
+    end = buff + len;
+    info->vm_kb     = prf_parse_ulong(&p, end) * ctx->pid_page_kb;
+    info->rss_kb    = prf_parse_ulong(&p, end) * ctx->pid_page_kb;
+
+    // "<key>: <value>" lines, a read error means no ptrace access, the file is not retried
+    len = prf_read_slot(ctx, PRF_URING_PID_SLOT(index, PRF_PID_FILE_IO), entry->fds[PRF_PID_FILE_IO], buff,
+                        sizeof(buff));
+    info->has_io = (len > 0);
+    if (info->has_io) {
+        for (p = buff, end = buff + len; p < end; p = eol + 1) {
+            eol = memchr(p, '\n', end - p);
+            eol = (eol != NULL) ? eol : end;
+
+            if (strncmp(p, "read_bytes:", 11) == 0) {
+                p += 11;
+                info->read_bytes = prf_parse_ulong(&p, eol);
+            } else if (strncmp(p, "write_bytes:", 12) == 0) {
+                p += 12;
+                info->write_bytes = prf_parse_ulong(&p, eol);
+            }
+        }
+    } else if (entry->fds[PRF_PID_FILE_IO] >= 0) {
+        close(entry->fds[PRF_PID_FILE_IO]);
+        entry->fds[PRF_PID_FILE_IO] = -1;
+    }
+
+    seconds = prf_rate_seconds(&entry->stamp, stamp);
+    ticks   = info->utime + info->stime;
+
+    info->cpu_pt        = prf_calc_rate(ticks, prev.utime + prev.stime, seconds) * 100.0 / (float)ctx->pid_clk_tck;
+    info->maj_flt_rate  = prf_calc_rate(info->maj_flt, prev.maj_flt, seconds);
+    info->read_rate     = prf_calc_rate(info->read_bytes, prev.read_bytes, seconds);
+    info->write_rate    = prf_calc_rate(info->write_bytes, prev.write_bytes, seconds);
+    entry->stamp        = *stamp;
+
+    return true;
+}
+
+/*
+ * appends the children of all threads of the process <entry> to <pids> unless they are in it already
+ * /proc/[pid]/task/[tid]/children needs CONFIG_PROC_CHILDREN
+ */
+static void prf_find_pid_children(prf_ctx_t* ctx, prf_pid_entry_t* entry, pid_t pids[PRF_PID_MAX], int* count) {
+    char            path[PRF_PID_BUFF_SIZE];
+    char            buff[PRF_PID_CHILD_BUFF_SIZE];
+    const char*     p;
+    const char*     end;
+    int             task_fd;
+    int             fd;
+    long            len;
+    pid_t           child;
+    bool            is_known;
+    DIR*            dir;
+    struct dirent*  ent;
+
+    task_fd = openat(entry->dir_fd, "task", O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    dir     = (task_fd >= 0) ? fdopendir(task_fd) : NULL;
+    if (dir == NULL) {
+        if (task_fd >= 0) {
+            close(task_fd);
+        }
+        return;
+    }
+
+    while ((ent = readdir(dir)) != NULL && *count < PRF_PID_MAX) {
+        if (ent->d_name[0] == '.') {
+            continue;
+        }
+
+        snprintf(path, sizeof(path), "task/%s/children", ent->d_name);
+        fd = openat(entry->dir_fd, path, O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            if (errno == ENOENT && !ctx->pid_warned) {
+                ctx->pid_warned = true;
+                fprintf(stderr, "** ERROR - unable to find the children of the processes, no CONFIG_PROC_CHILDREN\n");
+            }
+            continue;
+        }
+
+        len = prf_pread_file(fd, buff, sizeof(buff));
+        close(fd);
+
+        // "<pid> <pid> ... ", a truncated list ends at the last complete PID
+        end = (len > 0) ? buff + len : buff;
+        if (len == (long)sizeof(buff) - 1) {
+            end = memrchr(buff, ' ', len);
+            end = (end != NULL) ? end : buff;
+        }
+
+        for (p = buff; p < end && *count < PRF_PID_MAX; p++) {
+            child = (pid_t)prf_parse_ulong(&p, end);
+            if (child <= 0) {
+                break;
+            }
+
+            is_known = false;
+            for (int i = 0; i < *count && !is_known; i++) {
+                is_known = (pids[i] == child);
+            }
+            if (!is_known) {
+                pids[(*count)++] = child;
+            }
+        }
+    }
+
+    closedir(dir);
+}
+
+bool prf_read_pid_info(prf_ctx_t* ctx) {
+    pid_t               pids[PRF_PID_MAX];
+    int                 count;
+    int                 kept        = 0;
+    prf_pid_entry_t*    entry;
+    struct timespec     stamp;
+
+    pthread_mutex_lock(&ctx->pid_lock);
+    count = ctx->pid_watch_count;
+    memcpy(pids, ctx->pid_watch, count * sizeof(pid_t));
+    pthread_mutex_unlock(&ctx->pid_lock);
+
+    if (count == 0 && ctx->pid_count == 0) {
+        return false;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &stamp);
+
+    for (int i = 0; i < ctx->pid_count; i++) {
+        ctx->pid_entries[i].is_seen = false;
+    }
+
+    // breadth first: the watched processes, then their children, grandchildren, ...
+    for (int i = 0; i < count; i++) {
+        entry = NULL;
+        for (int j = 0; j < ctx->pid_count; j++) {
+            if (ctx->pid_entries[j].info.pid == pids[i]) {
+                entry = &ctx->pid_entries[j];
+                break;
+            }
+        }
+
+        // the descriptors of an exited process fail even if its PID is reused, which is opened anew
+        if (entry != NULL && (entry->dir_fd < 0 || !prf_read_pid_entry(ctx, entry, &stamp))) {
+            prf_close_pid_entry(entry);
+            entry->info.pid = 0;
+            entry           = NULL;
+        }
+
+        if (entry == NULL && ctx->pid_count < PRF_PID_MAX) {
+            entry = &ctx->pid_entries[ctx->pid_count];
+            if (prf_open_pid_entry(ctx, entry, pids[i]) && prf_read_pid_entry(ctx, entry, &stamp)) {
+                ctx->pid_count++;
+            } else {
+                prf_close_pid_entry(entry);
+                entry = NULL;
+            }
+        }
+
+        if (entry != NULL) {
+            entry->is_seen = true;
+            if (ctx->cfg_pid_descendants) {
+                prf_find_pid_children(ctx, entry, pids, &count);
+            }
+        }
+    }
+
+    // drop the processes that exited or are no longer watched, keeping the order
+    for (int i = 0; i < ctx->pid_count; i++) {
+        if (ctx->pid_entries[i].is_seen) {
+            if (kept != i) {
+                ctx->pid_entries[kept] = ctx->pid_entries[i];
+            }
+            kept++;
+        } else {
+            prf_close_pid_entry(&ctx->pid_entries[i]);
+        }
+    }
+    ctx->pid_count = kept;
+
+    return true;
+}
+
+bool prf_watch_pid(prf_ctx_t* ctx, pid_t pid) {
+    bool    status = true;
+
+    pid = (pid == 0) ? getpid() : pid;
+
+    pthread_mutex_lock(&ctx->pid_lock);
+    for (int i = 0; i < ctx->pid_watch_count; i++) {
+        if (ctx->pid_watch[i] == pid) {
+            pthread_mutex_unlock(&ctx->pid_lock);
+            return true;
+        }
+    }
+
+    if (ctx->pid_watch_count < PRF_PID_MAX) {
+        ctx->pid_watch[ctx->pid_watch_count++] = pid;
+    } else {
+        fprintf(stderr, "** ERROR - unable to watch PID %d, %d processes are watched\n", (int)pid, PRF_PID_MAX);
+        status = false;
+    }
+    pthread_mutex_unlock(&ctx->pid_lock);
+
+    return status;
+}
+
+bool prf_unwatch_pid(prf_ctx_t* ctx, pid_t pid) {
+    bool    status = false;
+
+    pid = (pid == 0) ? getpid() : pid;
+
+    pthread_mutex_lock(&ctx->pid_lock);
+    for (int i = 0; i < ctx->pid_watch_count; i++) {
+        if (ctx->pid_watch[i] == pid) {
+            memmove(&ctx->pid_watch[i], &ctx->pid_watch[i + 1], (ctx->pid_watch_count - i - 1) * sizeof(pid_t));
+            ctx->pid_watch_count--;
+            status = true;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&ctx->pid_lock);
+
+    return status;
+}
+
+// resource usage of the watched processes, like the columns of top
+void prf_print_pid_info(prf_ctx_t* ctx) {
+    const prf_pid_t*    info;
+
+    if (ctx->pid_count == 0) {
+        return;
+    }
+
+    printf("READ: %s[pid]/{stat,statm,io}\n%7s %-15s %s %7s | %7s %10s %10s | %12s %12s %9s\n",
+            PRF_PID_DIR,
+            "PID", "Name", "S", "Threads", "CPU %", "RSS kB", "majflt/s", "read B/s", "write B/s", "majflt");
+
+    for (int i = 0; i < ctx->pid_count; i++) {
+        info = &ctx->pid_entries[i].info;
+        printf("%7d %-15s %c %7d | %7.1f %10lu %10.1f | ",
+                (int)info->pid, info->name, info->state, info->threads,
+                info->cpu_pt, info->rss_kb, info->maj_flt_rate);
+        if (info->has_io) {
+            printf("%12.1f %12.1f %9lu\n", info->read_rate, info->write_rate, info->maj_flt);
+        } else {
+            printf("%12s %12s %9lu\n", "-", "-", info->maj_flt);
+        }
+    }
+
+    printf("%s\n", PRF_LIB_HEADER);
+}
+
+int prf_get_pid_all(prf_ctx_t* ctx, prf_pid_t* pids, int len) {
+    int     count = 0;
+
+    for (int i = 0; i < ctx->pid_count && count < len; i++) {
+        pids[count++] = ctx->pid_entries[i].info;
+    }
+
+    return count;
+}
+
+bool prf_get_pid_info(prf_ctx_t* ctx, pid_t pid, prf_pid_t* info) {
+    pid = (pid == 0) ? getpid() : pid;
+
+    for (int i = 0; i < ctx->pid_count; i++) {
+        if (ctx->pid_entries[i].info.pid == pid) {
+            *info = ctx->pid_entries[i].info;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool prf_read_file(const char* file_name, char** buffer, long* file_size) {
+    bool        status = false;
+    FILE*       fl;
+
+    fl = fopen(file_name, "rb");
+
+    if (fl && file_size) {
+        // get file size
+        if (*file_size == 0) {
+            fseek(fl, 0, SEEK_END);
+            *file_size = ftell(fl);
+            fseek(fl, 0, SEEK_SET);
+            (*file_size)++; // +1 for '\0'
+        }
+
+        if (*buffer == NULL) {
+            *buffer = (char*)malloc(*file_size);
+        }
+
+        if (*buffer) {
+            memset(*buffer, 0, *file_size);
+            fread(*buffer, 1, (*file_size -1), fl);
+            status = true;
+        } else {
+            fprintf(stderr, "** ERROR - memory error!");
+        }
+
+        fclose(fl);
+    } else {
+        fprintf(stderr, "** ERROR - unable to open file '%s'\n", file_name);
+    }
+
+    return status;
+}
+
+long prf_pread_file(int fd, char* buffer, long size) {
+    if (fd < 0 || buffer == NULL || size < 1) {
+        return -1;
+    }
+
+    return prf_pread_from(fd, buffer, size, 0, false);
+}
+
+bool prf_open_files(prf_ctx_t* ctx) {
+    bool    status = true;
+
+    for (int i = 0; i < PRF_FILE_COUNT; i++) {
+        if (!prf_open_proc_file(ctx, i)) {
+            status = false;
+        }
+    }
+
+    return status;
+}
+
+void prf_close_files(prf_ctx_t* ctx) {
+    // the registered table holds the descriptors of the files, the ring goes first
+    prf_uring_close(ctx);
+
+    for (int i = 0; i < PRF_FILE_COUNT; i++) {
+        if (ctx->file_fds[i] >= 0) {
+            close(ctx->file_fds[i]);
+            ctx->file_fds[i] = -1;
+        }
+    }
+
+    free(ctx->cpu_buff);
+    ctx->cpu_buff        = NULL;
+    ctx->cpu_buff_size   = 0;
+
+    free(ctx->net_buff);
+    ctx->net_buff        = NULL;
+    ctx->net_buff_size   = 0;
+
+    if (ctx->nl_fd >= 0) {
+        close(ctx->nl_fd);
+        ctx->nl_fd = -1;
+    }
+    free(ctx->nl_buff);
+    ctx->nl_buff         = NULL;
+    ctx->nl_buff_size    = 0;
+
+    free(ctx->disk_buff);
+    ctx->disk_buff       = NULL;
+    ctx->disk_buff_size  = 0;
+
+    free(ctx->vm_buff);
+    ctx->vm_buff         = NULL;
+    ctx->vm_buff_size    = 0;
+
+    free(ctx->softirq_buff);
+    ctx->softirq_buff       = NULL;
+    ctx->softirq_buff_size  = 0;
+
+    free(ctx->irq_buff);
+    ctx->irq_buff        = NULL;
+    ctx->irq_buff_size   = 0;
+
+    // the table stays readable, the processes are opened anew by the next read
+    for (int i = 0; i < ctx->pid_count; i++) {
+        prf_close_pid_entry(&ctx->pid_entries[i]);
+    }
+
+    // the cgroup is looked up again by the next read, the process may have been moved
+    for (int i = 0; i < PRF_CGROUP_FILE_COUNT; i++) {
+        if (ctx->cgroup_fds[i] >= 0) {
+            close(ctx->cgroup_fds[i]);
+            ctx->cgroup_fds[i] = -1;
+        }
+    }
+    if (ctx->cgroup_dir_fd >= 0) {
+        close(ctx->cgroup_dir_fd);
+        ctx->cgroup_dir_fd = -1;
+    }
+    ctx->cgroup_is_probed = false;
+}
+
+void prf_sleep_until(struct timespec* deadline, const struct timespec* interval) {
+    prf_advance_deadline(deadline, interval);
+
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, deadline, NULL) == EINTR) {
+        // interrupted by a signal handler, sleep the rest
+    }
+}
+
+void prf_get_read_times(prf_ctx_t* ctx, struct timespec t[4]) {
+    t[0] = ctx->file_stamps[PRF_FILE_LOAD_AVG];
+    t[1] = ctx->file_stamps[PRF_FILE_CPU_INFO];
+    t[2] = ctx->file_stamps[PRF_FILE_MEM_INFO];
+    t[3] = ctx->file_stamps[PRF_FILE_NET_INFO];
+}
+
+void prf_free_mem(void* mem) {
+    if (mem != NULL) {
+        free(mem);
+        mem = NULL;
+    }
+}
+
+bool prf_is_perf_thread_running(prf_ctx_t* ctx) {
+    return (ctx != NULL) && atomic_load(&ctx->is_running);
+}
+
+void prf_cancel_perf_thread(prf_ctx_t* ctx) {
+    uint64_t    one = 1;
+
+    if (ctx == NULL) {
+        return;
+    }
+
+    // async-signal-safe: a lock-free atomic store and a write()
+    atomic_store(&ctx->is_running, false);
+    if (ctx->wake_fd >= 0 && write(ctx->wake_fd, &one, sizeof(one)) < 0) {
+        // the counter is saturated, the collector is being woken up anyway
+    }
+}
+
+/*
+ * watches the comma separated PIDs of <list>, "self" for the calling process
+ */
+static void prf_set_pid_watch(prf_ctx_t* ctx, const char* list) {
+    char*   pids;
+    char*   rest_line   = NULL;
+
+    if (list == NULL || *list == '\0') {
+        return;
+    }
+
+    pids = strdup(list);
+    if (pids == NULL) {
+        fprintf(stderr, "** ERROR - memory error!");
+        return;
+    }
+
+    for (char* pid = strtok_r(pids, ",", &rest_line);
+        pid != NULL;
+        pid = strtok_r(NULL, ",", &rest_line)) {
+        if (strcmp(pid, PRF_PID_SELF) == 0) {
+            prf_watch_pid(ctx, 0);
+        } else if (strtol(pid, NULL, 10) > 0) {
+            prf_watch_pid(ctx, (pid_t)strtol(pid, NULL, 10));
+        } else {
+            fprintf(stderr, "** ERROR - invalid PID '%s'\n", pid);
+        }
+    }
+
+    free(pids);
+}
+
+prf_ctx_t* prf_ctx_create(const prf_perf_t* prf_perf) {
+    prf_ctx_t*      ctx;
+
+    if (prf_perf == NULL || prf_perf->sleep_req == NULL) {
+        fprintf(stderr, "** ERROR - missing collector configuration\n");
+        return NULL;
+    }
+
+    // the per-core and per-interface tables make it too large for the stack
+    ctx = (prf_ctx_t*)calloc(1, sizeof(prf_ctx_t));
+    if (ctx == NULL) {
+        fprintf(stderr, "** ERROR - memory error!");
+        return NULL;
+    }
+
+    for (int i = 0; i < PRF_FILE_COUNT; i++) {
+        ctx->file_fds[i] = -1;
+    }
+
+    ctx->cgroup_dir_fd = -1;
+    for (int i = 0; i < PRF_CGROUP_FILE_COUNT; i++) {
+        ctx->cgroup_fds[i] = -1;
+    }
+
+    ctx->root_fd = -1;
+    ctx->nl_fd   = -1;
+    ctx->shm_fd  = -1;
+    prf_uring_close(ctx);
+
+    pthread_mutex_init(&ctx->sub_lock, NULL);
+    pthread_mutex_init(&ctx->pid_lock, NULL);
+    pthread_mutex_init(&ctx->gate_lock, NULL);
+    for (int i = 0; i < PRF_SUB_MAX; i++) {
+        ctx->sub_fds[i] = -1;
+    }
+
+    ctx->wake_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (ctx->wake_fd < 0) {
+        fprintf(stderr, "** ERROR - unable to create an eventfd, prf_ctx_stop() waits for the end of the interval\n");
+    }
+
+    atomic_init(&ctx->is_running, true);
+    atomic_init(&ctx->snapshot_seq, 0);
+
+    // read args, strings are copied, the configuration may go out of scope
+    ctx->cfg_is_debug           = prf_perf->is_debug;
+    ctx->cfg_is_joinable        = prf_perf->is_joinable;
+    ctx->thread_name            = strdup((prf_perf->thread_name != NULL) ? prf_perf->thread_name : "prf_thread");
+    ctx->sleep_req              = *prf_perf->sleep_req;
+    ctx->interval_seconds       = (float)ctx->sleep_req.tv_sec + ((float)(ctx->sleep_req.tv_nsec) / 1000000000.0);
+    if (prf_perf->interval_min_s > 0.0) {
+        // the first interval is <sleep_req> within the bounds
+        ctx->cfg_interval_min   = prf_perf->interval_min_s;
+        ctx->cfg_interval_max   = (prf_perf->interval_max_s > 0.0) ? prf_perf->interval_max_s : ctx->interval_seconds;
+        ctx->cfg_interval_max   = (ctx->cfg_interval_max > ctx->cfg_interval_min) ? ctx->cfg_interval_max : ctx->cfg_interval_min;
+        prf_set_interval(ctx, (ctx->interval_seconds < ctx->cfg_interval_min) ? ctx->cfg_interval_min :
+                              (ctx->interval_seconds > ctx->cfg_interval_max) ? ctx->cfg_interval_max : ctx->interval_seconds);
+    }
+    ctx->cfg_cpu_name           = strdup((prf_perf->cpu_name != NULL) ? prf_perf->cpu_name : "cpu");
+    ctx->cfg_cpu_index          = prf_get_cpu_index(ctx->cfg_cpu_name);
+    ctx->cfg_cpu_load_type      = prf_perf->cpu_load_type;
+    ctx->cfg_load_ewma_s[0]     = (prf_perf->load_ewma_s[0] > 0.0) ? prf_perf->load_ewma_s[0] : PRF_LOAD_DEF_EWMA_1_S;
+    ctx->cfg_load_ewma_s[1]     = (prf_perf->load_ewma_s[1] > 0.0) ? prf_perf->load_ewma_s[1] : PRF_LOAD_DEF_EWMA_2_S;
+    ctx->cfg_load_ewma_s[2]     = (prf_perf->load_ewma_s[2] > 0.0) ? prf_perf->load_ewma_s[2] : PRF_LOAD_DEF_EWMA_3_S;
+    ctx->cfg_cpu_threshold      = prf_perf->cpu_threshold;
+    ctx->cfg_threshold_source   = prf_perf->threshold_source;
+    ctx->cfg_interface_name     = (prf_perf->interface_name != NULL) ? strdup(prf_perf->interface_name) : NULL;
+    ctx->net_itf_index          = -1;
+    prf_set_net_filters(ctx, prf_perf->interface_include, prf_perf->interface_exclude);
+    prf_set_disk_filters(ctx, prf_perf->disk_include,
+                         (prf_perf->disk_exclude != NULL) ? prf_perf->disk_exclude : PRF_DISK_DEF_EXCLUDE,
+                         prf_perf->disk_partitions);
+    ctx->cfg_pid_descendants    = prf_perf->pid_descendants;
+    ctx->cfg_disk_enabled       = prf_perf->disk_enabled;
+    ctx->cfg_vmstat_enabled     = prf_perf->vmstat_enabled;
+    ctx->cfg_irq_enabled        = prf_perf->irq_enabled;
+    ctx->pid_page_kb            = sysconf(_SC_PAGESIZE) / 1024;
+    ctx->pid_clk_tck            = sysconf(_SC_CLK_TCK);
+    prf_set_pid_watch(ctx, prf_perf->pid_watch);
+
+    if (!prf_alloc_history(ctx, prf_perf->history_len, prf_perf->history_ewma_s)) {
+        prf_ctx_destroy(ctx);
+        return NULL;
+    }
+
+    if (prf_perf->source_root != NULL && prf_perf->source_root[0] != '\0') {
+        ctx->root_fd = open(prf_perf->source_root, O_PATH | O_DIRECTORY | O_CLOEXEC);
+        if (ctx->root_fd < 0) {
+            fprintf(stderr, "** ERROR - unable to open source root '%s': %s\n", prf_perf->source_root, strerror(errno));
+            prf_ctx_destroy(ctx);
+            return NULL;
+        }
+    }
+
+    if (prf_perf->source != NULL) {
+        ctx->cfg_source = *prf_perf->source;
+    }
+
+    // captured fixtures and sources replace the text of the pseudo-files, they have no sysinfo() or rtnetlink counterpart
+    ctx->cfg_sys_backend = (ctx->root_fd < 0 && ctx->cfg_source.read == NULL) ? prf_perf->sys_backend : PRF_SYS_BACKEND_PROC;
+    ctx->cfg_net_backend = (ctx->root_fd < 0 && ctx->cfg_source.read == NULL) ? prf_perf->net_backend : PRF_NET_BACKEND_PROC;
+    // the files of a source root are read like those of /proc, a source replaces the reads
+    ctx->cfg_io_backend  = (ctx->cfg_source.read == NULL) ? prf_perf->io_backend : PRF_IO_BACKEND_PREAD;
+
+    if (prf_perf->shm_name != NULL && prf_perf->shm_name[0] != '\0') {
+        ctx->cfg_shm_name = strdup(prf_perf->shm_name);
+        if (!prf_shm_create(ctx)) {
+            prf_ctx_destroy(ctx);
+            return NULL;
+        }
+    }
+
+    if (prf_perf->record_file != NULL && prf_perf->record_file[0] != '\0' &&
+        !prf_rec_create(ctx, prf_perf->record_file, prf_perf->record_len)) {
+        prf_ctx_destroy(ctx);
+        return NULL;
+    }
+
+    return ctx;
+}
+
+bool prf_ctx_start(prf_ctx_t* ctx) {
+    uint64_t    count;
+
+    if (ctx == NULL || ctx->is_started || ctx->is_replay) {
+        return false;
+    }
+
+    // drop a wake-up left by a prf_cancel_perf_thread() without a running collector
+    if (ctx->wake_fd >= 0 && read(ctx->wake_fd, &count, sizeof(count)) < 0) {
+        // nothing pending
+    }
+
+    atomic_store(&ctx->is_running, true);
+
+    if (pthread_create(&ctx->thread, NULL, prf_perf_collect, ctx) != 0) {
+        fprintf(stderr, "** ERROR - performance thread creation failed\n");
+        return false;
+    }
+
+    ctx->is_started = true;
+
+    if (pthread_setname_np(ctx->thread, ctx->thread_name) != 0) {
+        fprintf(stderr, "** ERROR - performance thread could not be renamed to '%s'\n", ctx->thread_name);
+        prf_ctx_stop(ctx);
+        return false;
+    }
+
+    return true;
+}
+
+void prf_ctx_stop(prf_ctx_t* ctx) {
+    if (ctx == NULL || !ctx->is_started) {
+        return;
+    }
+
+    prf_cancel_perf_thread(ctx);
+    pthread_join(ctx->thread, NULL);
+    ctx->is_started = false;
+}
+
+void prf_ctx_destroy(prf_ctx_t* ctx) {
+    if (ctx == NULL) {
+        return;
+    }
+
+    prf_ctx_stop(ctx);
+    prf_close_files(ctx);
+
+    for (int i = 0; i < PRF_SUB_MAX; i++) {
+        prf_unsubscribe(ctx, i);
+    }
+    pthread_mutex_destroy(&ctx->sub_lock);
+    pthread_mutex_destroy(&ctx->pid_lock);
+
+    for (int i = 0; i < PRF_GATE_MAX; i++) {
+        prf_gate_destroy(ctx->gates[i]);
+    }
+    pthread_mutex_destroy(&ctx->gate_lock);
+
+    // only the publisher removes the segment, before it releases the lock to the next one
+    if (ctx->shm != NULL) {
+        shm_unlink(ctx->cfg_shm_name);
+        munmap(ctx->shm, sizeof(prf_shm_layout_t));
+        close(ctx->shm_fd);
+    }
+
+    if (ctx->rec != NULL) {
+        munmap(ctx->rec, ctx->rec_size);
+    }
+
+    if (ctx->wake_fd >= 0) {
+        close(ctx->wake_fd);
+    }
+
+    if (ctx->root_fd >= 0) {
+        close(ctx->root_fd);
+    }
+
+    prf_free_mem(ctx->thread_name);
+    prf_free_mem(ctx->cfg_cpu_name);
+    prf_free_mem(ctx->cfg_interface_name);
+    prf_free_mem(ctx->cfg_net_filter.patterns);
+    prf_free_mem(ctx->cfg_disk_filter.patterns);
+    prf_free_mem(ctx->cgroup_path);
+    prf_free_mem(ctx->cfg_shm_name);
+    prf_free_mem(ctx->hist_stamp);
+    prf_free_mem(ctx->hist_val);
+    prf_free_mem(ctx->hist_sum);
+    prf_free_mem(ctx->hist_min);
+    prf_free_mem(ctx->hist_max);
+    free(ctx);
+}
+
+prf_ctx_t* prf_replay_create(const prf_perf_t* prf_perf, const char* record_file) {
+    prf_perf_t                  perf;
+    prf_ctx_t*                  ctx;
+    prf_rec_header_t*           map;
+    struct stat                 st;
+    uint64_t                    count;
+    int                         fd;
+
+    if (prf_perf == NULL || record_file == NULL) {
+        fprintf(stderr, "** ERROR - missing replay configuration\n");
+        return NULL;
+    }
+
+    fd = open(record_file, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        fprintf(stderr, "** ERROR - unable to open recording '%s': %s\n", record_file, strerror(errno));
+        return NULL;
+    }
+
+    map = (fstat(fd, &st) == 0 && st.st_size >= (off_t)sizeof(prf_rec_header_t)) ?
+          mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0) : MAP_FAILED;
+    close(fd);
+    if (map == MAP_FAILED) {
+        fprintf(stderr, "** ERROR - unable to map recording '%s'\n", record_file);
+        return NULL;
+    }
+
+    if (map->magic != PRF_REC_MAGIC || map->version != PRF_REC_VERSION ||
+        map->header_size != sizeof(prf_rec_header_t) || map->record_size != sizeof(prf_rec_t) ||
+        map->metric_count != PRF_METRIC_COUNT || map->capacity == 0 ||
+        (size_t)st.st_size < sizeof(prf_rec_header_t) + (size_t)map->capacity * sizeof(prf_rec_t)) {
+        fprintf(stderr, "** ERROR - '%s' is not a recording of this library version\n", record_file);
+        munmap(map, st.st_size);
+        return NULL;
+    }
+
+    // a replay does not record itself
+    perf                = *prf_perf;
+    perf.record_file    = NULL;
+
+    ctx = prf_ctx_create(&perf);
+    if (ctx == NULL) {
+        munmap(map, st.st_size);
+        return NULL;
+    }
+
+    // the oldest record still in the ring
+    count               = atomic_load_explicit(&map->count, memory_order_acquire);
+    ctx->rec            = map;
+    ctx->rec_size       = st.st_size;
+    ctx->is_replay      = true;
+    ctx->replay_next    = (count > map->capacity) ? count - map->capacity : 0;
+    ctx->replay_end     = count;
+
+    return ctx;
+}
+
+bool prf_replay_step(prf_ctx_t* ctx) {
+    prf_snapshot_t      snap;
+    double              stamp;
+
+    if (ctx == NULL || !ctx->is_replay || ctx->replay_next >= ctx->replay_end) {
+        return false;
+    }
+
+    snap = prf_rec_get(ctx->rec, ctx->replay_next++)->snap;
+
+    // a recording continued after a reboot restarts its CLOCK_MONOTONIC stamps, the history needs them ascending
+    stamp = (double)snap.stamp.tv_sec + (double)snap.stamp.tv_nsec / 1000000000.0 + ctx->replay_offset;
+    if (ctx->replay_now > 0.0 && stamp < ctx->replay_now) {
+        ctx->replay_offset += ctx->replay_now - stamp + snap.interval;
+        stamp               = ctx->replay_now + snap.interval;
+    }
+    ctx->replay_now     = stamp;
+    snap.stamp.tv_sec   = (time_t)stamp;
+    snap.stamp.tv_nsec  = (long)((stamp - (double)snap.stamp.tv_sec) * 1000000000.0);
+
+    // the working state read by the getters of the threshold sources
+    memcpy(ctx->load_avg, snap.load_avg, sizeof(ctx->load_avg));
+    memcpy(ctx->load_ewma, snap.load_ewma, sizeof(ctx->load_ewma));
+    memcpy(ctx->cpu_pt, snap.cpu_pt, sizeof(ctx->cpu_pt));
+    memcpy(ctx->cpu_total_pt, snap.cpu_total_pt, sizeof(ctx->cpu_total_pt));
+    memcpy(ctx->psi, snap.psi, sizeof(ctx->psi));
+    ctx->cgroup                     = snap.cgroup;
+    ctx->mem[PRF_MEM_AVAILABLE]     = snap.mem_available;
+    ctx->interval_seconds           = snap.interval;
+
+    // re-evaluated with the configuration of the replay
+    snap.seq            = atomic_load_explicit(&ctx->snapshot_seq, memory_order_relaxed) / 2 + 1;
+    snap.threshold      = prf_get_current_threshold(ctx);
+    snap.is_overloaded  = (snap.threshold >= ctx->cfg_cpu_threshold);
+
+    prf_store_snapshot(ctx, &snap);
+
+    return true;
+}
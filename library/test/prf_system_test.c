@@ -0,0 +1,452 @@
+/*
+ * parser tests on the captured fixtures of a 512-CPU host with 200 interfaces, fixtures/host512:
+ * tick0 is a snapshot of /proc and /sys/block, tick1 the /proc files one second later,
+ * and of a 4-CPU host with cpu1 offline, fixtures/host4
+ *
+ * usage: prf-system-test <fixtures>
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <errno.h>
+
+#include "prf_system.h"
+
+#define PRF_TEST_CPU_COUNT      512
+#define PRF_TEST_ITF_COUNT      200
+#define PRF_TEST_IRQ_COLS       256     // PRF_IRQ_MAX_CPU, the columns of a wider host are left out
+#define PRF_TEST_IRQ_ROWS       16      // device rows of /proc/interrupts
+#define PRF_TEST_GAP_COUNT      4       // cpu0, cpu2 and cpu3 of fixtures/host4, cpu1 is offline
+
+// checks <cond>, a failure is reported and counted, the test goes on
+#define PRF_CHECK(cond) \
+    prf_check((cond), #cond, __FILE__, __LINE__)
+
+// checks that <value> is <expected> up to 0.1 %
+#define PRF_CHECK_NEAR(value, expected) \
+    prf_check(prf_is_near((value), (expected)), #value " == " #expected, __FILE__, __LINE__)
+
+// the /proc files of a tick, the reads of a prf_source_t
+typedef struct prf_test_seq {
+    const char*     dir;
+    int             tick;
+} prf_test_seq_t;
+
+static int          prf_failures    = 0;
+
+ssize_t __real_pread(int fd, void* buffer, size_t count, off_t offset);
+
+/*
+ * the fixtures are regular files, which come whole in one read, the reads of the record-based files are cut to a page
+ * like the ones of the seq_files of /proc, so a reader that stops at the first page is caught
+ */
+ssize_t __wrap_pread(int fd, void* buffer, size_t count, off_t offset) {
+    static const char*  seq_files[] = {"/proc/net/dev", "/proc/diskstats", "/proc/vmstat", "/proc/interrupts"};
+    size_t              page        = sysconf(_SC_PAGESIZE);
+    char                link[64];
+    char                path[512];
+    ssize_t             len;
+    size_t              n;
+
+    snprintf(link, sizeof(link), "/proc/self/fd/%d", fd);
+    len = readlink(link, path, sizeof(path) - 1);
+    path[(len < 0) ? 0 : len] = '\0';
+
+    for (size_t i = 0; i < sizeof(seq_files) / sizeof(seq_files[0]); i++) {
+        n = strlen(seq_files[i]);
+        if (len >= (ssize_t)n && strcmp(path + len - n, seq_files[i]) == 0 && count > page) {
+            count = page;
+        }
+    }
+
+    return __real_pread(fd, buffer, count, offset);
+}
+
+static void prf_check(bool cond, const char* text, const char* file, int line) {
+    if (!cond) {
+        fprintf(stderr, "** ERROR - %s:%d: check failed: %s\n", file, line, text);
+        prf_failures++;
+    }
+}
+
+static bool prf_is_near(double value, double expected) {
+    double  diff    = value - expected;
+    double  limit   = (expected < 0.0) ? -expected / 1000.0 : expected / 1000.0;
+
+    return (diff <= limit + 0.001 && -diff <= limit + 0.001);
+}
+
+/*
+ * reads the fixture <path> of tick <tick> of <dir> into the heap buffer <*buffer>
+ * returns the number of bytes read, -1 on error
+ */
+static long prf_test_load(const char* dir, int tick, const char* path, char** buffer) {
+    char    name[512];
+    long    size = 0;
+
+    snprintf(name, sizeof(name), "%s/tick%d%s", dir, tick, path);
+    *buffer = NULL;
+
+    if (!prf_read_file(name, buffer, &size)) {
+        return -1;
+    }
+
+    return size - 1;
+}
+
+/*
+ * prf_source_t reader of the files of the current tick of the sequence <arg>, a prf_test_seq_t*
+ */
+static long prf_test_seq_read(void* arg, const char* path, char* buffer, long size) {
+    prf_test_seq_t* seq = (prf_test_seq_t*)arg;
+    char            name[512];
+    long            total = 0;
+    ssize_t         len;
+    int             fd;
+
+    snprintf(name, sizeof(name), "%s/tick%d%s", seq->dir, seq->tick, path);
+    fd = open(name, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return -1;
+    }
+
+    do {
+        len = read(fd, buffer + total, size - 1 - total);
+        if (len > 0) {
+            total += len;
+        }
+    } while ((len > 0 && total < size - 1) || (len < 0 && errno == EINTR));
+
+    close(fd);
+
+    return (len < 0) ? -1 : total;
+}
+
+/*
+ * creates a context reading the files of the directory <root>, or of <source> with /sys/block in <root>
+ */
+static prf_ctx_t* prf_test_ctx_create(const char* root, const prf_source_t* source) {
+    static struct timespec  req = {1, 0};
+    prf_perf_t              perf;
+
+    memset(&perf, 0, sizeof(perf));
+    perf.sleep_req      = &req;
+    perf.cpu_name       = "cpu";
+    perf.cpu_threshold  = 1.0;
+    perf.interface_name = "eth0";
+    perf.source_root    = root;
+    perf.source         = source;
+
+    return prf_ctx_create(&perf);
+}
+
+/*
+ * the counters of tick0, read from /proc and /sys/block of the source root
+ */
+static void prf_test_source_root(const char* dir) {
+    char            root[512];
+    unsigned long   core_user[PRF_CPU_MAX_CORES];
+    unsigned long*  cores[8]    = {core_user};
+    unsigned long   c[8];
+    unsigned long   r[8];
+    unsigned long   t[8];
+    prf_net_itf_t   itfs[PRF_NET_MAX_ITF];
+    prf_net_itf_t   itf;
+    prf_net_itf_t   net_total;
+    prf_disk_t      disks[PRF_DISK_MAX_DEV];
+    prf_disk_t      disk;
+    prf_vmstat_t    vm;
+    prf_irq_dist_t  dist;
+    float           rates[PRF_TEST_CPU_COUNT];
+    int             cpus[PRF_TEST_CPU_COUNT];
+    struct timespec stamp;
+    char*           buffer;
+    long            len;
+    prf_ctx_t*      ctx;
+    int             tick;
+    int             n;
+
+    snprintf(root, sizeof(root), "%s/tick0", dir);
+    ctx = prf_test_ctx_create(root, NULL);
+    PRF_CHECK(ctx != NULL);
+    if (ctx == NULL) {
+        return;
+    }
+
+    // /proc/stat: the aggregate line and all 512 cores, read past the default buffer
+    PRF_CHECK(prf_read_cpu_info(ctx));
+    PRF_CHECK(prf_get_cpu_count(ctx) == PRF_TEST_CPU_COUNT);
+    prf_get_cpu_raw_info(ctx, c);
+    PRF_CHECK(c[0] == 100000UL * 512 + 37UL * (511 * 512 / 2));
+    PRF_CHECK(c[3] == 9000000UL * 512 + 101UL * (511 * 512 / 2));
+    n = prf_get_cpu_raw_all(ctx, cores, PRF_CPU_MAX_CORES);
+    PRF_CHECK(n == PRF_TEST_CPU_COUNT);
+    PRF_CHECK(core_user[0] == 100000 && core_user[511] == 100000 + 37 * 511);
+
+    // /proc/net/dev: 200 interfaces in the order of the file
+    PRF_CHECK(prf_read_net_info(ctx));
+    n = prf_get_net_itf_all(ctx, itfs, PRF_NET_MAX_ITF);
+    PRF_CHECK(n == PRF_TEST_ITF_COUNT);
+    PRF_CHECK(strcmp(itfs[0].name, "lo") == 0 && strcmp(itfs[n - 1].name, "veth00bd") == 0);
+    PRF_CHECK(itfs[n - 1].rx[0] == 1000000UL * 200 && itfs[n - 1].tx[1] == 20000UL * 200);
+    PRF_CHECK(prf_get_net_itf(ctx, "bond0", &itf) && itf.rx[0] == 10000000 && itf.rx[7] == 9 % 11);
+    prf_get_net_raw_info(ctx, r, t);
+    PRF_CHECK(r[0] == 2000000 && t[0] == 4000000);
+    prf_get_net_total(ctx, &net_total);
+    PRF_CHECK(net_total.rx[0] == 1000000UL * (200 * 201 / 2) && net_total.tx[0] == 2000000UL * (200 * 201 / 2));
+
+    // /proc/diskstats: the whole disks of /sys/block but loop0, no partitions
+    PRF_CHECK(prf_read_disk_info(ctx));
+    n = prf_get_disk_all(ctx, disks, PRF_DISK_MAX_DEV);
+    PRF_CHECK(n == 3);
+    PRF_CHECK(n == 3 && strcmp(disks[0].name, "sda") == 0 && strcmp(disks[1].name, "nvme0n1") == 0 &&
+              strcmp(disks[2].name, "dm-0") == 0);
+    PRF_CHECK(prf_get_disk(ctx, "sda1", &disk) && disk.stats[0] == 150000 && disk.stats[9] == 200000);
+
+    // /proc/vmstat: the zone counters summed, pgscan_direct_throttle is no zone of pgscan_direct
+    PRF_CHECK(prf_read_vmstat_info(ctx));
+    prf_get_vmstat_info(ctx, &vm);
+    PRF_CHECK(vm.value[PRF_VM_ALLOCSTALL] > 0 && vm.value[PRF_VM_ALLOCSTALL] < 1000);
+    PRF_CHECK(vm.value[PRF_VM_PGMAJFAULT] > 1000);
+
+    // /proc/interrupts and /proc/softirqs: 512 columns, of which the first 256 are kept
+    PRF_CHECK(prf_read_irq_info(ctx));
+    n = prf_get_irq_rates(ctx, rates, cpus, PRF_TEST_CPU_COUNT);
+    PRF_CHECK(n == PRF_TEST_IRQ_COLS && cpus[0] == 0 && cpus[n - 1] == PRF_TEST_IRQ_COLS - 1);
+    n = prf_get_softirq_rates(ctx, PRF_SOFTIRQ_NET_RX, rates, cpus, PRF_TEST_CPU_COUNT);
+    PRF_CHECK(n == PRF_TEST_IRQ_COLS);
+
+    // all device rows of 512 columns, 116 KB, are summed: tick1 a second later adds 1/s on every CPU, 101/s on CPU7
+    for (tick = 0; tick < 2; tick++) {
+        len = prf_test_load(dir, tick, "/proc/interrupts", &buffer);
+        PRF_CHECK(len > 0);
+        stamp.tv_sec  = 100 + tick;
+        stamp.tv_nsec = 0;
+        PRF_CHECK(prf_parse_irq_info(ctx, buffer, len, &stamp));
+        free(buffer);
+    }
+    prf_get_irq_dist(ctx, &dist);
+    PRF_CHECK_NEAR(dist.total_rate, (double)PRF_TEST_IRQ_ROWS * (PRF_TEST_IRQ_COLS + 100));
+    PRF_CHECK_NEAR(dist.max_rate, 101.0 * PRF_TEST_IRQ_ROWS);
+
+    prf_ctx_destroy(ctx);
+}
+
+/*
+ * the rates of tick0 to tick1, parsed with stamps one second apart
+ */
+static void prf_test_rates(const char* dir) {
+    static const char*  files[]     = {"/proc/stat", "/proc/net/dev", "/proc/diskstats", "/proc/vmstat",
+                                       "/proc/softirqs", "/proc/interrupts"};
+    char                root[512];
+    char*               buffers[2][6];
+    long                lens[2][6];
+    struct timespec     stamp;
+    float               p[8];
+    float               load;
+    prf_net_itf_t       itf;
+    prf_net_itf_t       net_total;
+    prf_disk_t          disk;
+    prf_disk_t          disk_total;
+    prf_vmstat_t        vm;
+    prf_irq_dist_t      dist;
+    prf_ctx_t*          ctx;
+
+    snprintf(root, sizeof(root), "%s/tick0", dir);
+    ctx = prf_test_ctx_create(root, NULL);
+    PRF_CHECK(ctx != NULL);
+    if (ctx == NULL) {
+        return;
+    }
+
+    for (int tick = 0; tick < 2; tick++) {
+        for (int i = 0; i < 6; i++) {
+            lens[tick][i] = prf_test_load(dir, tick, files[i], &buffers[tick][i]);
+            PRF_CHECK(lens[tick][i] > 0);
+        }
+    }
+
+    for (int tick = 0; tick < 2; tick++) {
+        stamp.tv_sec  = 100 + tick;
+        stamp.tv_nsec = 0;
+        PRF_CHECK(prf_parse_cpu_info(ctx, buffers[tick][0], lens[tick][0]));
+        PRF_CHECK(prf_parse_net_info(ctx, buffers[tick][1], lens[tick][1], &stamp));
+        PRF_CHECK(prf_parse_disk_info(ctx, buffers[tick][2], lens[tick][2], &stamp));
+        PRF_CHECK(prf_parse_vmstat_info(ctx, buffers[tick][3], lens[tick][3], &stamp));
+        PRF_CHECK(prf_parse_softirq_info(ctx, buffers[tick][4], lens[tick][4], &stamp));
+        PRF_CHECK(prf_parse_irq_info(ctx, buffers[tick][5], lens[tick][5], &stamp));
+    }
+
+    // 511 cores of 30 % user, 10 % system, 60 % idle, cpu300 90 % user
+    prf_get_cpu_pt_total(ctx, p);
+    PRF_CHECK_NEAR(p[0], 15420.0 * 100.0 / 51200.0);
+    PRF_CHECK_NEAR(p[1], 5110.0 * 100.0 / 51200.0);
+    PRF_CHECK_NEAR(p[3], 30670.0 * 100.0 / 51200.0);
+    PRF_CHECK(prf_get_cpu_busiest(ctx, &load) == 300);
+    PRF_CHECK_NEAR(load, 90.0);
+
+    // every interface +1000 Rx and +2000 Tx bytes/s, +10 Rx and +20 Tx packets/s
+    PRF_CHECK(prf_get_net_itf(ctx, "veth0042", &itf));
+    PRF_CHECK_NEAR(itf.rx_bytes_rate, 1000.0);
+    PRF_CHECK_NEAR(itf.tx_packets_rate, 20.0);
+    prf_get_net_total(ctx, &net_total);
+    PRF_CHECK_NEAR(net_total.rx_bytes_rate, 1000.0 * PRF_TEST_ITF_COUNT);
+    PRF_CHECK_NEAR(net_total.tx_bytes_rate, 2000.0 * PRF_TEST_ITF_COUNT);
+
+    // sda: 100 reads and 50 writes/s, 300 ms for 150 I/Os, 50 % busy; nvme0n1 900 reads/s more
+    PRF_CHECK(prf_get_disk(ctx, "sda", &disk));
+    PRF_CHECK_NEAR(disk.read_iops, 100.0);
+    PRF_CHECK_NEAR(disk.write_iops, 50.0);
+    PRF_CHECK_NEAR(disk.read_mbps, 2000.0 * 512.0 / 1000000.0);
+    PRF_CHECK_NEAR(disk.await_ms, 2.0);
+    PRF_CHECK_NEAR(disk.util, 50.0);
+    PRF_CHECK_NEAR(disk.queue_size, 1.0);
+    prf_get_disk_total(ctx, &disk_total);
+    PRF_CHECK_NEAR(disk_total.read_iops, 1200.0);
+    PRF_CHECK_NEAR(disk_total.write_iops, 150.0);
+
+    // +4 allocation stalls over the zones, not the 999 of pgscan_direct_throttle
+    prf_get_vmstat_info(ctx, &vm);
+    PRF_CHECK_NEAR(vm.rate[PRF_VM_PGMAJFAULT], 50.0);
+    PRF_CHECK_NEAR(vm.rate[PRF_VM_ALLOCSTALL], 4.0);
+    PRF_CHECK_NEAR(vm.rate[PRF_VM_PGSCAN_DIRECT], 0.0);
+    PRF_CHECK_NEAR(vm.rate[PRF_VM_PSWPOUT], 16.0);
+
+    // NET_RX: 10/s on every CPU, 510/s on CPU3
+    prf_get_softirq_dist(ctx, PRF_SOFTIRQ_NET_RX, &dist);
+    PRF_CHECK_NEAR(dist.total_rate, 10.0 * PRF_TEST_IRQ_COLS + 500.0);
+    PRF_CHECK(dist.max_cpu == 3);
+    PRF_CHECK_NEAR(dist.max_rate, 510.0);
+
+    // all device rows: 1/s on every CPU, 101/s on CPU7, the named rows like LOC are left out
+    prf_get_irq_dist(ctx, &dist);
+    PRF_CHECK_NEAR(dist.total_rate, (double)PRF_TEST_IRQ_ROWS * (PRF_TEST_IRQ_COLS + 100));
+    PRF_CHECK(dist.max_cpu == 7);
+    PRF_CHECK_NEAR(dist.max_rate, 101.0 * PRF_TEST_IRQ_ROWS);
+    PRF_CHECK_NEAR(dist.imbalance, 101.0 * PRF_TEST_IRQ_COLS / (PRF_TEST_IRQ_COLS + 100));
+
+    for (int tick = 0; tick < 2; tick++) {
+        for (int i = 0; i < 6; i++) {
+            free(buffers[tick][i]);
+        }
+    }
+
+    prf_ctx_destroy(ctx);
+}
+
+/*
+ * the sequence tick0, tick1 fed by a prf_source_t, the rates over the measured time between the reads
+ */
+static void prf_test_source_seq(const char* dir) {
+    char            root[512];
+    prf_test_seq_t  seq         = {dir, 0};
+    prf_source_t    source      = {prf_test_seq_read, &seq};
+    float           p[8];
+    float           load;
+    prf_irq_dist_t  dist;
+    prf_disk_t      disk_total;
+    prf_ctx_t*      ctx;
+
+    // /sys/block of the source root, the /proc files of the source
+    snprintf(root, sizeof(root), "%s/tick0", dir);
+    ctx = prf_test_ctx_create(root, &source);
+    PRF_CHECK(ctx != NULL);
+    if (ctx == NULL) {
+        return;
+    }
+
+    for (; seq.tick < 2; seq.tick++) {
+        PRF_CHECK(prf_read_cpu_info(ctx));
+        PRF_CHECK(prf_read_net_info(ctx));
+        PRF_CHECK(prf_read_disk_info(ctx));
+        PRF_CHECK(prf_read_vmstat_info(ctx));
+        PRF_CHECK(prf_read_irq_info(ctx));
+    }
+
+    PRF_CHECK(prf_get_cpu_count(ctx) == PRF_TEST_CPU_COUNT);
+    prf_get_cpu_pt_info(ctx, p);
+    PRF_CHECK_NEAR(p[3], 30670.0 * 100.0 / 51200.0);
+    PRF_CHECK(prf_get_cpu_busiest(ctx, &load) == 300);
+
+    // the shares do not depend on the time between the reads
+    prf_get_irq_dist(ctx, &dist);
+    PRF_CHECK(dist.max_cpu == 7);
+    PRF_CHECK_NEAR(dist.imbalance, 101.0 * PRF_TEST_IRQ_COLS / (PRF_TEST_IRQ_COLS + 100));
+    prf_get_disk_total(ctx, &disk_total);
+    PRF_CHECK(disk_total.read_iops > 0.0);
+    PRF_CHECK_NEAR(disk_total.write_iops / disk_total.read_iops, 150.0 / 1200.0);
+
+    prf_ctx_destroy(ctx);
+}
+
+/*
+ * the /proc/stat of a host with an offline core in the middle, which has no "cpuN" line
+ */
+static void prf_test_cpu_offline(const char* dir) {
+    char            root[512];
+    char*           buffers[2];
+    long            lens[2];
+    float           core_idle[PRF_TEST_GAP_COUNT];
+    float*          p[8]        = {NULL, NULL, NULL, core_idle};
+    unsigned long   core_user[PRF_TEST_GAP_COUNT];
+    unsigned long*  c[8]        = {core_user};
+    float           load;
+    prf_ctx_t*      ctx;
+
+    snprintf(root, sizeof(root), "%s/tick0", dir);
+    ctx = prf_test_ctx_create(root, NULL);
+    PRF_CHECK(ctx != NULL);
+    if (ctx == NULL) {
+        return;
+    }
+
+    for (int tick = 0; tick < 2; tick++) {
+        lens[tick] = prf_test_load(dir, tick, "/proc/stat", &buffers[tick]);
+        PRF_CHECK(lens[tick] > 0);
+        PRF_CHECK(prf_parse_cpu_info(ctx, buffers[tick], lens[tick]));
+    }
+
+    PRF_CHECK(prf_get_cpu_count(ctx) == PRF_TEST_GAP_COUNT);
+    PRF_CHECK(prf_get_cpu_online(ctx) == PRF_TEST_GAP_COUNT - 1);
+    PRF_CHECK(!prf_is_cpu_online(ctx, 1) && prf_is_cpu_online(ctx, 2));
+
+    // cpu0 and cpu3 10 % busy, cpu2 20 %, the offline cpu1 is neither busiest nor 100 % busy
+    PRF_CHECK(prf_get_cpu_busiest(ctx, &load) == 2);
+    PRF_CHECK_NEAR(load, 20.0);
+    PRF_CHECK(prf_get_cpu_pt_all(ctx, p, PRF_TEST_GAP_COUNT) == PRF_TEST_GAP_COUNT);
+    PRF_CHECK_NEAR(core_idle[0], 90.0);
+    PRF_CHECK(core_idle[1] == 0.0);
+    PRF_CHECK_NEAR(core_idle[2], 80.0);
+    PRF_CHECK(prf_get_cpu_raw_all(ctx, c, PRF_TEST_GAP_COUNT) == PRF_TEST_GAP_COUNT);
+    PRF_CHECK(core_user[1] == 0 && core_user[3] == 100005);
+
+    free(buffers[0]);
+    free(buffers[1]);
+    prf_ctx_destroy(ctx);
+}
+
+int main(int argc, char* argv[]) {
+    char    dir[512];
+
+    if (argc != 2) {
+        fprintf(stderr, "usage: %s <fixtures>\n", argv[0]);
+        return 2;
+    }
+
+    snprintf(dir, sizeof(dir), "%s/host512", argv[1]);
+    prf_test_source_root(dir);
+    prf_test_rates(dir);
+    prf_test_source_seq(dir);
+    snprintf(dir, sizeof(dir), "%s/host4", argv[1]);
+    prf_test_cpu_offline(dir);
+
+    if (prf_failures > 0) {
+        fprintf(stderr, "%d check(s) failed\n", prf_failures);
+        return 1;
+    }
+
+    printf("all checks passed\n");
+
+    return 0;
+}